@@ -0,0 +1,418 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmarkResults.h"
+#include "benchmarkSubjects.h"
+#include "channelBenchmark.h"
+#include "hashMapBenchmark.h"
+#include "internBenchmark.h"
+#include "objectCacheBenchmark.h"
+#include "overheadReport.h"
+#include "taskBenchmark.h"
+
+// Runs identical fixed-size workloads against BlockAllocator, the std::pmr resources and malloc.
+// Every thread repeatedly allocates a batch of blocks, touches them and frees them in a selected order.
+// Shared subjects serve all threads from one instance, the unsynchronized ones get an instance per thread.
+
+typedef std::chrono::steady_clock Clock;
+
+// Every latencySamplingMask + 1 operation is timed individually, timing all of them would distort the throughput.
+static const size_t latencySamplingMask = 15;
+
+struct ThreadSamples
+{
+	std::vector<uint32_t> allocate;
+	std::vector<uint32_t> deallocate;
+};
+
+static long readStatusKb(const char* field)
+{
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	size_t length = strlen(field);
+
+	while (std::getline(status, line))
+	{
+		if (line.compare(0, length, field) == 0)
+			return atol(line.c_str() + length);
+	}
+	return -1;
+}
+
+// Resets VmHWM so the peak RSS of every run is reported separately.
+static void resetPeakRss()
+{
+	std::ofstream clearRefs("/proc/self/clear_refs");
+	clearRefs << "5";
+}
+
+static std::vector<size_t> makeFreeOrder(FreeOrder order, size_t batch, unsigned seed)
+{
+	std::vector<size_t> indices(batch);
+
+	for (size_t i = 0; i < batch; i++)
+	{
+		indices[i] = i;
+	}
+
+	if (order == Lifo)
+		std::reverse(indices.begin(), indices.end());
+	else if (order == Random)
+		std::shuffle(indices.begin(), indices.end(), std::mt19937(seed));
+
+	return indices;
+}
+
+static uint32_t elapsedNs(Clock::time_point start)
+{
+	return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+static void runWorkload(Subject& subject, const Options& options, const std::vector<size_t>& freeOrder, ThreadSamples& samples)
+{
+	std::vector<void*> blocks(options.batch);
+
+	for (size_t round = 0; round < options.rounds; round++)
+	{
+		for (size_t i = 0; i < options.batch; i++)
+		{
+			if ((i & latencySamplingMask) == 0)
+			{
+				Clock::time_point start = Clock::now();
+				blocks[i] = subject.allocate();
+				samples.allocate.push_back(elapsedNs(start));
+			}
+			else
+			{
+				blocks[i] = subject.allocate();
+			}
+			*(volatile char*)blocks[i] = (char)i;
+		}
+
+		for (size_t i = 0; i < options.batch; i++)
+		{
+			void* block = blocks[freeOrder[i]];
+
+			if ((i & latencySamplingMask) == 0)
+			{
+				Clock::time_point start = Clock::now();
+				subject.deallocate(block);
+				samples.deallocate.push_back(elapsedNs(start));
+			}
+			else
+			{
+				subject.deallocate(block);
+			}
+		}
+	}
+}
+
+// Fills p50, p99 and p99.9 of the samples.
+static void percentiles(std::vector<uint32_t>& samples, double* out)
+{
+	static const double ranks[3] = {0.5, 0.99, 0.999};
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (samples.empty())
+		{
+			out[i] = 0;
+			continue;
+		}
+		std::vector<uint32_t>::iterator nth = samples.begin() + (size_t)(ranks[i] * (samples.size() - 1));
+		std::nth_element(samples.begin(), nth, samples.end());
+		out[i] = *nth;
+	}
+}
+
+static Result runBenchmark(const SubjectKind& kind, size_t numOfThreads, FreeOrder order, const Options& options)
+{
+	resetPeakRss();
+
+	std::vector<std::unique_ptr<Subject>> subjects;
+	size_t instances = kind.shared ? 1 : numOfThreads;
+	size_t maxBlocks = kind.shared ? options.batch * numOfThreads : options.batch;
+
+	for (size_t i = 0; i < instances; i++)
+	{
+		subjects.push_back(kind.create(options.blockSize, maxBlocks));
+	}
+
+	// Counters inherit into threads created after they are opened.
+	std::unique_ptr<PerfCounters> counters;
+	if (options.perf)
+		counters.reset(new PerfCounters());
+
+	std::vector<ThreadSamples> samples(numOfThreads);
+	std::vector<std::thread> threads;
+	std::atomic<size_t> ready(0);
+	std::atomic<bool> go(false);
+
+	for (size_t t = 0; t < numOfThreads; t++)
+	{
+		threads.emplace_back([&, t]()
+		{
+			Subject& subject = *subjects[kind.shared ? 0 : t];
+			subject.attach();
+			std::vector<size_t> freeOrder = makeFreeOrder(order, options.batch, (unsigned)t + 1);
+			samples[t].allocate.reserve(options.rounds * options.batch / (latencySamplingMask + 1) + 1);
+			samples[t].deallocate.reserve(options.rounds * options.batch / (latencySamplingMask + 1) + 1);
+
+			++ready;
+			while (!go.load())
+			{
+			}
+			runWorkload(subject, options, freeOrder, samples[t]);
+		});
+	}
+
+	while (ready.load() != numOfThreads)
+	{
+	}
+	if (counters)
+		counters->start();
+	Clock::time_point start = Clock::now();
+	go.store(true);
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	if (counters)
+		counters->stop();
+
+	Result result;
+	result.subject = kind.name;
+	result.threads = numOfThreads;
+	result.order = order;
+	double operations = 2.0 * options.batch * options.rounds * numOfThreads;
+	result.opsPerSecond = operations / seconds;
+
+	for (int i = 0; i < PerfCounters::NumOfEvents; i++)
+	{
+		result.perOperation[i] = counters ? counters->perOperation((PerfCounters::Event)i, operations)
+				: std::numeric_limits<double>::quiet_NaN();
+	}
+	result.rssKb = readStatusKb("VmRSS:");
+	result.peakRssKb = readStatusKb("VmHWM:");
+
+	std::vector<uint32_t> allocate;
+	std::vector<uint32_t> deallocate;
+	for (ThreadSamples& threadSamples : samples)
+	{
+		allocate.insert(allocate.end(), threadSamples.allocate.begin(), threadSamples.allocate.end());
+		deallocate.insert(deallocate.end(), threadSamples.deallocate.begin(), threadSamples.deallocate.end());
+	}
+	percentiles(allocate, result.allocateNs);
+	percentiles(deallocate, result.deallocateNs);
+
+	return result;
+}
+
+static std::vector<size_t> parseList(const char* text)
+{
+	std::vector<size_t> values;
+
+	for (const char* item = text; *item != '\0';)
+	{
+		char* end;
+		values.push_back(strtoul(item, &end, 10));
+		item = *end == ',' ? end + 1 : end;
+		if (end == item)
+			break;
+	}
+	return values;
+}
+
+static void printResult(const Result& r, const Options& options)
+{
+	printf("%-26s %7zu %6s %12.2f %9.0f/%8.0f/%8.0f %9.0f/%8.0f/%8.0f %9ld %9ld", r.subject.c_str(), r.threads,
+			freeOrderName(r.order), r.opsPerSecond / 1e6,
+			r.allocateNs[0], r.allocateNs[1], r.allocateNs[2],
+			r.deallocateNs[0], r.deallocateNs[1], r.deallocateNs[2], r.rssKb, r.peakRssKb);
+	// Counters not permitted individually are printed as nan.
+	for (int i = 0; options.perf && i < PerfCounters::NumOfEvents; i++)
+	{
+		printf(" %12.3f", r.perOperation[i]);
+	}
+	printf("\n");
+}
+
+static void printUsage(const char* program)
+{
+	printf("Usage: %s [--block-size BYTES] [--batch BLOCKS] [--rounds N] [--threads N[,N...]] [--perf]\n"
+			"       [--repeat N] [--json FILE]\n"
+			"       %s --overhead [--batch BLOCKS] [--block-sizes BYTES[,BYTES...]]\n"
+			"       %s --hash-map [--batch KEYS] [--rounds N] [--threads N[,N...]]\n"
+			"       %s --channel [--block-size BYTES] [--batch BLOCKS] [--rounds N] [--threads PRODUCERS[,PRODUCERS...]]\n"
+			"       %s --tasks [--batch TASKS] [--rounds N] [--threads WORKERS[,WORKERS...]]\n"
+			"       %s --object-cache [--block-size FIELD_BYTES] [--batch OBJECTS] [--rounds N]\n"
+			"       %s --intern [--block-size PAYLOAD_BYTES] [--batch PAYLOADS] [--rounds N]\n",
+			program, program, program, program, program, program, program);
+}
+
+static bool parseOptions(int argc, char** argv, Options& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+		if (arg == "--perf")
+		{
+			options.perf = true;
+			continue;
+		}
+		if (arg == "--overhead")
+		{
+			options.overhead = true;
+			continue;
+		}
+		if (arg == "--hash-map")
+		{
+			options.hashMap = true;
+			continue;
+		}
+		if (arg == "--channel")
+		{
+			options.channel = true;
+			continue;
+		}
+		if (arg == "--tasks")
+		{
+			options.tasks = true;
+			continue;
+		}
+		if (arg == "--object-cache")
+		{
+			options.objectCache = true;
+			continue;
+		}
+		if (arg == "--intern")
+		{
+			options.intern = true;
+			continue;
+		}
+
+		if (value == NULL)
+			return false;
+
+		if (arg == "--block-size")
+			options.blockSize = strtoul(value, NULL, 10);
+		else if (arg == "--batch")
+			options.batch = strtoul(value, NULL, 10);
+		else if (arg == "--rounds")
+			options.rounds = strtoul(value, NULL, 10);
+		else if (arg == "--threads")
+			options.threads = parseList(value);
+		else if (arg == "--repeat")
+			options.repeat = strtoul(value, NULL, 10);
+		else if (arg == "--json")
+			options.jsonPath = value;
+		else if (arg == "--block-sizes")
+			options.blockSizes = parseList(value);
+		else
+			return false;
+		++i;
+	}
+	return options.blockSize != 0 && options.batch != 0 && options.rounds != 0 && options.repeat != 0 && !options.threads.empty();
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+
+	if (!parseOptions(argc, argv, options))
+	{
+		printUsage(argv[0]);
+		return 2;
+	}
+
+	if (options.overhead)
+	{
+		printOverheadReport(options.blockSizes, options.batch);
+		return 0;
+	}
+
+	if (options.hashMap)
+	{
+		printHashMapReport(options);
+		return 0;
+	}
+
+	if (options.channel)
+	{
+		printChannelReport(options);
+		return 0;
+	}
+
+	if (options.tasks)
+	{
+		printTaskReport(options);
+		return 0;
+	}
+
+	if (options.objectCache)
+	{
+		printObjectCacheReport(options);
+		return 0;
+	}
+
+	if (options.intern)
+	{
+		printInternReport(options);
+		return 0;
+	}
+
+	if (options.perf && !PerfCounters().isAnyAvailable())
+	{
+		printf("Hardware counters aren't permitted in this environment (see perf_event_paranoid), reporting without them.\n");
+		options.perf = false;
+	}
+
+	printf("block size %zu, batch %zu, rounds %zu, repeat %zu\n\n", options.blockSize, options.batch, options.rounds, options.repeat);
+	printf("%-26s %7s %6s %12s %27s %27s %9s %9s", "subject", "threads", "order", "Mops/s",
+			"alloc p50/p99/p99.9 ns", "free p50/p99/p99.9 ns", "rss KB", "peak KB");
+	for (int i = 0; options.perf && i < PerfCounters::NumOfEvents; i++)
+	{
+		printf(" %9s/op", PerfCounters::name((PerfCounters::Event)i));
+	}
+	printf("\n");
+
+	const FreeOrder orders[] = {Lifo, Fifo, Random};
+	std::vector<std::vector<Result>> runs(options.repeat);
+
+	// Repeats run the whole suite again rather than each case back to back, so a slow drift of the machine spreads over all cases.
+	for (std::vector<Result>& results : runs)
+	{
+		for (size_t numOfThreads : options.threads)
+		{
+			for (FreeOrder order : orders)
+			{
+				for (const SubjectKind& kind : allSubjects())
+				{
+					results.push_back(runBenchmark(kind, numOfThreads, order, options));
+					printResult(results.back(), options);
+				}
+			}
+		}
+	}
+
+	if (!options.jsonPath.empty() && !writeResultsJson(options.jsonPath, options, runs))
+	{
+		printf("Can't write %s\n", options.jsonPath.c_str());
+		return 1;
+	}
+	return 0;
+}
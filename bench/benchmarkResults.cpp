@@ -0,0 +1,132 @@
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <sys/utsname.h>
+
+#include "benchmarkResults.h"
+
+#ifndef BENCH_CXX_FLAGS
+#define BENCH_CXX_FLAGS "unknown"
+#endif
+
+#if defined(__clang__)
+#define BENCH_COMPILER "clang " __VERSION__
+#elif defined(__GNUC__)
+#define BENCH_COMPILER "GCC " __VERSION__
+#else
+#define BENCH_COMPILER "unknown"
+#endif
+
+const char* freeOrderName(FreeOrder order)
+{
+	switch (order)
+	{
+	case Lifo:
+		return "lifo";
+	case Fifo:
+		return "fifo";
+	default:
+		return "random";
+	}
+}
+
+static std::string quoted(const std::string& text)
+{
+	std::string result = "\"";
+
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\')
+			result += '\\';
+		if ((unsigned char)c >= 0x20)
+			result += c;
+	}
+	return result + "\"";
+}
+
+static std::string cpuModel()
+{
+	std::ifstream cpuInfo("/proc/cpuinfo");
+	std::string line;
+
+	while (std::getline(cpuInfo, line))
+	{
+		if (line.compare(0, 10, "model name") == 0)
+			return line.substr(line.find(':') + 2);
+	}
+	return "unknown";
+}
+
+static std::string kernelRelease()
+{
+	utsname name;
+
+	if (uname(&name) != 0)
+		return "unknown";
+	return std::string(name.sysname) + " " + name.release;
+}
+
+// Writes one metric of a case as an array holding a sample per repeat, unavailable samples become null.
+template <typename Metric>
+static void writeSamples(FILE* out, const char* name, const std::vector<std::vector<Result>>& runs, size_t index, Metric metric)
+{
+	fprintf(out, ",\n      \"%s\": [", name);
+	for (size_t repeat = 0; repeat < runs.size(); repeat++)
+	{
+		double value = metric(runs[repeat][index]);
+
+		fprintf(out, repeat == 0 ? "" : ", ");
+		if (std::isnan(value))
+			fprintf(out, "null");
+		else
+			fprintf(out, "%.6g", value);
+	}
+	fprintf(out, "]");
+}
+
+bool writeResultsJson(const std::string& path, const Options& options, const std::vector<std::vector<Result>>& runs)
+{
+	FILE* out = fopen(path.c_str(), "w");
+	if (out == NULL)
+		return false;
+
+	fprintf(out, "{\n  \"environment\": {\n");
+	fprintf(out, "    \"cpu\": %s,\n", quoted(cpuModel()).c_str());
+	fprintf(out, "    \"hardwareThreads\": %u,\n", std::thread::hardware_concurrency());
+	fprintf(out, "    \"kernel\": %s,\n", quoted(kernelRelease()).c_str());
+	fprintf(out, "    \"compiler\": %s,\n", quoted(BENCH_COMPILER).c_str());
+	fprintf(out, "    \"flags\": %s\n  },\n", quoted(BENCH_CXX_FLAGS).c_str());
+
+	fprintf(out, "  \"config\": {\"blockSize\": %zu, \"batch\": %zu, \"rounds\": %zu, \"repeat\": %zu},\n",
+			options.blockSize, options.batch, options.rounds, runs.size());
+
+	fprintf(out, "  \"results\": [");
+	size_t cases = runs.empty() ? 0 : runs[0].size();
+	for (size_t i = 0; i < cases; i++)
+	{
+		const Result& first = runs[0][i];
+
+		fprintf(out, "%s\n    {\"subject\": %s, \"threads\": %zu, \"order\": \"%s\"", i == 0 ? "" : ",",
+				quoted(first.subject).c_str(), first.threads, freeOrderName(first.order));
+
+		writeSamples(out, "opsPerSecond", runs, i, [](const Result& r) { return r.opsPerSecond; });
+		writeSamples(out, "allocateP50Ns", runs, i, [](const Result& r) { return r.allocateNs[0]; });
+		writeSamples(out, "allocateP99Ns", runs, i, [](const Result& r) { return r.allocateNs[1]; });
+		writeSamples(out, "allocateP999Ns", runs, i, [](const Result& r) { return r.allocateNs[2]; });
+		writeSamples(out, "deallocateP50Ns", runs, i, [](const Result& r) { return r.deallocateNs[0]; });
+		writeSamples(out, "deallocateP99Ns", runs, i, [](const Result& r) { return r.deallocateNs[1]; });
+		writeSamples(out, "deallocateP999Ns", runs, i, [](const Result& r) { return r.deallocateNs[2]; });
+		writeSamples(out, "peakRssKb", runs, i, [](const Result& r) { return (double)r.peakRssKb; });
+
+		for (int event = 0; options.perf && event < PerfCounters::NumOfEvents; event++)
+		{
+			std::string name = std::string(PerfCounters::name((PerfCounters::Event)event)) + "PerOp";
+			writeSamples(out, name.c_str(), runs, i, [event](const Result& r) { return r.perOperation[event]; });
+		}
+		fprintf(out, "}");
+	}
+	fprintf(out, "\n  ]\n}\n");
+
+	return fclose(out) == 0;
+}
@@ -0,0 +1,65 @@
+#ifndef _BENCHMARK_RESULTS_H
+#define _BENCHMARK_RESULTS_H
+
+#include <string>
+#include <vector>
+
+#include "perfCounters.h"
+
+//! \brief The order a batch of blocks is freed in.
+enum FreeOrder
+{
+	Lifo,
+	Fifo,
+	Random
+};
+
+//! \brief Returns the free order name used in reports.
+const char* freeOrderName(FreeOrder order);
+
+//! \brief Benchmark configuration, set from the command line.
+struct Options
+{
+	size_t blockSize = 64;
+	size_t batch = 4096;
+	size_t rounds = 200;
+	size_t repeat = 1;
+	std::vector<size_t> threads = {1, 4};
+	bool perf = false;
+	std::string jsonPath;
+	bool overhead = false;
+	bool hashMap = false;
+	bool channel = false;
+	bool tasks = false;
+	bool objectCache = false;
+	bool intern = false;
+	std::vector<size_t> blockSizes = {4, 8, 16, 24, 32, 64, 128, 256, 4096, 65536};
+};
+
+//! \brief The result of one benchmark run.
+struct Result
+{
+	std::string subject;
+	size_t threads;
+	FreeOrder order;
+	double opsPerSecond;
+	//! p50, p99 and p99.9 in nanoseconds.
+	double allocateNs[3];
+	//! p50, p99 and p99.9 in nanoseconds.
+	double deallocateNs[3];
+	long rssKb;
+	long peakRssKb;
+	//! NaN if the counter isn't available.
+	double perOperation[PerfCounters::NumOfEvents];
+};
+
+//! \brief Writes the results of all repeats with the environment metadata as JSON.
+
+//! Runs of the same case are merged into one entry holding a sample per repeat, so the comparator can estimate the variance.
+//! \param[in] path The output file.
+//! \param[in] options The benchmark configuration.
+//! \param[in] runs Results indexed by repeat and then by case, every repeat runs the cases in the same order.
+//! \return Returns false if the file can't be written.
+bool writeResultsJson(const std::string& path, const Options& options, const std::vector<std::vector<Result>>& runs);
+
+#endif
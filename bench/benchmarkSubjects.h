@@ -0,0 +1,149 @@
+#ifndef _BENCHMARK_SUBJECTS_H
+#define _BENCHMARK_SUBJECTS_H
+
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/blockAllocator.h"
+
+//! \brief Common interface of the allocators under benchmark, every subject serves blocks of one fixed size.
+class Subject
+{
+public:
+	//! \brief Virtual destructor for inheritance purposes.
+	virtual ~Subject() = default;
+
+	//! \brief Returns a block.
+	virtual void* allocate() = 0;
+
+	//! \brief Returns a block to the subject.
+	virtual void deallocate(void* block) = 0;
+
+	//! \brief Called by every benchmark thread before it uses the subject.
+	virtual void attach()
+	{}
+};
+
+//! \brief Describes an allocator under benchmark.
+struct SubjectKind
+{
+	//! \brief The name printed in the report.
+	std::string name;
+
+	//! \brief True if one instance is shared by all threads, otherwise every thread gets its own instance.
+	bool shared;
+
+	//! \brief Creates an instance serving blockSize blocks, at most maxBlocks of them live at once.
+	std::unique_ptr<Subject> (*create)(size_t blockSize, size_t maxBlocks);
+};
+
+//! \brief The BlockAllocator subject.
+class BlockAllocatorSubject : public Subject
+{
+public:
+	BlockAllocatorSubject(size_t blockSize, size_t maxBlocks, const BlockAllocator::Config& config = BlockAllocator::Config()) :
+		allocator(blockSize, maxBlocks, config)
+	{
+		// A biased allocator is claimed by the benchmark thread using it.
+		allocator.transferOwnership(std::thread::id());
+	}
+
+	void attach() override
+	{
+		allocator.claimOwnership();
+	}
+
+	void* allocate() override
+	{
+		return allocator.allocate();
+	}
+
+	void deallocate(void* block) override
+	{
+		allocator.deallocate(block);
+	}
+
+private:
+	BlockAllocator allocator;
+};
+
+//! \brief A subject serving fixed-size blocks from a std::pmr::memory_resource.
+template <typename Resource>
+class PmrSubject : public Subject
+{
+public:
+	explicit PmrSubject(size_t blockSize) :
+		size(blockSize)
+	{}
+
+	void* allocate() override
+	{
+		return resource.allocate(size);
+	}
+
+	void deallocate(void* block) override
+	{
+		resource.deallocate(block, size);
+	}
+
+private:
+	size_t size;
+	Resource resource;
+};
+
+//! \brief The glibc malloc subject, small sizes are served by the per-thread tcache.
+class MallocSubject : public Subject
+{
+public:
+	explicit MallocSubject(size_t blockSize) :
+		size(blockSize)
+	{}
+
+	void* allocate() override
+	{
+		return std::malloc(size);
+	}
+
+	void deallocate(void* block) override
+	{
+		std::free(block);
+	}
+
+private:
+	size_t size;
+};
+
+//! \brief Returns a BlockAllocator configuration with the selected free list engine.
+inline BlockAllocator::Config freeListConfig(BlockAllocator::FreeListType freeList)
+{
+	BlockAllocator::Config config;
+	config.freeList = freeList;
+	return config;
+}
+
+//! \brief Returns all subjects in report order.
+inline std::vector<SubjectKind> allSubjects()
+{
+	return {
+		{"BlockAllocator", true, [](size_t blockSize, size_t maxBlocks) -> std::unique_ptr<Subject>
+			{ return std::unique_ptr<Subject>(new BlockAllocatorSubject(blockSize, maxBlocks)); }},
+		{"BlockAllocator ring", true, [](size_t blockSize, size_t maxBlocks) -> std::unique_ptr<Subject>
+			{ return std::unique_ptr<Subject>(new BlockAllocatorSubject(blockSize, maxBlocks, freeListConfig(BlockAllocator::RingFreeList))); }},
+		{"BlockAllocator biased", false, [](size_t blockSize, size_t maxBlocks) -> std::unique_ptr<Subject>
+			{ return std::unique_ptr<Subject>(new BlockAllocatorSubject(blockSize, maxBlocks, freeListConfig(BlockAllocator::BiasedFreeList))); }},
+		{"pmr::unsynchronized_pool", false, [](size_t blockSize, size_t) -> std::unique_ptr<Subject>
+			{ return std::unique_ptr<Subject>(new PmrSubject<std::pmr::unsynchronized_pool_resource>(blockSize)); }},
+		{"pmr::synchronized_pool", true, [](size_t blockSize, size_t) -> std::unique_ptr<Subject>
+			{ return std::unique_ptr<Subject>(new PmrSubject<std::pmr::synchronized_pool_resource>(blockSize)); }},
+		{"pmr::monotonic_buffer", false, [](size_t blockSize, size_t) -> std::unique_ptr<Subject>
+			{ return std::unique_ptr<Subject>(new PmrSubject<std::pmr::monotonic_buffer_resource>(blockSize)); }},
+		{"malloc", true, [](size_t blockSize, size_t) -> std::unique_ptr<Subject>
+			{ return std::unique_ptr<Subject>(new MallocSubject(blockSize)); }},
+	};
+}
+
+#endif
@@ -0,0 +1,170 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "channelBenchmark.h"
+#include "../src/blockChannel.h"
+
+// Producer threads allocate blocks, fill them and pass them to one consumer thread, which reads and frees them.
+// The channel pipeline sends and frees in batches, the queue pipeline passes one pointer per lock as the code it replaces does.
+
+typedef std::chrono::steady_clock Clock;
+
+static const size_t channelBatch = 32;
+
+static void* allocateBlock(BlockAllocator& allocator)
+{
+	for (;;)
+	{
+		try
+		{
+			return allocator.allocate();
+		}
+		catch (const BlockAllocatorExceptions::OutOfAllocatableMemoryException& e)
+		{
+			// The consumer is behind and holds all blocks.
+			std::this_thread::yield();
+		}
+	}
+}
+
+static void produceToChannel(BlockAllocator& allocator, BlockChannel& channel, size_t count, size_t blockSize)
+{
+	void* batch[channelBatch];
+	size_t filled = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		batch[filled] = allocateBlock(allocator);
+		memset(batch[filled], (int)i, blockSize);
+
+		if (++filled < channelBatch && i + 1 < count)
+			continue;
+
+		for (size_t sent = 0; sent < filled; )
+		{
+			sent += channel.send(batch + sent, filled - sent);
+			if (sent < filled)
+				std::this_thread::yield();
+		}
+		filled = 0;
+	}
+}
+
+static void consumeFromChannel(BlockAllocator& allocator, BlockChannel& channel, size_t count)
+{
+	void* batch[channelBatch];
+	volatile char sink = 0;
+
+	while (count > 0)
+	{
+		size_t received = channel.receive(batch, channelBatch);
+		if (received == 0)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		for (size_t i = 0; i < received; i++)
+		{
+			sink = sink + *(char*)batch[i];
+		}
+		allocator.deallocate(batch, received);
+		count -= received;
+	}
+}
+
+static void produceToQueue(BlockAllocator& allocator, std::mutex& mutex, std::queue<void*>& queue, size_t count, size_t blockSize)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		void* block = allocateBlock(allocator);
+		memset(block, (int)i, blockSize);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push(block);
+	}
+}
+
+static void consumeFromQueue(BlockAllocator& allocator, std::mutex& mutex, std::queue<void*>& queue, size_t count)
+{
+	volatile char sink = 0;
+
+	while (count > 0)
+	{
+		void* block = NULL;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!queue.empty())
+			{
+				block = queue.front();
+				queue.pop();
+			}
+		}
+		if (block == NULL)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		sink = sink + *(char*)block;
+		allocator.deallocate(block);
+		--count;
+	}
+}
+
+static double elapsedSeconds(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void printChannelReport(const Options& options)
+{
+	const size_t perProducer = options.batch * options.rounds;
+
+	printf("block passing, block size %zu, %zu blocks per producer\n\n", options.blockSize, perProducer);
+	printf("%-26s %9s %14s\n", "pipeline", "producers", "Mblocks/s");
+
+	for (size_t producers : options.threads)
+	{
+		BlockAllocator allocator {options.blockSize, options.batch * producers};
+		std::vector<std::thread> threads;
+
+		{
+			BlockChannel channel {allocator, options.batch * producers,
+					producers == 1 ? BlockChannel::SingleProducer : BlockChannel::MultiProducer};
+			Clock::time_point start = Clock::now();
+
+			for (size_t p = 0; p < producers; p++)
+			{
+				threads.emplace_back(produceToChannel, std::ref(allocator), std::ref(channel), perProducer, options.blockSize);
+			}
+			consumeFromChannel(allocator, channel, perProducer * producers);
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+			printf("%-26s %9zu %14.2f\n", "BlockChannel", producers, perProducer * producers / elapsedSeconds(start) / 1e6);
+		}
+
+		threads.clear();
+		std::mutex mutex;
+		std::queue<void*> queue;
+		Clock::time_point start = Clock::now();
+
+		for (size_t p = 0; p < producers; p++)
+		{
+			threads.emplace_back(produceToQueue, std::ref(allocator), std::ref(mutex), std::ref(queue), perProducer, options.blockSize);
+		}
+		consumeFromQueue(allocator, mutex, queue, perProducer * producers);
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		printf("%-26s %9zu %14.2f\n", "std::queue + mutex", producers, perProducer * producers / elapsedSeconds(start) / 1e6);
+	}
+}
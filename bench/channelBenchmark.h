@@ -0,0 +1,10 @@
+#ifndef _CHANNEL_BENCHMARK_H
+#define _CHANNEL_BENCHMARK_H
+
+#include "benchmarkResults.h"
+
+//! \brief Compares BlockChannel with a mutex guarded std::queue on an allocate, fill, pass and free pipeline.
+//! \param[in] options The benchmark configuration, every producer thread passes batch blocks per round.
+void printChannelReport(const Options& options);
+
+#endif
@@ -0,0 +1,195 @@
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "hashMapBenchmark.h"
+#include "../src/pooledHashMap.h"
+
+// Every thread inserts its own random keys, looks all of them up, then replaces them one by one (erase and insert),
+// all threads share one table. The table is cleared by the main thread at the end of every round.
+
+typedef std::chrono::steady_clock Clock;
+
+enum Phase
+{
+	Insert,
+	Lookup,
+	Churn,
+	NumOfPhases
+};
+
+// The session table being replaced, one lock for the whole map.
+class UnorderedMapTable
+{
+public:
+	explicit UnorderedMapTable(size_t capacity)
+	{
+		map.reserve(capacity);
+	}
+
+	void insert(uint64_t key, uint64_t value)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		map.emplace(key, value);
+	}
+
+	bool find(uint64_t key, uint64_t& value)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto found = map.find(key);
+		if (found == map.end())
+			return false;
+		value = found->second;
+		return true;
+	}
+
+	void erase(uint64_t key)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		map.erase(key);
+	}
+
+	void clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		map.clear();
+	}
+
+private:
+	std::mutex mutex;
+	std::unordered_map<uint64_t, uint64_t> map;
+};
+
+template <BlockAllocator::FreeListType nodeFreeList>
+class PooledTable
+{
+public:
+	explicit PooledTable(size_t capacity) :
+		map(capacity, 64, 0, nodeFreeList)
+	{}
+
+	void insert(uint64_t key, uint64_t value)
+	{
+		map.insert(key, value);
+	}
+
+	bool find(uint64_t key, uint64_t& value)
+	{
+		return map.find(key, value);
+	}
+
+	void erase(uint64_t key)
+	{
+		map.erase(key);
+	}
+
+	void clear()
+	{
+		map.clear();
+	}
+
+private:
+	PooledHashMap<uint64_t, uint64_t> map;
+};
+
+static double elapsedNs(Clock::time_point start)
+{
+	return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+template <typename Table>
+static void runThread(Table& table, size_t batch, unsigned seed, double* phaseNs)
+{
+	std::mt19937_64 random(seed);
+	std::vector<uint64_t> keys(batch);
+	uint64_t sum = 0;
+
+	for (uint64_t& key : keys)
+	{
+		key = random();
+	}
+
+	Clock::time_point start = Clock::now();
+	for (uint64_t key : keys)
+	{
+		table.insert(key, key);
+	}
+	phaseNs[Insert] += elapsedNs(start);
+
+	start = Clock::now();
+	for (uint64_t key : keys)
+	{
+		uint64_t value = 0;
+		table.find(key, value);
+		sum += value;
+	}
+	phaseNs[Lookup] += elapsedNs(start);
+
+	start = Clock::now();
+	for (uint64_t& key : keys)
+	{
+		table.erase(key);
+		key = random();
+		table.insert(key, key);
+	}
+	phaseNs[Churn] += elapsedNs(start);
+
+	*(volatile uint64_t*)&sum = sum;
+}
+
+template <typename Table>
+static void runTable(const char* name, size_t numOfThreads, const Options& options)
+{
+	Table table(options.batch * numOfThreads);
+	std::vector<std::vector<double>> phaseNs(numOfThreads, std::vector<double>(NumOfPhases, 0));
+	double clearNs = 0;
+
+	for (size_t round = 0; round < options.rounds; round++)
+	{
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < numOfThreads; t++)
+		{
+			threads.emplace_back(runThread<Table>, std::ref(table), options.batch, (unsigned)(round * numOfThreads + t),
+					phaseNs[t].data());
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		Clock::time_point start = Clock::now();
+		table.clear();
+		clearNs += elapsedNs(start);
+	}
+
+	// Threads run the phases concurrently, the throughput is based on the mean time a thread spent in a phase.
+	printf("%-26s %7zu", name, numOfThreads);
+	for (int phase = 0; phase < NumOfPhases; phase++)
+	{
+		double meanNs = 0;
+		for (size_t t = 0; t < numOfThreads; t++)
+		{
+			meanNs += phaseNs[t][phase] / numOfThreads;
+		}
+		printf(" %12.2f", (double)options.batch * numOfThreads * options.rounds / meanNs * 1e3);
+	}
+	printf(" %12.1f\n", clearNs / options.rounds / 1e3);
+}
+
+void printHashMapReport(const Options& options)
+{
+	printf("hash map, %zu keys per thread, rounds %zu\n\n", options.batch, options.rounds);
+	printf("%-26s %7s %12s %12s %12s %12s\n", "subject", "threads", "insert Mops", "lookup Mops", "churn Mops", "clear us");
+
+	for (size_t numOfThreads : options.threads)
+	{
+		runTable<PooledTable<BlockAllocator::RingFreeList>>("PooledHashMap", numOfThreads, options);
+		// All writers share the pool lock, the gap to the row above grows with the number of threads.
+		runTable<PooledTable<BlockAllocator::MutexFreeList>>("PooledHashMap, mutex nodes", numOfThreads, options);
+		runTable<UnorderedMapTable>("std::unordered_map + mutex", numOfThreads, options);
+	}
+}
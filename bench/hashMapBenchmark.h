@@ -0,0 +1,10 @@
+#ifndef _HASH_MAP_BENCHMARK_H
+#define _HASH_MAP_BENCHMARK_H
+
+#include "benchmarkResults.h"
+
+//! \brief Compares PooledHashMap, with a lock-free and a mutex guarded node pool, with a mutex guarded std::unordered_map on insert, lookup, erase churn and clear.
+//! \param[in] options The benchmark configuration, every thread works on batch keys of its own for the given number of rounds.
+void printHashMapReport(const Options& options);
+
+#endif
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "internBenchmark.h"
+#include "../src/internPool.h"
+
+// Every round stores a batch of header-like payloads drawn from a set of distinct ones, then frees them all.
+// The memory is what the stored payloads take from their pool at the end of the batch, headers and padding included.
+
+typedef std::chrono::steady_clock Clock;
+
+// Every payload is stored in a block of its own, the baseline without deduplication.
+class CopiedPayloads
+{
+public:
+	CopiedPayloads(size_t payloadSize, size_t capacity) :
+		blocks(payloadSize, capacity)
+	{}
+
+	const void* store(const std::string& payload)
+	{
+		void* block = blocks.allocate();
+		memcpy(block, payload.data(), payload.size());
+		return block;
+	}
+
+	void free(const void* payload)
+	{
+		blocks.deallocate((void*)payload);
+	}
+
+	size_t getBytesInUse(size_t numOfStored) const
+	{
+		return numOfStored * (blocks.getBlockSize() + BlockAllocator::getHeaderSize());
+	}
+
+private:
+	BlockAllocator blocks;
+};
+
+class InternedPayloads
+{
+public:
+	InternedPayloads(size_t payloadSize, size_t capacity) :
+		pool(payloadSize, capacity)
+	{}
+
+	const void* store(const std::string& payload)
+	{
+		return pool.intern(payload.data(), payload.size());
+	}
+
+	void free(const void* payload)
+	{
+		pool.release(payload);
+	}
+
+	size_t getBytesInUse(size_t) const
+	{
+		return pool.getNumOfEntries() * pool.getAllocator().getBlockSize();
+	}
+
+private:
+	InternPool pool;
+};
+
+static std::vector<std::string> makePayloads(size_t count, size_t numOfDistinct, size_t payloadSize)
+{
+	std::vector<std::string> payloads;
+	payloads.reserve(count);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		std::string payload = "X-Request-Header-" + std::to_string(i % numOfDistinct) + ": ";
+		payload.resize(payloadSize, 'v');
+		payloads.push_back(payload);
+	}
+	return payloads;
+}
+
+template <typename Payloads>
+static void runPayloads(const char* name, Payloads& stored, const std::vector<std::string>& payloads, const Options& options)
+{
+	std::vector<const void*> handles(payloads.size());
+	size_t bytesInUse = 0;
+
+	Clock::time_point start = Clock::now();
+	for (size_t round = 0; round < options.rounds; round++)
+	{
+		for (size_t i = 0; i < payloads.size(); i++)
+		{
+			handles[i] = stored.store(payloads[i]);
+		}
+		bytesInUse = stored.getBytesInUse(payloads.size());
+		for (const void* handle : handles)
+		{
+			stored.free(handle);
+		}
+	}
+	double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+	printf("%-26s %12.1f %14zu %9.1f%%\n", name, ns / payloads.size() / options.rounds, bytesInUse,
+			100.0 * (double)bytesInUse / (double)(payloads.size() * options.blockSize));
+}
+
+void printInternReport(const Options& options)
+{
+	printf("intern pool, %zu payloads of %zu bytes, rounds %zu\n", options.batch, options.blockSize, options.rounds);
+
+	const size_t distinctPercents[] = {1, 10, 100};
+	for (size_t percent : distinctPercents)
+	{
+		size_t numOfDistinct = std::max(options.batch * percent / 100, (size_t)1);
+		std::vector<std::string> payloads = makePayloads(options.batch, numOfDistinct, options.blockSize);
+
+		printf("\n%zu distinct payloads (%zu%%)\n", numOfDistinct, percent);
+		printf("%-26s %12s %14s %10s\n", "subject", "ns/payload", "bytes in use", "of raw");
+
+		InternedPayloads interned(options.blockSize, options.batch);
+		CopiedPayloads copied(options.blockSize, options.batch);
+
+		runPayloads("InternPool", interned, payloads, options);
+		runPayloads("BlockAllocator copies", copied, payloads, options);
+	}
+}
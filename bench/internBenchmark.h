@@ -0,0 +1,10 @@
+#ifndef _INTERN_BENCHMARK_H
+#define _INTERN_BENCHMARK_H
+
+#include "benchmarkResults.h"
+
+//! \brief Compares InternPool with copying every payload into a block of its own, on data sets of different duplicate ratios.
+//! \param[in] options The benchmark configuration, batch payloads of block size bytes are stored and freed per round.
+void printInternReport(const Options& options);
+
+#endif
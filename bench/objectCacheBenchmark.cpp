@@ -0,0 +1,103 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "objectCacheBenchmark.h"
+#include "../src/objectCache.h"
+
+// Every round acquires a batch of request objects, fills their buffers as a request parser would, then releases them all.
+
+typedef std::chrono::steady_clock Clock;
+
+struct Request
+{
+	std::vector<uint64_t> fields;
+	std::string path;
+};
+
+static void fill(Request& request, size_t numOfFields)
+{
+	for (size_t i = 0; i < numOfFields; i++)
+	{
+		request.fields.push_back(i);
+	}
+	request.path.append("/api/v1/objects/cached/request/path");
+}
+
+static void reset(Request& request)
+{
+	request.fields.clear();
+	request.path.clear();
+}
+
+class HeapRequests
+{
+public:
+	Request* acquire()
+	{
+		return new Request();
+	}
+
+	void release(Request* request)
+	{
+		delete request;
+	}
+};
+
+class CachedRequests
+{
+public:
+	explicit CachedRequests(size_t capacity) :
+		cache(capacity, reset)
+	{}
+
+	Request* acquire()
+	{
+		return cache.acquire();
+	}
+
+	void release(Request* request)
+	{
+		cache.release(request);
+	}
+
+private:
+	ObjectCache<Request> cache;
+};
+
+template <typename Requests>
+static void runRequests(const char* name, Requests& requests, const Options& options)
+{
+	std::vector<Request*> batch(options.batch);
+	size_t numOfFields = options.blockSize / sizeof(uint64_t);
+
+	Clock::time_point start = Clock::now();
+	for (size_t round = 0; round < options.rounds; round++)
+	{
+		for (Request*& request : batch)
+		{
+			request = requests.acquire();
+			fill(*request, numOfFields);
+		}
+		for (Request* request : batch)
+		{
+			requests.release(request);
+		}
+	}
+	double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+	printf("%-26s %12.2f %12.1f\n", name, (double)options.batch * options.rounds / ns * 1e3, ns / options.batch / options.rounds);
+}
+
+void printObjectCacheReport(const Options& options)
+{
+	printf("object cache, %zu objects, %zu bytes of fields, rounds %zu\n\n", options.batch, options.blockSize, options.rounds);
+	printf("%-26s %12s %12s\n", "subject", "Mops/s", "ns/object");
+
+	HeapRequests heap;
+	CachedRequests cached(options.batch);
+
+	runRequests("ObjectCache", cached, options);
+	runRequests("new + delete", heap, options);
+}
@@ -0,0 +1,10 @@
+#ifndef _OBJECT_CACHE_BENCHMARK_H
+#define _OBJECT_CACHE_BENCHMARK_H
+
+#include "benchmarkResults.h"
+
+//! \brief Compares ObjectCache with new and delete of an object owning a vector and a string.
+//! \param[in] options The benchmark configuration, batch objects are acquired and released per round, block size sets the vector elements filled.
+void printObjectCacheReport(const Options& options);
+
+#endif
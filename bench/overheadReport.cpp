@@ -0,0 +1,57 @@
+#include <cstdio>
+
+#include "overheadReport.h"
+#include "../src/blockAllocator.h"
+#include "../src/slabAllocator.h"
+
+static void printRow(const char* layout, size_t blockSize, const BlockAllocator::MemoryOverhead& overhead)
+{
+	size_t total = overhead.totalBytes();
+	double perBlock = (double)(total - overhead.payloadBytes) * blockSize / overhead.payloadBytes;
+
+	printf("%-10s %10zu %12zu %10zu %10zu %10zu %8zu %8zu %12zu %8.1f%% %10.2f\n", layout, blockSize,
+			overhead.payloadBytes, overhead.headerBytes, overhead.paddingBytes, overhead.sideTableBytes,
+			overhead.controlBytes, overhead.systemSlackBytes, total,
+			100.0 * (total - overhead.payloadBytes) / overhead.payloadBytes, perBlock);
+}
+
+// Slots carved out of page sized parent blocks, the footers and the slack after the last slot count as padding,
+// the bitmap of held parent blocks as a side table.
+static void printSlabRow(size_t slotSize, size_t numOfSlots)
+{
+	const size_t pageSize = 4096;
+	if (slotSize > pageSize / 2)
+		return;
+
+	BlockAllocator probe {pageSize, 1};
+	SlabAllocator slab {probe, slotSize};
+	size_t numOfBlocks = (numOfSlots + slab.getSlotsPerBlock() - 1) / slab.getSlotsPerBlock();
+	BlockAllocator parent {pageSize, numOfBlocks};
+	BlockAllocator::MemoryOverhead overhead = parent.getMemoryOverhead();
+
+	overhead.payloadBytes = slotSize * numOfSlots;
+	overhead.paddingBytes += pageSize * numOfBlocks - overhead.payloadBytes;
+	overhead.controlBytes += sizeof(SlabAllocator);
+	overhead.sideTableBytes += (numOfBlocks + 63) / 64 * sizeof(uint64_t);
+	printRow("slab", slotSize, overhead);
+}
+
+void printOverheadReport(const std::vector<size_t>& blockSizes, size_t numOfBlocks)
+{
+	printf("memory overhead, %zu blocks per pool\n\n", numOfBlocks);
+	printf("%-10s %10s %12s %10s %10s %10s %8s %8s %12s %9s %10s\n", "layout", "block size", "payload", "headers",
+			"padding", "side", "control", "slack", "total", "overhead", "bytes/blk");
+
+	for (size_t blockSize : blockSizes)
+	{
+		BlockAllocator header {blockSize, numOfBlocks};
+		printRow("header", blockSize, header.getMemoryOverhead());
+
+		BlockAllocator::Config config;
+		config.layout = BlockAllocator::CompactLayout;
+		BlockAllocator compact {blockSize, numOfBlocks, config};
+		printRow("compact", blockSize, compact.getMemoryOverhead());
+
+		printSlabRow(blockSize, numOfBlocks);
+	}
+}
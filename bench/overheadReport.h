@@ -0,0 +1,12 @@
+#ifndef _OVERHEAD_REPORT_H
+#define _OVERHEAD_REPORT_H
+
+#include <stddef.h>
+#include <vector>
+
+//! \brief Prints the memory breakdown of every allocator layout for each block size.
+//! \param[in] blockSizes The block sizes to report.
+//! \param[in] numOfBlocks The number of blocks of every pool.
+void printOverheadReport(const std::vector<size_t>& blockSizes, size_t numOfBlocks);
+
+#endif
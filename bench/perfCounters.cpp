@@ -0,0 +1,111 @@
+#include <cstring>
+#include <limits>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "perfCounters.h"
+
+static uint64_t cacheMiss(uint64_t cache)
+{
+	return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+static int openCounter(uint32_t type, uint64_t config)
+{
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.disabled = 1;
+	attr.inherit = 1;
+	// User space only, this is permitted at the default perf_event_paranoid level.
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+PerfCounters::PerfCounters()
+{
+	fds[Cycles] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+	fds[Instructions] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+	fds[L1dMisses] = openCounter(PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_L1D));
+	fds[LlcMisses] = openCounter(PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_LL));
+	fds[DtlbMisses] = openCounter(PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_DTLB));
+	fds[BranchMisses] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+
+	memset(values, 0, sizeof(values));
+}
+
+PerfCounters::~PerfCounters()
+{
+	for (int fd : fds)
+	{
+		if (fd >= 0)
+			close(fd);
+	}
+}
+
+void PerfCounters::start()
+{
+	for (int fd : fds)
+	{
+		if (fd < 0)
+			continue;
+		ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+}
+
+void PerfCounters::stop()
+{
+	for (int i = 0; i < NumOfEvents; i++)
+	{
+		values[i] = 0;
+		if (fds[i] < 0)
+			continue;
+
+		ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+		// value, time enabled, time running
+		uint64_t data[3];
+		if (read(fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0)
+			continue;
+
+		values[i] = data[2] < data[1] ? (uint64_t)((double)data[0] * data[1] / data[2]) : data[0];
+	}
+}
+
+bool PerfCounters::isAvailable(Event event) const
+{
+	return fds[event] >= 0;
+}
+
+bool PerfCounters::isAnyAvailable() const
+{
+	for (int fd : fds)
+	{
+		if (fd >= 0)
+			return true;
+	}
+	return false;
+}
+
+double PerfCounters::perOperation(Event event, double operations) const
+{
+	if (!isAvailable(event) || operations <= 0)
+		return std::numeric_limits<double>::quiet_NaN();
+
+	return values[event] / operations;
+}
+
+const char* PerfCounters::name(Event event)
+{
+	static const char* const names[NumOfEvents] = {"cycles", "instr", "L1D-miss", "LLC-miss", "dTLB-miss", "br-miss"};
+
+	return names[event];
+}
@@ -0,0 +1,65 @@
+#ifndef _PERF_COUNTERS_H
+#define _PERF_COUNTERS_H
+
+#include <stdint.h>
+
+//! \brief Hardware performance counters read with perf_event_open around a benchmark run.
+
+//! Counters are opened for the calling process with inheritance, so they must be opened before the benchmark threads are started.
+//! Every counter is opened on its own, a counter the environment doesn't permit or the CPU doesn't provide is simply unavailable.
+//! Values are scaled when the kernel multiplexes counters.
+class PerfCounters
+{
+public:
+	//! \brief The collected events.
+	enum Event
+	{
+		Cycles,
+		Instructions,
+		L1dMisses,
+		LlcMisses,
+		DtlbMisses,
+		BranchMisses,
+		NumOfEvents
+	};
+
+	//! \brief Opens all counters, disabled.
+	PerfCounters();
+
+	//! \brief Closes the counters.
+	~PerfCounters();
+
+	//! \brief Deleted copy constructor.
+	PerfCounters(const PerfCounters&) = delete;
+
+	//! \brief Deleted assignment operator.
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	//! \brief Resets and enables the counters.
+	void start();
+
+	//! \brief Disables the counters and reads them.
+	void stop();
+
+	//! \brief Checks if an event is counted.
+	bool isAvailable(Event event) const;
+
+	//! \brief Checks if at least one event is counted.
+	bool isAnyAvailable() const;
+
+	//! \brief Returns the value read by stop() divided by the number of operations.
+	//! \return Returns a quiet NaN if the event isn't available.
+	double perOperation(Event event, double operations) const;
+
+	//! \brief Returns a short event name for reports.
+	static const char* name(Event event);
+
+private:
+	//! \brief Counter file descriptors, -1 if unavailable.
+	int fds[NumOfEvents];
+
+	//! \brief Values read by stop().
+	uint64_t values[NumOfEvents];
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "taskBenchmark.h"
+#include "../src/taskExecutor.h"
+
+// Every task captures 48 bytes, more than the small buffer of std::function in libstdc++ and libc++,
+// so the std::function pool allocates every closure from the heap.
+// "external" tasks are submitted by the main thread in waves of batch tasks, "nested" tasks are submitted by running tasks.
+
+typedef std::chrono::steady_clock Clock;
+
+static const size_t childrenPerTask = 16;
+
+// A thread pool as the one being replaced, one locked queue of std::function.
+class FunctionPool
+{
+public:
+	explicit FunctionPool(size_t numOfWorkers)
+	{
+		for (size_t i = 0; i < numOfWorkers; i++)
+		{
+			workers.emplace_back([this]()
+			{
+				run();
+			});
+		}
+	}
+
+	~FunctionPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			isStopping = true;
+		}
+		taskQueued.notify_all();
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	void submit(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.push_back(std::move(task));
+			++unfinished;
+		}
+		taskQueued.notify_one();
+	}
+
+	void waitForAll()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		allFinished.wait(lock, [this]() { return unfinished == 0; });
+	}
+
+private:
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable taskQueued;
+	std::condition_variable allFinished;
+	std::deque<std::function<void()>> tasks;
+	size_t unfinished = 0;
+	bool isStopping = false;
+
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;)
+		{
+			taskQueued.wait(lock, [this]() { return isStopping || !tasks.empty(); });
+			if (tasks.empty())
+				return;
+
+			std::function<void()> task = std::move(tasks.front());
+			tasks.pop_front();
+			lock.unlock();
+			task();
+			task = nullptr;
+			lock.lock();
+			if (--unfinished == 0)
+				allFinished.notify_all();
+		}
+	}
+};
+
+struct Payload
+{
+	std::array<uint64_t, 5> values;
+	std::atomic<uint64_t>* sum;
+};
+
+template <typename Pool>
+static void spawnChildren(Pool& pool, const Payload& payload)
+{
+	for (size_t i = 0; i < childrenPerTask; i++)
+	{
+		Payload child = payload;
+		child.values[0] = i;
+		pool.submit([child]()
+		{
+			child.sum->fetch_add(child.values[0], std::memory_order_relaxed);
+		});
+	}
+}
+
+// Returns the throughput in millions of tasks per second.
+template <typename Pool>
+static double runExternal(Pool& pool, const Options& options)
+{
+	std::atomic<uint64_t> sum(0);
+	Payload payload = {{{1, 2, 3, 4, 5}}, &sum};
+	Clock::time_point start = Clock::now();
+
+	for (size_t round = 0; round < options.rounds; round++)
+	{
+		for (size_t i = 0; i < options.batch; i++)
+		{
+			pool.submit([payload]()
+			{
+				payload.sum->fetch_add(payload.values[4], std::memory_order_relaxed);
+			});
+		}
+		pool.waitForAll();
+	}
+
+	return options.batch * options.rounds / std::chrono::duration<double>(Clock::now() - start).count() / 1e6;
+}
+
+template <typename Pool>
+static double runNested(Pool& pool, const Options& options)
+{
+	std::atomic<uint64_t> sum(0);
+	Payload payload = {{{1, 2, 3, 4, 5}}, &sum};
+	size_t roots = options.batch / (childrenPerTask + 1);
+	Pool* shared = &pool;
+	Clock::time_point start = Clock::now();
+
+	for (size_t round = 0; round < options.rounds; round++)
+	{
+		for (size_t i = 0; i < roots; i++)
+		{
+			pool.submit([shared, payload]()
+			{
+				spawnChildren(*shared, payload);
+			});
+		}
+		pool.waitForAll();
+	}
+
+	return roots * (childrenPerTask + 1) * options.rounds / std::chrono::duration<double>(Clock::now() - start).count() / 1e6;
+}
+
+void printTaskReport(const Options& options)
+{
+	printf("task spawn, 48 byte captures, %zu tasks in flight at most, rounds %zu\n\n", options.batch, options.rounds);
+	printf("%-26s %7s %14s %14s\n", "pool", "workers", "external Mt/s", "nested Mt/s");
+
+	for (size_t numOfWorkers : options.threads)
+	{
+		{
+			TaskExecutor executor {numOfWorkers, sizeof(Payload) + sizeof(void*), options.batch};
+			double external = runExternal(executor, options);
+			printf("%-26s %7zu %14.2f %14.2f\n", "TaskExecutor", numOfWorkers, external, runNested(executor, options));
+		}
+		{
+			FunctionPool pool {numOfWorkers};
+			double external = runExternal(pool, options);
+			printf("%-26s %7zu %14.2f %14.2f\n", "std::function pool", numOfWorkers, external, runNested(pool, options));
+		}
+	}
+}
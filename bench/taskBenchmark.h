@@ -0,0 +1,10 @@
+#ifndef _TASK_BENCHMARK_H
+#define _TASK_BENCHMARK_H
+
+#include "benchmarkResults.h"
+
+//! \brief Compares the task spawn throughput of TaskExecutor and a std::function thread pool.
+//! \param[in] options The benchmark configuration, batch tasks are in flight at most, threads sets the number of workers.
+void printTaskReport(const Options& options);
+
+#endif
@@ -0,0 +1,160 @@
+#include <limits>
+#include <new>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "allocatorArena.h"
+
+using namespace BlockAllocatorExceptions;
+
+static const size_t cacheLineSize = 64;
+
+AllocatorArena::AllocatorArena(size_t blockByteSize, size_t numOfBlocks, size_t allocatorsCount) :
+		blockSize(blockByteSize), blocksPerPool(numOfBlocks), maxAllocators(allocatorsCount)
+{
+	if (blockSize == 0 || blocksPerPool == 0 || maxAllocators == 0 || maxAllocators > std::numeric_limits<uint32_t>::max())
+		throw InvalidConstructorParametersException();
+
+	size_t blockWithHeaderSize = blockSize + BlockAllocator::getHeaderSize();
+	if (blockWithHeaderSize < blockSize || blocksPerPool > (std::numeric_limits<size_t>::max() - cacheLineSize) / blockWithHeaderSize)
+		throw InvalidConstructorParametersException();
+
+	poolSize = (blockWithHeaderSize * blocksPerPool + cacheLineSize - 1) / cacheLineSize * cacheLineSize;
+	if (maxAllocators > std::numeric_limits<size_t>::max() / poolSize)
+		throw InvalidConstructorParametersException();
+
+	regionSize = poolSize * maxAllocators;
+	void* mapped = mmap(NULL, regionSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (mapped == MAP_FAILED)
+		throw OutOfSystemMemoryException();
+	region = (char*)mapped;
+
+	slots.reset(new Slot[maxAllocators]);
+	isSlotUsed.reset(new bool[maxAllocators]());
+	freeSlots.reset(new uint32_t[maxAllocators]);
+
+	// The lowest slots are taken first, so a small number of allocators keeps to the start of the region.
+	for (size_t i = 0; i < maxAllocators; i++)
+	{
+		freeSlots[i] = (uint32_t)(maxAllocators - 1 - i);
+	}
+	numOfFreeSlots = maxAllocators;
+
+	budgetCharge.setTrimHook(trimForBudget, this);
+}
+
+AllocatorArena::~AllocatorArena()
+{
+	budgetCharge.releaseAll();
+
+	for (size_t i = 0; i < maxAllocators; i++)
+	{
+		if (isSlotUsed[i])
+			((BlockAllocator*)slots[i].storage)->~BlockAllocator();
+	}
+
+	munmap(region, regionSize);
+}
+
+BlockAllocator* AllocatorArena::createAllocator()
+{
+	// Charged before the lock is taken, the budget may trim the arena while charging.
+	budgetCharge.reserve(poolSize);
+
+	uint32_t slot;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (numOfFreeSlots == 0)
+		{
+			budgetCharge.release(poolSize);
+			throw OutOfAllocatableMemoryException();
+		}
+
+		slot = freeSlots[--numOfFreeSlots];
+		isSlotUsed[slot] = true;
+	}
+
+	BlockAllocator::Config config;
+	config.freeList = BlockAllocator::BiasedFreeList;
+	config.lazyFreeList = true;
+
+	// The constructor can't fail, the parameters were checked by the arena constructor and the pool is external.
+	return new (slots[slot].storage) BlockAllocator(blockSize, blocksPerPool, config, region + slot * poolSize);
+}
+
+void AllocatorArena::destroyAllocator(BlockAllocator* allocator)
+{
+	unsigned char* storage = (unsigned char*)allocator;
+	unsigned char* first = slots[0].storage;
+	size_t slot = (size_t)(storage - first) / sizeof(Slot);
+
+	if (storage < first || slot >= maxAllocators || slots[slot].storage != storage)
+		throw InvalidBlockAddressException();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!isSlotUsed[slot])
+			throw InvalidBlockAddressException();
+
+		allocator->~BlockAllocator();
+		isSlotUsed[slot] = false;
+		freeSlots[numOfFreeSlots++] = (uint32_t)slot;
+	}
+
+	budgetCharge.release(poolSize);
+}
+
+size_t AllocatorArena::trimForBudget(void* arena)
+{
+	return ((AllocatorArena*)arena)->trim();
+}
+
+// Every run of adjacent free slots is advised at once, so the system calls made under the lock are as many as the runs,
+// and pages shared by neighbouring free pools are released too.
+size_t AllocatorArena::trim()
+{
+	const uintptr_t pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+	size_t released = 0;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (numOfFreeSlots == 0)
+		return 0;
+
+	for (size_t first = 0; first < maxAllocators; first++)
+	{
+		if (isSlotUsed[first])
+			continue;
+
+		size_t last = first;
+		while (last + 1 < maxAllocators && !isSlotUsed[last + 1])
+		{
+			++last;
+		}
+
+		uintptr_t pagesStart = ((uintptr_t)(region + first * poolSize) + pageSize - 1) & ~(pageSize - 1);
+		uintptr_t pagesEnd = (uintptr_t)(region + (last + 1) * poolSize) & ~(pageSize - 1);
+
+		if (pagesStart < pagesEnd && madvise((void*)pagesStart, pagesEnd - pagesStart, MADV_DONTNEED) == 0)
+			released += pagesEnd - pagesStart;
+
+		first = last;
+	}
+
+	return released;
+}
+
+size_t AllocatorArena::getNumOfAllocators()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return maxAllocators - numOfFreeSlots;
+}
+
+size_t AllocatorArena::getMaxAllocators() const noexcept
+{
+	return maxAllocators;
+}
+
+size_t AllocatorArena::getPoolSize() const noexcept
+{
+	return poolSize;
+}
@@ -0,0 +1,123 @@
+#ifndef _ALLOCATOR_ARENA_H
+#define _ALLOCATOR_ARENA_H
+
+//! \addtogroup BlockAllocator
+//! @{
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+
+#include "blockAllocator.h"
+
+//! \brief Creates many small allocators of one shape out of a single mapped region.
+
+//! The arena maps one region holding the pools of all its allocators and keeps the allocator objects in a slot array,
+//! so creating an allocator needs no system allocation. Allocators use the BiasedFreeList with a lazily built free list,
+//! creation and destruction take constant time and never touch the pool memory.
+//! Every allocator is owned by the thread which created it, see BlockAllocator::BiasedFreeList.
+//! Slots of destroyed allocators are reused, the most recently released first, as its pool is the most likely to be cached.
+//! The pool of every existing allocator is charged to the process MemoryBudget, the budget trims the arena when it runs tight.
+//! ### Example
+//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
+//! AllocatorArena arena {256, 64, 10000};
+//!
+//! BlockAllocator* connectionPool = arena.createAllocator();
+//! void* buffer = connectionPool->allocate();
+//! ...
+//! arena.destroyAllocator(connectionPool);
+//! ~~~~~~~~~~~~~~~~~~~~~~~
+class AllocatorArena
+{
+public:
+	//! \brief AllocatorArena constructor, maps the region of all pools.
+
+	//! The region is mapped without reserving swap, its pages are only backed by memory once blocks are allocated.
+	//! \param[in] blockByteSize The block size of every allocator, must be greater than 0.
+	//! \param[in] numOfBlocks The number of blocks of every allocator, must be greater than 0.
+	//! \param[in] maxAllocators The maximum number of allocators existing at once, must be greater than 0 and less than 2^32.
+	//! \throw BlockAllocatorExceptions::InvalidConstructorParametersException If invalid constructor parameters were passed.
+	//! \throw BlockAllocatorExceptions::OutOfSystemMemoryException If the region can't be mapped.
+	AllocatorArena(size_t blockByteSize, size_t numOfBlocks, size_t maxAllocators);
+
+	//! \brief Destroys the allocators left and unmaps the region.
+	~AllocatorArena();
+
+	//! \brief Deleted copy constructor.
+	AllocatorArena(const AllocatorArena&) = delete;
+
+	//! \brief Deleted assignment operator.
+	AllocatorArena& operator=(const AllocatorArena&) = delete;
+
+	//! \brief Creates an allocator owned by the calling thread.
+	//! \return Returns the allocator, it stays valid until destroyAllocator() is called.
+	//! \throw BlockAllocatorExceptions::OutOfAllocatableMemoryException If maxAllocators allocators exist already.
+	//! \throw BlockAllocatorExceptions::MemoryBudgetExceededException If the pool doesn't fit the MemoryBudget.
+	BlockAllocator* createAllocator();
+
+	//! \brief Destroys an allocator, its blocks become invalid.
+	//! \param[in] allocator An allocator returned by createAllocator().
+	//! \throw BlockAllocatorExceptions::InvalidBlockAddressException If the allocator doesn't belong to the arena or was destroyed already.
+	void destroyAllocator(BlockAllocator* allocator);
+
+	//! \brief Releases the physical pages of the pools of destroyed allocators back to the system.
+	//! \return Returns the number of bytes released.
+	size_t trim();
+
+	//! \brief Returns the number of existing allocators.
+	size_t getNumOfAllocators();
+
+	//! \brief Returns the maximum number of allocators existing at once.
+	size_t getMaxAllocators() const noexcept;
+
+	//! \brief Returns the bytes of the region taken by one pool, block headers and alignment included.
+	size_t getPoolSize() const noexcept;
+
+private:
+	//! \brief Storage of one allocator object.
+	struct Slot
+	{
+		alignas(BlockAllocator) unsigned char storage[sizeof(BlockAllocator)];
+	};
+
+	//! \brief The block size of every allocator.
+	size_t blockSize;
+
+	//! \brief The number of blocks of every allocator.
+	size_t blocksPerPool;
+
+	//! \brief The maximum number of allocators.
+	size_t maxAllocators;
+
+	//! \brief The pool size, rounded up to a cache line so pools owned by different threads don't share one.
+	size_t poolSize;
+
+	//! \brief The mapped region holding all pools.
+	char* region = NULL;
+
+	//! \brief The size of the mapped region.
+	size_t regionSize = 0;
+
+	//! \brief Allocator objects.
+	std::unique_ptr<Slot[]> slots;
+
+	//! \brief Marks slots holding an allocator.
+	std::unique_ptr<bool[]> isSlotUsed;
+
+	//! \brief Stack of free slot indices.
+	std::unique_ptr<uint32_t[]> freeSlots;
+
+	//! \brief The number of free slot indices on the stack.
+	size_t numOfFreeSlots = 0;
+
+	//! \brief Guards the slots.
+	std::mutex mutex;
+
+	//! \brief The pools of existing allocators charged to the process MemoryBudget.
+	MemoryBudget::Charge budgetCharge;
+
+	//! \brief The MemoryBudget trim hook, trims the arena.
+	static size_t trimForBudget(void* arena);
+};
+
+//! @}
+#endif
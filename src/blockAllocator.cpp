@@ -1,12 +1,248 @@
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
 #include <limits>
 #include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
 
 #include "blockAllocator.h"
 
 using namespace BlockAllocatorExceptions;
 
+// The free list of the compact layout ends with this index.
+static const uint32_t noBlockIndex = std::numeric_limits<uint32_t>::max();
+
+const size_t BlockAllocator::maxTags;
+
+const size_t BlockAllocator::maxTrackedThreads;
+
+struct BlockAllocator::RemoteFreeTracking
+{
+	// Marks a block whose allocation wasn't sampled.
+	static const uint8_t notSampled = 0xff;
+
+	RemoteFreeTracking(size_t numOfBlocks, size_t period) :
+		samplingPeriod(period), allocatingThread(new uint8_t[numOfBlocks])
+	{
+		std::fill(allocatingThread.get(), allocatingThread.get() + numOfBlocks, notSampled);
+		for (std::atomic<uint64_t>& count : transfers)
+		{
+			count.store(0, std::memory_order_relaxed);
+		}
+		for (Countdown& countdown : countdowns)
+		{
+			countdown.left.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	// Counts down the allocations of a thread slot until the next sampled one, padded so slots don't share a cache line.
+	struct Countdown
+	{
+		std::atomic<size_t> left;
+		char padding[64 - sizeof(std::atomic<size_t>)];
+	};
+
+	size_t samplingPeriod;
+	std::unique_ptr<uint8_t[]> allocatingThread;
+	// Kept per allocator, a thread using several sampled pools samples each with its own period.
+	Countdown countdowns[maxTrackedThreads];
+	// Sampled frees, indexed by the allocating thread slot times maxTrackedThreads plus the deallocating one.
+	std::atomic<uint64_t> transfers[maxTrackedThreads * maxTrackedThreads];
+};
+
+const uint8_t BlockAllocator::RemoteFreeTracking::notSampled;
+
+const size_t BlockAllocator::numOfLifetimeBuckets;
+
+// A millisecond clock read from the vDSO without a system call, its resolution is the scheduler tick.
+static uint64_t coarseNowMs() noexcept
+{
+	timespec now;
+#if defined(CLOCK_MONOTONIC_COARSE)
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+#else
+	clock_gettime(CLOCK_MONOTONIC, &now);
+#endif
+	return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+// Bucket 0 holds lifetimes below 1 ms, bucket i those in [2^(i-1), 2^i) ms, the last one everything longer.
+static size_t lifetimeBucket(uint64_t lifetimeMs) noexcept
+{
+	size_t bucket = 0;
+	while (lifetimeMs != 0 && bucket < BlockAllocator::numOfLifetimeBuckets - 1)
+	{
+		lifetimeMs >>= 1;
+		++bucket;
+	}
+	return bucket;
+}
+
+struct BlockAllocator::LifetimeTracking
+{
+	explicit LifetimeTracking(size_t numOfBlocks) :
+		allocatedAt(new std::atomic<uint64_t>[numOfBlocks])
+	{
+		for (size_t i = 0; i < numOfBlocks; i++)
+		{
+			allocatedAt[i].store(0, std::memory_order_relaxed);
+		}
+		for (std::atomic<uint64_t>& count : histogram)
+		{
+			count.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	// Read by getOldestBlocks() while other threads allocate, hence atomic.
+	std::unique_ptr<std::atomic<uint64_t>[]> allocatedAt;
+	std::atomic<uint64_t> histogram[numOfLifetimeBuckets];
+};
+
+// The number of counter shards, threads are spread over them round robin.
+static const size_t numOfTagShards = 16;
+
+// The shard of the calling thread.
+static size_t currentTagShard() noexcept
+{
+	static std::atomic<size_t> nextShard(0);
+	static thread_local size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % numOfTagShards;
+
+	return shard;
+}
+
+struct BlockAllocator::TagAccounting
+{
+	// Live counters may go negative in a shard, a block is often deallocated by another thread than the one which allocated it.
+	struct Shard
+	{
+		std::atomic<int64_t> live[maxTags];
+		// Threads may share a shard, so the high is atomic as well.
+		std::atomic<int64_t> high[maxTags];
+		// Keeps the counters of neighbouring shards on different cache lines.
+		char padding[64];
+	};
+
+	explicit TagAccounting(size_t numOfBlocks) :
+		blockTags(new uint8_t[numOfBlocks]())
+	{
+		for (Shard& shard : shards)
+		{
+			for (size_t i = 0; i < maxTags; i++)
+			{
+				shard.live[i].store(0, std::memory_order_relaxed);
+				shard.high[i].store(0, std::memory_order_relaxed);
+			}
+		}
+		for (size_t i = 0; i < maxTags; i++)
+		{
+			peaks[i].store(0, std::memory_order_relaxed);
+			isRegistered[i].store(false, std::memory_order_relaxed);
+		}
+		names[0] = "untagged";
+		isRegistered[0].store(true, std::memory_order_relaxed);
+	}
+
+	int64_t sumLive(Tag tag) const noexcept
+	{
+		int64_t sum = 0;
+		for (const Shard& shard : shards)
+		{
+			sum += shard.live[tag].load(std::memory_order_relaxed);
+		}
+		return sum;
+	}
+
+	void updatePeak(Tag tag, int64_t live) noexcept
+	{
+		size_t candidate = live > 0 ? (size_t)live : 0;
+		size_t peak = peaks[tag].load(std::memory_order_relaxed);
+		while (candidate > peak && !peaks[tag].compare_exchange_weak(peak, candidate, std::memory_order_relaxed))
+		{}
+	}
+
+	Shard shards[numOfTagShards];
+	std::unique_ptr<uint8_t[]> blockTags;
+	std::atomic<size_t> peaks[maxTags];
+	std::atomic<bool> isRegistered[maxTags];
+	std::mutex namesMutex;
+	std::string names[maxTags];
+};
+
+// Guards the list of the allocators created with Config::forkSafe, constant initialized so it's usable by allocators with static storage.
+static std::mutex forkSafeRegistryMutex;
+
+// The first allocator of the list, linked through nextForkSafe. Nothing is allocated, so registering never fails.
+static BlockAllocator* forkSafeHead = NULL;
+
+void BlockAllocator::registerForFork()
+{
+	static std::once_flag handlersInstalled;
+	std::call_once(handlersInstalled, []()
+	{
+		if (pthread_atfork(&BlockAllocator::prepareFork, &BlockAllocator::finishFork, &BlockAllocator::finishFork) != 0)
+			throw OutOfSystemMemoryException();
+	});
+
+	std::lock_guard<std::mutex> lock(forkSafeRegistryMutex);
+	nextForkSafe = forkSafeHead;
+	forkSafeHead = this;
+	isForkSafe = true;
+}
+
+void BlockAllocator::unregisterForFork() noexcept
+{
+	std::lock_guard<std::mutex> lock(forkSafeRegistryMutex);
+
+	BlockAllocator** link = &forkSafeHead;
+	while (*link != this)
+	{
+		link = &(*link)->nextForkSafe;
+	}
+	*link = nextForkSafe;
+}
+
+// Runs in the thread calling fork(), the locks are taken so the child doesn't inherit one held by a thread which doesn't exist there.
+void BlockAllocator::prepareFork()
+{
+	forkSafeRegistryMutex.lock();
+	for (BlockAllocator* allocator = forkSafeHead; allocator != NULL; allocator = allocator->nextForkSafe)
+	{
+		allocator->mutex.lock();
+		if (allocator->tags)
+			allocator->tags->namesMutex.lock();
+	}
+}
+
+// Runs in both the parent and the child, in the thread which took the locks.
+void BlockAllocator::finishFork()
+{
+	for (BlockAllocator* allocator = forkSafeHead; allocator != NULL; allocator = allocator->nextForkSafe)
+	{
+		if (allocator->tags)
+			allocator->tags->namesMutex.unlock();
+		allocator->mutex.unlock();
+	}
+	forkSafeRegistryMutex.unlock();
+}
+
 BlockAllocator::BlockAllocator(size_t size, size_t blocks, void* memoryPool) :
-		blockSize(size), headerSize(sizeof(Block*)), maxBlocks(blocks)
+		BlockAllocator(size, blocks, Config(), memoryPool)
+{}
+
+BlockAllocator::BlockAllocator(size_t size, size_t blocks, const Config& config, void* memoryPool) :
+		blockSize(size), headerSize(config.layout == HeaderLayout ? sizeof(Block*) : 0), maxBlocks(blocks), layout(config.layout),
+		freeListType(config.freeList), ringPushPosition(0), ringPopPosition(0), asyncWaitersCount(0),
+		owner(std::this_thread::get_id()), foreignHead(NULL)
 {
 	if (blockSize == 0 || maxBlocks == 0)
 		throw InvalidConstructorParametersException();
@@ -14,17 +250,45 @@ BlockAllocator::BlockAllocator(size_t size, size_t blocks, void* memoryPool) :
 	if (!isSizeCorrect(blockSize, maxBlocks))
 		throw InvalidConstructorParametersException();
 
-	blockWithHeaderSize = blockSize + headerSize;
+	if (freeListType == BiasedFreeList && layout != HeaderLayout)
+		throw InvalidConstructorParametersException();
+
+	const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	if (layout == PageLayout && (blockSize < pageSize || freeListType != MutexFreeList || (uintptr_t)memoryPool % pageSize != 0))
+		throw InvalidConstructorParametersException();
+
+	// Header blocks are written by every allocation and deallocation.
+	if (config.forkSafe && layout == HeaderLayout)
+		throw InvalidConstructorParametersException();
+
+	// A free compact block holds the index of the next free block, so it can't be smaller than the index.
+	if (layout == CompactLayout)
+		blockWithHeaderSize = std::max(blockSize, sizeof(uint32_t));
+	else if (layout == PageLayout)
+		blockWithHeaderSize = (blockSize + pageSize - 1) / pageSize * pageSize;
+	else
+		blockWithHeaderSize = blockSize + headerSize;
 
 	// Task doesn't specify how the memoryPool is set
 	// if external pool isn't provided let's create a new one from the system
 	if (memoryPool == NULL)
 	{
 		poolType = Internal;
-		startHeader = (char*)malloc(blockWithHeaderSize * maxBlocks);
+		budgetCharge.reserve(blockWithHeaderSize * maxBlocks);
+		if (layout == PageLayout)
+		{
+			// A private anonymous mapping is page aligned and its pages may be released with MADV_FREE.
+			void* mapping = mmap(NULL, blockWithHeaderSize * maxBlocks, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			startHeader = mapping == MAP_FAILED ? NULL : (char*)mapping;
+		}
+		else
+			startHeader = (char*)malloc(blockWithHeaderSize * maxBlocks);
 
 		if(startHeader == NULL)
+		{
+			budgetCharge.releaseAll();
 			throw OutOfSystemMemoryException();
+		}
 	}
 	else
 	{
@@ -36,16 +300,83 @@ BlockAllocator::BlockAllocator(size_t size, size_t blocks, void* memoryPool) :
 	// Otherwise an independent bit flag can be used in the header.
 	blockInUseFlag = (Block*)1;
 
+	// The destructor doesn't run for a constructor which throws, the pool is released here then.
+	try
+	{
+		initPool(config);
+	}
+	catch (...)
+	{
+		releasePool();
+		throw;
+	}
+
+	if (poolType == Internal)
+		budgetCharge.setTrimHook(trimForBudget, this);
+}
+
+void BlockAllocator::initPool(const Config& config)
+{
+	if (config.tagging)
+		tags.reset(new TagAccounting(maxBlocks));
+
+	if (config.remoteFreeSampling != 0)
+		remoteFrees.reset(new RemoteFreeTracking(maxBlocks, config.remoteFreeSampling));
+
+	if (config.lifetimeTracking)
+		lifetimes.reset(new LifetimeTracking(maxBlocks));
+
+	if (layout == PageLayout || config.forkSafe)
+		nextFreeIndex.reset(new uint32_t[maxBlocks]);
+
+	if (layout == PageLayout)
+		retainedFreeBlocksLimit = config.retainedFreeBlocks;
+
 	endHeader = startHeader + blockWithHeaderSize * (maxBlocks - 1);
 	headHeader = (Block*)startHeader;
+	headIndex = 0;
+	untouchedIndex.store(maxBlocks, std::memory_order_relaxed);
+
+	if (freeListType == RingFreeList)
+		buildRing();
+	else
+	{
+		if (layout != HeaderLayout)
+			inUseBitmap.assign((maxBlocks + 63) / 64, 0);
 
-	buildBlocksList();
+		if (config.lazyFreeList)
+		{
+			headHeader = NULL;
+			headIndex = noBlockIndex;
+			tailIndex = noBlockIndex;
+			untouchedIndex.store(0, std::memory_order_relaxed);
+		}
+		else
+			buildBlocksList();
+	}
+
+	// Registered last, a constructor which throws releases the pool and leaves no allocator behind in the registry.
+	if (config.forkSafe)
+		registerForFork();
 }
 
 bool BlockAllocator::isSizeCorrect(size_t blockByteSize, size_t numOfBlocks) const noexcept
 {
 	size_t maxBlockWithHeaderSize = std::numeric_limits<size_t>::max() / numOfBlocks;
 
+	// Compact, page and ring blocks are addressed by 32-bit indices.
+	if ((layout != HeaderLayout || freeListType == RingFreeList) && numOfBlocks >= noBlockIndex)
+		return false;
+
+	if (layout == CompactLayout)
+		return numOfBlocks < noBlockIndex && std::max(blockByteSize, sizeof(uint32_t)) <= maxBlockWithHeaderSize;
+
+	if (layout == PageLayout)
+	{
+		size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+		return blockByteSize <= maxBlockWithHeaderSize / pageSize * pageSize;
+	}
+
 	if (maxBlockWithHeaderSize < getHeaderSize())
 		return false;
 
@@ -54,6 +385,16 @@ bool BlockAllocator::isSizeCorrect(size_t blockByteSize, size_t numOfBlocks) con
 
 void BlockAllocator::buildBlocksList()
 {
+	if (layout != HeaderLayout)
+	{
+		for (size_t i = 0; i < maxBlocks; i++)
+		{
+			setNextIndex(startHeader + i * blockWithHeaderSize, i + 1 < maxBlocks ? (uint32_t)(i + 1) : noBlockIndex);
+		}
+		tailIndex = (uint32_t)(maxBlocks - 1);
+		return;
+	}
+
 	Block* block;
 
 	for (char* i = startHeader; i < endHeader; i += blockWithHeaderSize)
@@ -65,86 +406,1318 @@ void BlockAllocator::buildBlocksList()
 	block->next = NULL;
 }
 
-// Task doesn't specify if we need to allocate multiple blocks at once.
-// Let's choose not to allocate more then one block at once.
-// Otherwise we'll need to hold used block size somehow.
-// This will increase minimum block size if header is kept inside the block.
-void* BlockAllocator::allocate()
+// The ring is a bounded MPMC queue as described by Dmitry Vyukov.
+// A slot is free for the producer at position p when its sequence equals p,
+// and holds a value for the consumer at position p when its sequence equals p + 1.
+void BlockAllocator::buildRing()
 {
-	std::lock_guard<std::mutex> lock(mutex);
-	if (headHeader == NULL)
+	size_t capacity = 1;
+	while (capacity < maxBlocks)
 	{
-		throw OutOfAllocatableMemoryException();
+		capacity <<= 1;
 	}
+	ringMask = capacity - 1;
 
-	Block* freeBlock = headHeader;
-	headHeader = headHeader->next;
-	freeBlock->next = blockInUseFlag;
+	ring.reset(new RingCell[capacity]);
+	ringInUseBitmap.reset(new std::atomic<uint64_t>[(maxBlocks + 63) / 64]);
+	resetRing();
+}
+
+// Nothing is allocated, deallocateAll() resets the ring under the lock and mustn't fail half way.
+void BlockAllocator::resetRing() noexcept
+{
+	for (size_t i = 0; i <= ringMask; i++)
+	{
+		ring[i].index = (uint32_t)i;
+		ring[i].sequence.store(i < maxBlocks ? i + 1 : i, std::memory_order_relaxed);
+	}
+	ringPopPosition.store(0, std::memory_order_relaxed);
+	ringPushPosition.store(maxBlocks, std::memory_order_relaxed);
 
-	return (char*)freeBlock + getHeaderSize();
+	size_t words = (maxBlocks + 63) / 64;
+	for (size_t i = 0; i < words; i++)
+	{
+		ringInUseBitmap[i].store(0, std::memory_order_relaxed);
+	}
 }
 
-size_t BlockAllocator::getHeaderSize() noexcept
+void BlockAllocator::ringPush(uint32_t index) noexcept
 {
-	return sizeof(Block*);
+	size_t position = ringPushPosition.load(std::memory_order_relaxed);
+
+	for (;;)
+	{
+		RingCell& cell = ring[position & ringMask];
+		size_t sequence = cell.sequence.load(std::memory_order_acquire);
+		intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+		if (difference == 0)
+		{
+			// Acquire pairs with the release of takeOrEnqueue(), a push ordered after a queued request sees its count.
+			if (ringPushPosition.compare_exchange_weak(position, position + 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+			{
+				cell.index = index;
+				cell.sequence.store(position + 1, std::memory_order_release);
+				return;
+			}
+		}
+		else if (difference < 0)
+		{
+			// The ring has a slot for every block, so it's never full, a consumer preempted
+			// between claiming the slot and releasing it keeps it busy.
+			std::this_thread::yield();
+			position = ringPushPosition.load(std::memory_order_relaxed);
+		}
+		else
+			position = ringPushPosition.load(std::memory_order_relaxed);
+	}
 }
 
-size_t BlockAllocator::getBlockSize() const noexcept
+bool BlockAllocator::ringPop(uint32_t& index) noexcept
 {
-	return blockSize;
+	size_t position = ringPopPosition.load(std::memory_order_relaxed);
+
+	for (;;)
+	{
+		RingCell& cell = ring[position & ringMask];
+		size_t sequence = cell.sequence.load(std::memory_order_acquire);
+		intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+
+		if (difference == 0)
+		{
+			if (ringPopPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+			{
+				index = cell.index;
+				cell.sequence.store(position + ringMask + 1, std::memory_order_release);
+				return true;
+			}
+		}
+		else if (difference < 0)
+		{
+			// The slot is either empty or a producer claimed it and didn't publish the index yet,
+			// reporting exhaustion in the latter case would lose a free block.
+			if (ringPushPosition.load(std::memory_order_acquire) == position)
+				return false;
+
+			std::this_thread::yield();
+			position = ringPopPosition.load(std::memory_order_relaxed);
+		}
+		else
+			position = ringPopPosition.load(std::memory_order_relaxed);
+	}
 }
 
-void BlockAllocator::deallocate(void* block)
+void* BlockAllocator::markRingBlockInUse(uint32_t index) noexcept
 {
-	std::lock_guard<std::mutex> lock(mutex);
-	if (!isBlockInUse(block))
+	ringInUseBitmap[index / 64].fetch_or((uint64_t)1 << (index % 64), std::memory_order_acq_rel);
+
+	return startHeader + index * blockWithHeaderSize + headerSize;
+}
+
+void BlockAllocator::deallocateToRing(void* block)
+{
+	if (!isBlockAddress(block))
+		throw InvalidBlockAddressException();
+
+	size_t index = ((char*)block - headerSize - startHeader) / blockWithHeaderSize;
+	uint64_t bit = (uint64_t)1 << (index % 64);
+
+	// Clearing the bit atomically makes a concurrent double deallocation fail in one of the threads.
+	if ((ringInUseBitmap[index / 64].fetch_and(~bit, std::memory_order_acq_rel) & bit) == 0)
+		throw InvalidBlockAddressException();
+
+	ringPush((uint32_t)index);
+
+	// No fence, the push position orders the push and the request, see takeOrEnqueue().
+	if (asyncWaitersCount.load(std::memory_order_relaxed) != 0)
+		serveRingWaiters();
+}
+
+void BlockAllocator::serveRingWaiters()
+{
+	for (;;)
+	{
+		AllocationCallback waiter;
+		uint32_t index;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (waiters.empty() || !ringPop(index))
+				return;
+
+			waiter = std::move(waiters.front());
+			waiters.pop_front();
+			asyncWaitersCount.fetch_sub(1);
+		}
+		waiter(markRingBlockInUse(index));
+	}
+}
+
+bool BlockAllocator::isOwnerThread() const noexcept
+{
+	return owner.load(std::memory_order_acquire) == std::this_thread::get_id();
+}
+
+void BlockAllocator::transferOwnership(std::thread::id newOwner)
+{
+	if (freeListType != BiasedFreeList)
+		return;
+
+	if (!isOwnerThread())
+		throw NotOwnerThreadException();
+
+	// The release store publishes the free list to the new owner.
+	owner.store(newOwner, std::memory_order_release);
+}
+
+bool BlockAllocator::claimOwnership() noexcept
+{
+	if (freeListType != BiasedFreeList)
+		return true;
+
+	std::thread::id noOwner;
+	std::thread::id self = std::this_thread::get_id();
+
+	return owner.compare_exchange_strong(noOwner, self, std::memory_order_acq_rel) || noOwner == self;
+}
+
+void BlockAllocator::drainForeignBlocks() noexcept
+{
+	// Taking the whole list at once needs no ABA protection, foreign threads only ever push.
+	// The release lets a foreign push ordered after it see the requests counted before, see takeOrEnqueue().
+	Block* foreign = foreignHead.exchange(NULL, std::memory_order_acq_rel);
+	if (foreign == NULL)
+		return;
+
+	Block* tail = foreign;
+	while (tail->next != NULL)
 	{
+		tail = tail->next;
+	}
+	tail->next = headHeader;
+	headHeader = foreign;
+}
+
+void* BlockAllocator::allocateBiased()
+{
+	if (!isOwnerThread())
+		throw NotOwnerThreadException();
+
+	if (headHeader == NULL)
+		drainForeignBlocks();
+
+	if (!hasFreeBlock())
+		throw OutOfAllocatableMemoryException();
+
+	return popFreeBlock();
+}
+
+void BlockAllocator::deallocateBiased(void* block)
+{
+	if (!claimBiasedBlock(block))
 		throw InvalidBlockAddressException();
+
+	if (asyncWaitersCount.load(std::memory_order_acquire) != 0 && handToWaiter(block))
+		return;
+
+	if (isOwnerThread())
+	{
+		pushFreeBlock(block);
+		return;
 	}
 
 	Block* header = (Block*)((char*)block - headerSize);
+	Block* head = foreignHead.load(std::memory_order_relaxed);
+	do
+	{
+		// Atomic, the exchange of a thread freeing the block twice may read the header meanwhile.
+		__atomic_store_n(&header->next, head, __ATOMIC_RELAXED);
+	}
+	while (!foreignHead.compare_exchange_weak(head, header, std::memory_order_acq_rel, std::memory_order_relaxed));
 
-	header->next = headHeader;
-
-	headHeader = header;
+	// No fence, the foreign list head orders the push and the request, see takeOrEnqueue().
+	if (asyncWaitersCount.load(std::memory_order_relaxed) != 0)
+		serveForeignWaiters();
 }
 
-bool BlockAllocator::isBlockInUse(void* block) const noexcept
+bool BlockAllocator::claimBiasedBlock(void* block) noexcept
 {
 	if (!isBlockAddress(block))
 		return false;
 
+	// Headers of blocks never allocated hold no flag yet.
+	size_t untouched = untouchedIndex.load(std::memory_order_acquire);
+	if (untouched < maxBlocks && (char*)block - headerSize >= startHeader + untouched * blockWithHeaderSize)
+		return false;
+
+	// Foreign threads may free the same block concurrently, the header is read by the exchange only and one thread wins it.
 	Block* header = (Block*)((char*)block - headerSize);
-	if (header->next == blockInUseFlag)
-		return true;
+	Block* inUse = blockInUseFlag;
+	return __atomic_compare_exchange_n(&header->next, &inUse, (Block*)NULL, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
 
-	return false;
+bool BlockAllocator::handToWaiter(void* block)
+{
+	AllocationCallback waiter;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (waiters.empty())
+			return false;
+
+		__atomic_store_n(&((Block*)((char*)block - headerSize))->next, blockInUseFlag, __ATOMIC_RELAXED);
+		waiter = std::move(waiters.front());
+		waiters.pop_front();
+		asyncWaitersCount.fetch_sub(1);
+	}
+	waiter(block);
+	return true;
 }
 
-bool BlockAllocator::isBlockAddress(void* block) const noexcept
+void BlockAllocator::serveForeignWaiters()
 {
-	char* header = (char*)block - headerSize;
+	for (;;)
+	{
+		AllocationCallback waiter;
+		Block* served;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (waiters.empty())
+				return;
 
-	if (block == NULL || header > endHeader || header < startHeader)
-		return false;
+			served = foreignHead.exchange(NULL, std::memory_order_acquire);
+			if (served == NULL)
+				return;
 
-	size_t reminder = (size_t)(header - startHeader) % blockWithHeaderSize;
+			// Only the first block is needed, the rest goes back for the owner to drain.
+			Block* rest = served->next;
+			while (rest != NULL)
+			{
+				Block* next = rest->next;
+				Block* head = foreignHead.load(std::memory_order_relaxed);
+				do
+				{
+					rest->next = head;
+				}
+				while (!foreignHead.compare_exchange_weak(head, rest, std::memory_order_release, std::memory_order_relaxed));
+				rest = next;
+			}
 
-	if (reminder == 0)
-		return true;
+			served->next = blockInUseFlag;
+			waiter = std::move(waiters.front());
+			waiters.pop_front();
+			asyncWaitersCount.fetch_sub(1);
+		}
+		waiter((char*)served + headerSize);
+	}
+}
 
-	return false;
+// Task doesn't specify if we need to allocate multiple blocks at once.
+// Let's choose not to allocate more then one block at once.
+// Otherwise we'll need to hold used block size somehow.
+// This will increase minimum block size if header is kept inside the block.
+void* BlockAllocator::allocate()
+{
+	void* block = allocateBlock();
+
+	if (isRecording())
+		recordAllocation(block, 0);
+	return block;
 }
 
-BlockAllocator::~BlockAllocator()
+void* BlockAllocator::allocate(Tag tag)
 {
-	if (poolType == Internal && startHeader != NULL)
+	if (!tags)
+		return allocate();
+
+	if (tag >= maxTags || !tags->isRegistered[tag].load(std::memory_order_acquire))
+		throw InvalidTagException();
+
+	void* block = allocateBlock();
+	recordAllocation(block, tag);
+	return block;
+}
+
+void* BlockAllocator::allocateBlock()
+{
+	if (freeListType == BiasedFreeList)
+		return allocateBiased();
+
+	if (freeListType == RingFreeList)
+	{
+		uint32_t index;
+		if (!ringPop(index))
+			throw OutOfAllocatableMemoryException();
+
+		return markRingBlockInUse(index);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!hasFreeBlock())
 	{
-		std::free(startHeader);
+		throw OutOfAllocatableMemoryException();
 	}
+
+	return popFreeBlock();
 }
 
-BlockAllocator::MemoryPoolType BlockAllocator::getPoolType() const noexcept
+void* BlockAllocator::tryAllocate() noexcept
 {
-	return poolType;
+	void* block = tryAllocateBlock();
+
+	if (isRecording() && block != NULL)
+		recordAllocation(block, 0);
+	return block;
+}
+
+void* BlockAllocator::tryAllocateBlock() noexcept
+{
+	if (freeListType == BiasedFreeList)
+	{
+		if (!isOwnerThread())
+			return NULL;
+
+		if (headHeader == NULL)
+			drainForeignBlocks();
+
+		return hasFreeBlock() ? popFreeBlock() : NULL;
+	}
+
+	if (freeListType == RingFreeList)
+	{
+		uint32_t index;
+		return ringPop(index) ? markRingBlockInUse(index) : NULL;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	return hasFreeBlock() ? popFreeBlock() : NULL;
+}
+
+bool BlockAllocator::hasFreeBlock() const noexcept
+{
+	if (untouchedIndex.load(std::memory_order_relaxed) < maxBlocks)
+		return true;
+
+	if (layout != HeaderLayout)
+		return headIndex != noBlockIndex;
+
+	return headHeader != NULL;
+}
+
+void* BlockAllocator::popUntouchedBlock() noexcept
+{
+	size_t index = untouchedIndex.load(std::memory_order_relaxed);
+	char* block = startHeader + index * blockWithHeaderSize;
+
+	untouchedIndex.store(index + 1, std::memory_order_release);
+	if (layout != HeaderLayout)
+	{
+		inUseBitmap[index / 64] |= (uint64_t)1 << (index % 64);
+		return block;
+	}
+
+	((Block*)block)->next = blockInUseFlag;
+	return block + headerSize;
+}
+
+void* BlockAllocator::popFreeBlock() noexcept
+{
+	// Freed blocks are reused first, they are more likely to be cached.
+	if (layout != HeaderLayout ? headIndex == noBlockIndex : headHeader == NULL)
+		return popUntouchedBlock();
+
+	if (layout != HeaderLayout)
+	{
+		char* freeBlock = startHeader + headIndex * blockWithHeaderSize;
+
+		inUseBitmap[headIndex / 64] |= (uint64_t)1 << (headIndex % 64);
+		headIndex = getNextIndex(freeBlock);
+
+		// Retained blocks are kept at the head, ahead of the released ones.
+		if (numOfRetainedFreeBlocks != 0)
+			--numOfRetainedFreeBlocks;
+		if (headIndex == noBlockIndex)
+			tailIndex = noBlockIndex;
+
+		return freeBlock;
+	}
+
+	Block* freeBlock = headHeader;
+	headHeader = headHeader->next;
+	freeBlock->next = blockInUseFlag;
+
+	return (char*)freeBlock + headerSize;
+}
+
+void BlockAllocator::pushFreeBlock(void* block) noexcept
+{
+	if (layout != HeaderLayout)
+	{
+		uint32_t index = (uint32_t)(((char*)block - startHeader) / blockWithHeaderSize);
+
+		inUseBitmap[index / 64] &= ~((uint64_t)1 << (index % 64));
+		if (layout == PageLayout && numOfRetainedFreeBlocks >= retainedFreeBlocksLimit)
+		{
+			pushReleasedBlock(index);
+			return;
+		}
+
+		setNextIndex((char*)block, headIndex);
+		if (headIndex == noBlockIndex)
+			tailIndex = index;
+		headIndex = index;
+		if (layout == PageLayout)
+			++numOfRetainedFreeBlocks;
+		return;
+	}
+
+	Block* header = (Block*)((char*)block - headerSize);
+
+	header->next = headHeader;
+
+	headHeader = header;
+}
+
+void BlockAllocator::pushReleasedBlock(uint32_t index) noexcept
+{
+	char* block = startHeader + index * blockWithHeaderSize;
+
+	// Released before the block is linked, once linked another thread may allocate it and its new contents must survive.
+	// MADV_FREE lets the kernel take the pages lazily under memory pressure, older kernels lack it and drop them at once.
+	if (poolType == Internal)
+	{
+#if defined(MADV_FREE)
+		if (madvise(block, blockWithHeaderSize, MADV_FREE) != 0)
+#endif
+			madvise(block, blockWithHeaderSize, MADV_DONTNEED);
+	}
+
+	setNextIndex(block, noBlockIndex);
+	if (headIndex == noBlockIndex)
+		headIndex = index;
+	else
+		nextFreeIndex[tailIndex] = index;
+	tailIndex = index;
+}
+
+char* BlockAllocator::firstFreeBlock() const noexcept
+{
+	if (layout != HeaderLayout)
+		return headIndex == noBlockIndex ? NULL : startHeader + headIndex * blockWithHeaderSize;
+
+	return (char*)headHeader;
+}
+
+char* BlockAllocator::nextFreeBlock(char* freeBlock) const noexcept
+{
+	if (layout != HeaderLayout)
+	{
+		uint32_t next = getNextIndex(freeBlock);
+		return next == noBlockIndex ? NULL : startHeader + next * blockWithHeaderSize;
+	}
+
+	return (char*)((Block*)freeBlock)->next;
+}
+
+uint32_t BlockAllocator::getNextIndex(const char* freeBlock) const noexcept
+{
+	if (nextFreeIndex)
+		return nextFreeIndex[(freeBlock - startHeader) / blockWithHeaderSize];
+
+	uint32_t next;
+
+	// Compact blocks aren't necessarily aligned for a 32-bit access.
+	memcpy(&next, freeBlock, sizeof(next));
+	return next;
+}
+
+void BlockAllocator::setNextIndex(char* freeBlock, uint32_t next) noexcept
+{
+	if (nextFreeIndex)
+	{
+		nextFreeIndex[(freeBlock - startHeader) / blockWithHeaderSize] = next;
+		return;
+	}
+
+	memcpy(freeBlock, &next, sizeof(next));
+}
+
+void BlockAllocator::allocateAsync(AllocationCallback callback)
+{
+	void* block = allocateOrEnqueue(callback);
+
+	if (block != NULL)
+		callback(block);
+}
+
+void* BlockAllocator::allocateOrEnqueue(AllocationCallback callback)
+{
+	if (!isRecording())
+		return takeOrEnqueue(std::move(callback));
+
+	// A queued request may be served by any deallocating thread, the block is accounted right before the callback gets it.
+	AllocationCallback accounted = [this, callback](void* block)
+	{
+		recordAllocation(block, 0);
+		callback(block);
+	};
+
+	void* block = takeOrEnqueue(std::move(accounted));
+	if (block != NULL)
+		recordAllocation(block, 0);
+	return block;
+}
+
+void* BlockAllocator::takeOrEnqueue(AllocationCallback callback)
+{
+	if (freeListType == BiasedFreeList && !isOwnerThread())
+		throw NotOwnerThreadException();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (freeListType == BiasedFreeList)
+	{
+		// Same protocol as with the ring, the foreign list head plays the push position.
+		// A request is queued only after the drain, which is the release exchange of the head.
+		asyncWaitersCount.fetch_add(1, std::memory_order_relaxed);
+
+		if (headHeader == NULL)
+			drainForeignBlocks();
+
+		if (hasFreeBlock())
+		{
+			asyncWaitersCount.fetch_sub(1);
+			return popFreeBlock();
+		}
+
+		waiters.push_back(std::move(callback));
+		return NULL;
+	}
+
+	if (freeListType == RingFreeList)
+	{
+		// Announce the request and touch the push position with a release read-modify-write before looking into the ring.
+		// The pushes are read-modify-writes of the position too, so they are all ordered with this one. A push ordered
+		// before it is seen by ringPop(), which waits for a claimed slot, a push ordered after it acquires the count.
+		// The synchronous deallocate() needs no fence then, the ordering rides on the push it does anyway.
+		asyncWaitersCount.fetch_add(1, std::memory_order_relaxed);
+		ringPushPosition.fetch_add(0, std::memory_order_acq_rel);
+
+		uint32_t index;
+		if (ringPop(index))
+		{
+			asyncWaitersCount.fetch_sub(1);
+			return markRingBlockInUse(index);
+		}
+
+		waiters.push_back(std::move(callback));
+		return NULL;
+	}
+
+	if (!hasFreeBlock())
+	{
+		waiters.push_back(std::move(callback));
+		return NULL;
+	}
+
+	return popFreeBlock();
+}
+
+size_t BlockAllocator::getWaitersCount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return waiters.size();
+}
+
+void BlockAllocator::deallocateAll()
+{
+	if (freeListType == BiasedFreeList && !isOwnerThread())
+		throw NotOwnerThreadException();
+
+	std::vector<std::pair<AllocationCallback, void*>> served;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		foreignHead.store(NULL, std::memory_order_relaxed);
+		if (tags)
+		{
+			for (TagAccounting::Shard& shard : tags->shards)
+			{
+				for (size_t i = 0; i < maxTags; i++)
+				{
+					shard.live[i].store(0, std::memory_order_relaxed);
+					shard.high[i].store(0, std::memory_order_relaxed);
+				}
+			}
+		}
+
+		if (freeListType == RingFreeList)
+			resetRing();
+		else
+		{
+			headHeader = NULL;
+			headIndex = noBlockIndex;
+			tailIndex = noBlockIndex;
+			numOfRetainedFreeBlocks = 0;
+			std::fill(inUseBitmap.begin(), inUseBitmap.end(), 0);
+			untouchedIndex.store(0, std::memory_order_release);
+		}
+
+		while (!waiters.empty())
+		{
+			void* block;
+			if (freeListType == RingFreeList)
+			{
+				uint32_t index;
+				if (!ringPop(index))
+					break;
+				block = markRingBlockInUse(index);
+			}
+			else
+			{
+				if (!hasFreeBlock())
+					break;
+				block = popFreeBlock();
+			}
+
+			served.emplace_back(std::move(waiters.front()), block);
+			waiters.pop_front();
+		}
+		if (freeListType != MutexFreeList)
+			asyncWaitersCount.store(waiters.size());
+	}
+
+	for (std::pair<AllocationCallback, void*>& request : served)
+	{
+		request.first(request.second);
+	}
+}
+
+size_t BlockAllocator::trimForBudget(void* allocator)
+{
+	return ((BlockAllocator*)allocator)->trim();
+}
+
+size_t BlockAllocator::trim()
+{
+	if (poolType == External || freeListType == RingFreeList)
+		return 0;
+
+	// Only the owner may walk the free list of a biased allocator.
+	if (freeListType == BiasedFreeList && !isOwnerThread())
+		return 0;
+
+	const uintptr_t pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+	size_t released = 0;
+
+	// The free list link is kept, the header in the header layout or the next index in the compact layout.
+	// The page layout and fork-safe allocators keep their links out of the blocks.
+	const size_t linkSize = layout == CompactLayout && !nextFreeIndex ? sizeof(uint32_t) : headerSize;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	for (char* block = firstFreeBlock(); block != NULL; block = nextFreeBlock(block))
+	{
+		uintptr_t pagesStart = ((uintptr_t)block + linkSize + pageSize - 1) & ~(pageSize - 1);
+		uintptr_t pagesEnd = ((uintptr_t)block + headerSize + blockSize) & ~(pageSize - 1);
+
+		if (pagesEnd <= pagesStart)
+			continue;
+
+		if (madvise((void*)pagesStart, pagesEnd - pagesStart, MADV_DONTNEED) == 0)
+			released += pagesEnd - pagesStart;
+	}
+
+	// Blocks never allocated hold no link, they are released as one range.
+	uintptr_t untouchedStart = ((uintptr_t)(startHeader + untouchedIndex.load(std::memory_order_relaxed) * blockWithHeaderSize) + pageSize - 1) & ~(pageSize - 1);
+	uintptr_t untouchedEnd = (uintptr_t)(startHeader + maxBlocks * blockWithHeaderSize) & ~(pageSize - 1);
+
+	if (untouchedStart < untouchedEnd && madvise((void*)untouchedStart, untouchedEnd - untouchedStart, MADV_DONTNEED) == 0)
+		released += untouchedEnd - untouchedStart;
+
+	return released;
+}
+
+size_t BlockAllocator::getHeaderSize() noexcept
+{
+	return sizeof(Block*);
+}
+
+size_t BlockAllocator::getBlockSize() const noexcept
+{
+	return blockSize;
+}
+
+void BlockAllocator::deallocate(void* block)
+{
+	if (!isRecording())
+	{
+		deallocateBlock(block);
+		return;
+	}
+
+	// The origin is read while the caller still owns the block, once deallocated it may be allocated again at once.
+	BlockOrigin origin = isBlockAddress(block) ? getBlockOrigin(block) : BlockOrigin();
+	deallocateBlock(block);
+	recordDeallocation(origin);
+}
+
+void BlockAllocator::deallocateBlock(void* block)
+{
+	if (freeListType == BiasedFreeList)
+	{
+		deallocateBiased(block);
+		return;
+	}
+
+	if (freeListType == RingFreeList)
+	{
+		deallocateToRing(block);
+		return;
+	}
+
+	AllocationCallback waiter;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!isBlockInUse(block))
+		{
+			throw InvalidBlockAddressException();
+		}
+
+		if (waiters.empty())
+		{
+			pushFreeBlock(block);
+			return;
+		}
+
+		// The block stays marked as in use and goes straight to the oldest request.
+		waiter = std::move(waiters.front());
+		waiters.pop_front();
+	}
+	waiter(block);
+}
+
+void BlockAllocator::deallocate(void* const* blocks, size_t numOfBlocks)
+{
+	// Tags, remote frees and lifetimes are recorded block by block.
+	if (freeListType != MutexFreeList || isRecording())
+	{
+		for (size_t i = 0; i < numOfBlocks; i++)
+		{
+			deallocate(blocks[i]);
+		}
+		return;
+	}
+
+	std::vector<std::pair<AllocationCallback, void*>> served;
+	bool isInvalid = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (size_t i = 0; i < numOfBlocks; i++)
+		{
+			if (!isBlockInUse(blocks[i]))
+			{
+				isInvalid = true;
+				break;
+			}
+
+			if (waiters.empty())
+			{
+				pushFreeBlock(blocks[i]);
+				continue;
+			}
+
+			served.emplace_back(std::move(waiters.front()), blocks[i]);
+			waiters.pop_front();
+		}
+	}
+
+	// Requests are served even if an invalid address stopped the batch, their blocks were already taken.
+	for (std::pair<AllocationCallback, void*>& request : served)
+	{
+		request.first(request.second);
+	}
+
+	if (isInvalid)
+		throw InvalidBlockAddressException();
+}
+
+bool BlockAllocator::isBlockInUse(void* block) const noexcept
+{
+	if (!isBlockAddress(block))
+		return false;
+
+	if (freeListType == RingFreeList)
+	{
+		size_t index = ((char*)block - headerSize - startHeader) / blockWithHeaderSize;
+		return (ringInUseBitmap[index / 64].load(std::memory_order_acquire) >> (index % 64)) & 1;
+	}
+
+	if (layout != HeaderLayout)
+	{
+		size_t index = ((char*)block - startHeader) / blockWithHeaderSize;
+		return (inUseBitmap[index / 64] >> (index % 64)) & 1;
+	}
+
+	// Headers of blocks never allocated hold no flag yet.
+	size_t untouched = untouchedIndex.load(std::memory_order_acquire);
+	if (untouched < maxBlocks && (char*)block - headerSize >= startHeader + untouched * blockWithHeaderSize)
+		return false;
+
+	Block* header = (Block*)((char*)block - headerSize);
+	if (header->next == blockInUseFlag)
+		return true;
+
+	return false;
+}
+
+bool BlockAllocator::isBlockAddress(void* block) const noexcept
+{
+	char* header = (char*)block - headerSize;
+
+	if (block == NULL || header > endHeader || header < startHeader)
+		return false;
+
+	size_t reminder = (size_t)(header - startHeader) % blockWithHeaderSize;
+
+	if (reminder == 0)
+		return true;
+
+	return false;
+}
+
+size_t BlockAllocator::getBlockIndex(void* block) const
+{
+	if (!isBlockAddress(block))
+		throw InvalidBlockAddressException();
+
+	return ((char*)block - headerSize - startHeader) / blockWithHeaderSize;
+}
+
+void* BlockAllocator::getBlockAddress(size_t index) const
+{
+	if (index >= maxBlocks)
+		throw InvalidBlockAddressException();
+
+	return startHeader + index * blockWithHeaderSize + headerSize;
+}
+
+size_t BlockAllocator::getNumOfBlocks() const noexcept
+{
+	return maxBlocks;
+}
+
+BlockAllocator* BlockAllocator::createInPool(size_t size, size_t blocks, void* memory, size_t memoryByteSize, const Config& config)
+{
+	static_assert(alignof(BlockAllocator) <= alignof(std::max_align_t), "The allocator must fit the alignment getRequiredPoolSize() assumes");
+
+	// The CompactLayout bitmap, the RingFreeList slots and the tracking side arrays live on the heap.
+	if (memory == NULL || config.layout != HeaderLayout || config.freeList == RingFreeList || config.tagging
+			|| config.remoteFreeSampling != 0 || config.lifetimeTracking)
+		throw InvalidConstructorParametersException();
+
+	const uintptr_t alignment = alignof(std::max_align_t);
+	uintptr_t start = (uintptr_t)memory;
+	size_t padding = (size_t)(((start + alignment - 1) & ~(alignment - 1)) - start);
+
+	if (memoryByteSize < padding + getControlBlockSize())
+		throw InvalidConstructorParametersException();
+
+	size_t blocksByteSize = memoryByteSize - padding - getControlBlockSize();
+	size_t blockWithHeader = size + getHeaderSize();
+	if (blocks == 0 || blockWithHeader < size || blocks > blocksByteSize / blockWithHeader)
+		throw InvalidConstructorParametersException();
+
+	char* control = (char*)memory + padding;
+	return new (control) BlockAllocator(size, blocks, config, control + getControlBlockSize());
+}
+
+BlockAllocator* BlockAllocator::createInPool(size_t size, size_t blocks, void* memory, size_t memoryByteSize)
+{
+	return createInPool(size, blocks, memory, memoryByteSize, Config());
+}
+
+void BlockAllocator::destroyInPool(BlockAllocator* allocator) noexcept
+{
+	allocator->~BlockAllocator();
+}
+
+BlockAllocator::~BlockAllocator()
+{
+	// Released first, the budget may be trimming the allocator right now and is waited for.
+	budgetCharge.releaseAll();
+
+	if (isForkSafe)
+		unregisterForFork();
+
+	releasePool();
+}
+
+void BlockAllocator::releasePool() noexcept
+{
+	budgetCharge.releaseAll();
+
+	if (poolType == Internal && startHeader != NULL)
+	{
+		if (layout == PageLayout)
+			munmap(startHeader, blockWithHeaderSize * maxBlocks);
+		else
+			std::free(startHeader);
+		startHeader = NULL;
+	}
+}
+
+BlockAllocator::LayoutType BlockAllocator::getLayout() const noexcept
+{
+	return layout;
+}
+
+BlockAllocator::FreeListType BlockAllocator::getFreeListType() const noexcept
+{
+	return freeListType;
+}
+
+BlockAllocator::MemoryPoolType BlockAllocator::getPoolType() const noexcept
+{
+	return poolType;
+}
+
+BlockAllocator::MemoryOverhead BlockAllocator::getMemoryOverhead() const noexcept
+{
+	MemoryOverhead overhead;
+
+	overhead.payloadBytes = blockSize * maxBlocks;
+	overhead.headerBytes = headerSize * maxBlocks;
+	overhead.paddingBytes = (blockWithHeaderSize - blockSize - headerSize) * maxBlocks;
+	overhead.sideTableBytes = inUseBitmap.size() * sizeof(uint64_t);
+	if (nextFreeIndex)
+		overhead.sideTableBytes += maxBlocks * sizeof(uint32_t);
+	if (freeListType == RingFreeList)
+		overhead.sideTableBytes += (ringMask + 1) * sizeof(RingCell) + (maxBlocks + 63) / 64 * sizeof(uint64_t);
+	if (tags)
+		overhead.sideTableBytes += sizeof(TagAccounting) + maxBlocks * sizeof(Tag);
+	if (remoteFrees)
+		overhead.sideTableBytes += sizeof(RemoteFreeTracking) + maxBlocks * sizeof(uint8_t);
+	if (lifetimes)
+		overhead.sideTableBytes += sizeof(LifetimeTracking) + maxBlocks * sizeof(std::atomic<uint64_t>);
+	overhead.controlBytes = sizeof(BlockAllocator);
+	overhead.systemSlackBytes = 0;
+
+#if defined(__GLIBC__)
+	if (poolType == Internal && layout != PageLayout)
+		overhead.systemSlackBytes = malloc_usable_size(startHeader) - blockWithHeaderSize * maxBlocks;
+#endif
+
+	return overhead;
+}
+
+void BlockAllocator::registerTag(Tag tag, const std::string& name)
+{
+	if (!tags || tag >= maxTags)
+		throw InvalidTagException();
+
+	std::lock_guard<std::mutex> lock(tags->namesMutex);
+	tags->names[tag] = name;
+	tags->isRegistered[tag].store(true, std::memory_order_release);
+}
+
+std::vector<BlockAllocator::TagUsage> BlockAllocator::getTagUsage()
+{
+	std::vector<TagUsage> usage;
+	if (!tags)
+		return usage;
+
+	std::lock_guard<std::mutex> lock(tags->namesMutex);
+	for (size_t i = 0; i < maxTags; i++)
+	{
+		if (!tags->isRegistered[i].load(std::memory_order_relaxed))
+			continue;
+
+		int64_t live = tags->sumLive((Tag)i);
+		tags->updatePeak((Tag)i, live);
+
+		TagUsage tagUsage;
+		tagUsage.tag = (Tag)i;
+		tagUsage.name = tags->names[i];
+		tagUsage.liveBlocks = live > 0 ? (size_t)live : 0;
+		tagUsage.peakBlocks = tags->peaks[i].load(std::memory_order_relaxed);
+		usage.push_back(tagUsage);
+	}
+
+	return usage;
+}
+
+void BlockAllocator::recordAllocation(void* block, Tag tag) noexcept
+{
+	size_t index = ((char*)block - headerSize - startHeader) / blockWithHeaderSize;
+
+	if (lifetimes)
+		lifetimes->allocatedAt[index].store(coarseNowMs(), std::memory_order_relaxed);
+
+	// Only every sampling-th allocation of a thread records its thread slot, the others are marked as not sampled.
+	if (remoteFrees)
+	{
+		// Threads aliasing a slot may race on the countdown, which only shifts which of their allocations are sampled.
+		size_t slot = getThreadSlot();
+		std::atomic<size_t>& countdown = remoteFrees->countdowns[slot].left;
+		size_t left = countdown.load(std::memory_order_relaxed);
+		if (left == 0)
+		{
+			countdown.store(remoteFrees->samplingPeriod - 1, std::memory_order_relaxed);
+			remoteFrees->allocatingThread[index] = (uint8_t)slot;
+		}
+		else
+		{
+			countdown.store(left - 1, std::memory_order_relaxed);
+			remoteFrees->allocatingThread[index] = RemoteFreeTracking::notSampled;
+		}
+	}
+
+	if (!tags)
+		return;
+
+	tags->blockTags[index] = tag;
+
+	TagAccounting::Shard& shard = tags->shards[currentTagShard()];
+	int64_t live = shard.live[tag].fetch_add(1, std::memory_order_relaxed) + 1;
+
+	// Shards are summed only when this one grows past its own high, steady allocation and deallocation stays shard local.
+	int64_t high = shard.high[tag].load(std::memory_order_relaxed);
+	if (live > high && shard.high[tag].compare_exchange_strong(high, live, std::memory_order_relaxed))
+		tags->updatePeak(tag, tags->sumLive(tag));
+}
+
+BlockAllocator::BlockOrigin BlockAllocator::getBlockOrigin(void* block) const noexcept
+{
+	size_t index = ((char*)block - headerSize - startHeader) / blockWithHeaderSize;
+	BlockOrigin origin;
+
+	if (tags)
+		origin.tag = tags->blockTags[index];
+	if (remoteFrees)
+		origin.thread = remoteFrees->allocatingThread[index];
+	if (lifetimes)
+		origin.allocatedAt = lifetimes->allocatedAt[index].load(std::memory_order_relaxed);
+	return origin;
+}
+
+void BlockAllocator::recordDeallocation(const BlockOrigin& origin) noexcept
+{
+	if (tags)
+		tags->shards[currentTagShard()].live[origin.tag].fetch_sub(1, std::memory_order_relaxed);
+
+	if (remoteFrees && origin.thread != RemoteFreeTracking::notSampled)
+		remoteFrees->transfers[origin.thread * maxTrackedThreads + getThreadSlot()].fetch_add(1, std::memory_order_relaxed);
+
+	if (lifetimes)
+		lifetimes->histogram[lifetimeBucket(coarseNowMs() - origin.allocatedAt)].fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t BlockAllocator::getThreadSlot() noexcept
+{
+	static std::atomic<size_t> nextSlot(0);
+	static thread_local size_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed) % maxTrackedThreads;
+
+	return slot;
+}
+
+BlockAllocator::RemoteFreeStats BlockAllocator::getRemoteFreeStats() const
+{
+	RemoteFreeStats stats;
+	stats.sampledFrees = 0;
+	stats.remoteFrees = 0;
+	if (!remoteFrees)
+		return stats;
+
+	stats.transfers.assign(maxTrackedThreads, std::vector<uint64_t>(maxTrackedThreads, 0));
+	for (size_t from = 0; from < maxTrackedThreads; from++)
+	{
+		for (size_t to = 0; to < maxTrackedThreads; to++)
+		{
+			uint64_t count = remoteFrees->transfers[from * maxTrackedThreads + to].load(std::memory_order_relaxed);
+
+			stats.transfers[from][to] = count;
+			stats.sampledFrees += count;
+			if (from != to)
+				stats.remoteFrees += count;
+		}
+	}
+
+	return stats;
+}
+
+// Quotes a string for JSON.
+static std::string quoted(const std::string& text)
+{
+	std::string result = "\"";
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\')
+		{
+			result += '\\';
+			result += c;
+		}
+		else if ((unsigned char)c < 0x20)
+		{
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned)(unsigned char)c);
+			result += escaped;
+		}
+		else
+			result += c;
+	}
+	return result + "\"";
+}
+
+std::vector<uint64_t> BlockAllocator::copyUsedBitmap(size_t& untouched, size_t& waitersCount)
+{
+	// Allocated before taking the lock, so the lock is held only for the copy.
+	std::vector<uint64_t> used((maxBlocks + 63) / 64, 0);
+	untouched = 0;
+
+	if (freeListType == RingFreeList)
+	{
+		for (size_t i = 0; i < used.size(); i++)
+		{
+			used[i] = ringInUseBitmap[i].load(std::memory_order_acquire);
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	waitersCount = waiters.size();
+
+	if (freeListType != RingFreeList)
+	{
+		size_t touched = untouchedIndex.load(std::memory_order_relaxed);
+		untouched = maxBlocks - touched;
+
+		if (layout != HeaderLayout)
+			std::copy(inUseBitmap.begin(), inUseBitmap.end(), used.begin());
+		else
+		{
+			for (size_t i = 0; i < touched; i++)
+			{
+				if (((Block*)(startHeader + i * blockWithHeaderSize))->next == blockInUseFlag)
+					used[i / 64] |= (uint64_t)1 << (i % 64);
+			}
+		}
+	}
+
+	return used;
+}
+
+void BlockAllocator::dumpState(std::ostream& out)
+{
+	size_t untouched;
+	size_t waitersCount;
+	std::vector<uint64_t> used = copyUsedBitmap(untouched, waitersCount);
+
+	size_t usedBlocks = 0;
+	std::string runs;
+	for (size_t i = 0; i < maxBlocks;)
+	{
+		if (((used[i / 64] >> (i % 64)) & 1) == 0)
+		{
+			++i;
+			continue;
+		}
+
+		size_t first = i;
+		while (i < maxBlocks && ((used[i / 64] >> (i % 64)) & 1) != 0)
+		{
+			++i;
+		}
+		runs += (runs.empty() ? "[" : ", [") + std::to_string(first) + ", " + std::to_string(i - first) + "]";
+		usedBlocks += i - first;
+	}
+
+	static const char* const layoutNames[] = {"header", "compact", "page"};
+	static const char* const freeListNames[] = {"mutex", "ring", "biased"};
+
+	out << "{\n  \"geometry\": {\"blockSize\": " << blockSize << ", \"maxBlocks\": " << maxBlocks
+			<< ", \"headerSize\": " << headerSize << ", \"stride\": " << blockWithHeaderSize
+			<< ", \"poolType\": \"" << (poolType == Internal ? "internal" : "external")
+			<< "\", \"layout\": \"" << layoutNames[layout] << "\", \"freeList\": \"" << freeListNames[freeListType] << "\"},\n";
+
+	out << "  \"stats\": {\"usedBlocks\": " << usedBlocks << ", \"freeBlocks\": " << maxBlocks - usedBlocks
+			<< ", \"untouchedBlocks\": " << untouched << ", \"waiters\": " << waitersCount
+			<< ", \"totalBytes\": " << getMemoryOverhead().totalBytes() << "},\n";
+
+	out << "  \"usedRuns\": [" << runs << "],\n";
+
+	if (remoteFrees)
+	{
+		RemoteFreeStats stats = getRemoteFreeStats();
+		out << "  \"remoteFrees\": {\"sampling\": " << remoteFrees->samplingPeriod << ", \"sampledFrees\": " << stats.sampledFrees
+				<< ", \"remoteFrees\": " << stats.remoteFrees << "},\n";
+	}
+
+	if (lifetimes)
+	{
+		std::vector<uint64_t> histogram = getLifetimeHistogram();
+		out << "  \"lifetimeHistogram\": [";
+		for (size_t i = 0; i < histogram.size(); i++)
+		{
+			out << (i == 0 ? "" : ", ") << histogram[i];
+		}
+		out << "],\n";
+	}
+
+	out << "  \"tags\": [";
+	std::vector<TagUsage> usage = getTagUsage();
+	for (size_t i = 0; i < usage.size(); i++)
+	{
+		out << (i == 0 ? "\n" : ",\n") << "    {\"tag\": " << (unsigned)usage[i].tag << ", \"name\": " << quoted(usage[i].name)
+				<< ", \"liveBlocks\": " << usage[i].liveBlocks << ", \"peakBlocks\": " << usage[i].peakBlocks << "}";
+	}
+	out << (usage.empty() ? "]\n}\n" : "\n  ]\n}\n");
+}
+
+std::vector<uint64_t> BlockAllocator::getLifetimeHistogram() const
+{
+	std::vector<uint64_t> histogram;
+	if (!lifetimes)
+		return histogram;
+
+	for (const std::atomic<uint64_t>& count : lifetimes->histogram)
+	{
+		histogram.push_back(count.load(std::memory_order_relaxed));
+	}
+	return histogram;
+}
+
+std::vector<BlockAllocator::LiveBlock> BlockAllocator::getOldestBlocks(size_t count)
+{
+	std::vector<LiveBlock> blocks;
+	if (!lifetimes || count == 0)
+		return blocks;
+
+	size_t untouched;
+	size_t waitersCount;
+	std::vector<uint64_t> used = copyUsedBitmap(untouched, waitersCount);
+	uint64_t now = coarseNowMs();
+
+	for (size_t index = 0; index < maxBlocks; index++)
+	{
+		if (used[index / 64] == 0)
+		{
+			index += 63 - index % 64;
+			continue;
+		}
+
+		if (((used[index / 64] >> (index % 64)) & 1) != 0)
+		{
+			LiveBlock block;
+			block.index = index;
+			block.block = startHeader + index * blockWithHeaderSize + headerSize;
+			uint64_t allocatedAt = lifetimes->allocatedAt[index].load(std::memory_order_relaxed);
+			block.ageMs = now > allocatedAt ? now - allocatedAt : 0;
+			blocks.push_back(block);
+		}
+	}
+
+	count = std::min(count, blocks.size());
+	std::partial_sort(blocks.begin(), blocks.begin() + count, blocks.end(), [](const LiveBlock& a, const LiveBlock& b)
+	{
+		return a.ageMs > b.ageMs || (a.ageMs == b.ageMs && a.index < b.index);
+	});
+	blocks.resize(count);
+
+	return blocks;
 }
@@ -6,9 +6,22 @@
 
 //! @{
 #include <stdint.h>
+#include <atomic>
+#include <cstddef>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <list>
+#include <string>
+#include <vector>
+#include <functional>
+#include <iosfwd>
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
 
 #include "blockAllocatorExceptions.h"
+#include "memoryBudget.h"
 
 //! This class implements a simple thread-safe block memory allocator.
 class BlockAllocator
@@ -62,6 +75,157 @@ public:
 		External
 	};
 
+	//! \brief Represents how the allocator keeps its metadata.
+	enum LayoutType
+	{
+		//! Every block is preceded by a pointer sized header, which links free blocks and marks used ones.
+		HeaderLayout,
+		//! Blocks have no header, a free block holds the 32-bit index of the next free block and used blocks are marked in a bitmap.
+		//! Blocks smaller than a pointer are possible, down to the index size.
+		CompactLayout,
+		//! For blocks of at least a page, every block starts on a page boundary and spans whole pages.
+		//! Nothing is written into the blocks, the free list and the used block bits live in side arrays,
+		//! so a free block whose pages were released stays released until it's allocated again.
+		//! Once more than Config::retainedFreeBlocks blocks are free, the pages of a deallocated block are released with MADV_FREE
+		//! and the block goes to the tail of the free list, the retained blocks are reused first.
+		//! The internal pool is mapped page aligned, an external pool must be page aligned and is never released.
+		//! Requires the MutexFreeList.
+		PageLayout
+	};
+
+	//! \brief Represents how free blocks are kept and synchronized.
+	enum FreeListType
+	{
+		//! A LIFO linked list guarded by a mutex.
+		MutexFreeList,
+		//! A lock-free bounded MPMC ring of 32-bit block indices, blocks are reused in FIFO order.
+		//! Used blocks are marked in an atomic bitmap, nothing is written into the blocks.
+		//! \warning trim() does nothing, a free block can't be told apart from one being allocated concurrently.
+		RingFreeList,
+		//! Owned by one thread, which allocates and deallocates with plain loads and stores, without any lock.
+		//! Other threads may only deallocate, their blocks are pushed to a lock-free list the owner drains when its own list runs empty.
+		//! The constructing thread is the initial owner, see transferOwnership() and claimOwnership().
+		//! Requires the HeaderLayout, foreign threads check the block header to reject invalid deallocations.
+		BiasedFreeList
+	};
+
+	//! \brief Allocator settings chosen at construction.
+	struct Config
+	{
+		//! \brief The metadata layout, HeaderLayout by default.
+		LayoutType layout = HeaderLayout;
+
+		//! \brief The free list engine, MutexFreeList by default.
+		FreeListType freeList = MutexFreeList;
+
+		//! \brief Links blocks to the free list on their first allocation instead of in the constructor, false by default.
+		//! The constructor then takes constant time and never touches the pool memory. Ignored by the RingFreeList.
+		bool lazyFreeList = false;
+
+		//! \brief Keeps per tag live and peak block counters and the tag of every block, false by default.
+		//! Costs one byte per block and a few kilobytes of counters. See registerTag().
+		bool tagging = false;
+
+		//! \brief Records the allocating thread of every n-th allocation a thread makes from the allocator, to measure how many blocks other threads free, 0 by default.
+		//! 0 disables the tracking, 1 records every allocation. Costs one byte per block, a thread to thread counter matrix and a countdown per thread slot.
+		//! See getRemoteFreeStats().
+		size_t remoteFreeSampling = 0;
+
+		//! \brief Stamps every block with a coarse allocation time, for the lifetime histogram and getOldestBlocks(), false by default.
+		//! Costs 8 bytes per block and a clock read per allocation and deallocation.
+		bool lifetimeTracking = false;
+
+		//! \brief The number of free blocks of the PageLayout keeping their pages, 0 by default.
+		//! 0 releases the pages of every deallocated block, each release is a system call made under the lock.
+		size_t retainedFreeBlocks = 0;
+
+		//! \brief Keeps the allocator from writing into the pool for its own needs, for pools built before fork() and shared with the children, false by default.
+		//! The free list links move to a side array, so allocating and deallocating never dirty a shared payload page and only pages written
+		//! by the user are copied. The allocator locks are taken around fork(), so a child never inherits a lock held by another thread.
+		//! Requires the CompactLayout or the PageLayout, costs 4 bytes per block with the CompactLayout.
+		bool forkSafe = false;
+	};
+
+	//! \brief Breakdown of the memory used by the allocator, in bytes.
+	struct MemoryOverhead
+	{
+		//! \brief Memory usable by the user, block size times the number of blocks.
+		size_t payloadBytes;
+		//! \brief Per block headers.
+		size_t headerBytes;
+		//! \brief Alignment padding between blocks.
+		size_t paddingBytes;
+		//! \brief Metadata kept outside the blocks, e.g. bitmaps.
+		size_t sideTableBytes;
+		//! \brief The allocator object itself.
+		size_t controlBytes;
+		//! \brief Memory the system allocator reserved above the requested pool size, zero for external pools.
+		size_t systemSlackBytes;
+
+		//! \brief Returns the sum of all parts.
+		size_t totalBytes() const noexcept
+		{
+			return payloadBytes + headerBytes + paddingBytes + sideTableBytes + controlBytes + systemSlackBytes;
+		}
+	};
+
+	//! \brief Small integer id of an object type, blocks allocated with a tag are accounted to it.
+	typedef uint8_t Tag;
+
+	//! \brief The number of tags, tag 0 is registered as "untagged" and counts blocks allocated without a tag.
+	static const size_t maxTags = 64;
+
+	//! \brief Usage of the blocks of one tag.
+	struct TagUsage
+	{
+		//! \brief The tag.
+		Tag tag;
+		//! \brief The name the tag was registered with.
+		std::string name;
+		//! \brief The number of blocks allocated with the tag and not deallocated yet.
+		size_t liveBlocks;
+		//! \brief The highest number of live blocks seen.
+		size_t peakBlocks;
+	};
+
+	//! \brief The number of thread slots of the remote free telemetry, threads share slots round robin beyond it.
+	static const size_t maxTrackedThreads = 32;
+
+	//! \brief Frees of sampled blocks, split by the allocating and the deallocating thread.
+	struct RemoteFreeStats
+	{
+		//! \brief The number of sampled blocks freed.
+		uint64_t sampledFrees;
+		//! \brief The number of sampled blocks freed by another thread slot than the one which allocated them.
+		uint64_t remoteFrees;
+		//! \brief Sampled frees, indexed by the allocating and then the deallocating thread slot, see getThreadSlot().
+		std::vector<std::vector<uint64_t>> transfers;
+
+		//! \brief Returns the share of remote frees among the sampled ones, 0 if none were sampled.
+		double remoteRatio() const noexcept
+		{
+			return sampledFrees == 0 ? 0 : (double)remoteFrees / sampledFrees;
+		}
+	};
+
+	//! \brief The number of lifetime histogram buckets.
+	//! Bucket 0 counts blocks freed within 1 ms, bucket i those freed within [2^(i-1), 2^i) ms, the last bucket all longer lifetimes.
+	static const size_t numOfLifetimeBuckets = 40;
+
+	//! \brief A block in use and its age.
+	struct LiveBlock
+	{
+		//! \brief The block address.
+		void* block;
+		//! \brief The block index.
+		size_t index;
+		//! \brief The time since the block was allocated in milliseconds, with the resolution of the coarse clock.
+		uint64_t ageMs;
+	};
+
+	//! \brief Callback type used to hand a block to an asynchronous allocation request.
+	typedef std::function<void(void*)> AllocationCallback;
+
 	//! \brief BlockAllocator constructor.
 
 	//! If invalid parameters were passed e.g. numOfBlocks=0 or size=0 the constructor will throw BlockAllocatorExceptions::InvalidConstructorParametersException.
@@ -75,6 +239,7 @@ public:
 	//! \param[in] memoryPool An address of an external memory pool.
 	//! \throw BlockAllocatorExceptions::InvalidConstructorParametersException If invalid constructor parameters were passed.
 	//! \throw BlockAllocatorExceptions::OutOfSystemMemoryException If no memory poll pointer was passed and system can't provide enough memory.
+	//! \throw BlockAllocatorExceptions::MemoryBudgetExceededException If no memory poll pointer was passed and the pool doesn't fit the MemoryBudget.
 	//! ### Example
 	//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
 	//! size_t blockByteSize = 32;
@@ -85,6 +250,69 @@ public:
 	//! ~~~~~~~~~~~~~~~~~~~~~~~
 	BlockAllocator(size_t blockByteSize, size_t numOfBlocks, void* memoryPool = NULL);
 
+	//! \brief BlockAllocator constructor with explicit settings.
+
+	//! Behaves as the constructor above, the settings select the layout.
+	//! \warning An external memory pool for the CompactLayout needs max(block size, 4) * (number of blocks) bytes.
+	//! \param[in] blockByteSize A selected block size in bytes, must be greater than 0.
+	//! \param[in] numOfBlocks A desired quantity of blocks, must be greater than 0 and less than 2^32 - 1 for the CompactLayout.
+	//! \param[in] config The allocator settings.
+	//! \param[in] memoryPool An address of an external memory pool.
+	//! \throw BlockAllocatorExceptions::InvalidConstructorParametersException If invalid constructor parameters were passed.
+	//! \throw BlockAllocatorExceptions::OutOfSystemMemoryException If no memory poll pointer was passed and system can't provide enough memory.
+	//! \throw BlockAllocatorExceptions::MemoryBudgetExceededException If no memory poll pointer was passed and the pool doesn't fit the MemoryBudget.
+	//! ### Example
+	//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
+	//! BlockAllocator::Config config;
+	//! config.layout = BlockAllocator::CompactLayout;
+	//!
+	//! BlockAllocator ba {8, 1024, config};
+	//! ~~~~~~~~~~~~~~~~~~~~~~~
+	BlockAllocator(size_t blockByteSize, size_t numOfBlocks, const Config& config, void* memoryPool = NULL);
+
+	//! \brief Places an allocator and its blocks in one caller provided buffer, e.g. a static array or a mapped segment.
+
+	//! The allocator object is put at the start of the buffer, aligned as std::max_align_t, and the blocks follow it.
+	//! Neither the allocator nor its blocks take memory from the heap. Later on tryAllocate() and deallocate() of a valid block
+	//! are the only heap-free paths, allocate() throws once the pool is exhausted and a thrown exception is allocated from the heap.
+	//! The layout and engines keeping side tables, the CompactLayout and the RingFreeList, aren't supported.
+	//! The allocator reports an External pool and must be destroyed by destroyInPool(), the buffer is never freed.
+	//! \param[in] blockByteSize A selected block size in bytes, must be greater than 0.
+	//! \param[in] numOfBlocks A desired quantity of blocks, must be greater than 0.
+	//! \param[in] memory The buffer start.
+	//! \param[in] memoryByteSize The buffer size, at least getRequiredPoolSize() for the buffer alignment.
+	//! \param[in] config The allocator settings.
+	//! \return Returns the allocator, it lives at the start of the buffer.
+	//! \throw BlockAllocatorExceptions::InvalidConstructorParametersException If invalid parameters were passed or the buffer is too small.
+	//! ### Example
+	//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
+	//! alignas(std::max_align_t) static char buffer[BlockAllocator::getRequiredPoolSize(32, 64)];
+	//!
+	//! BlockAllocator* ba = BlockAllocator::createInPool(32, 64, buffer, sizeof(buffer));
+	//! ...
+	//! BlockAllocator::destroyInPool(ba);
+	//! ~~~~~~~~~~~~~~~~~~~~~~~
+	static BlockAllocator* createInPool(size_t blockByteSize, size_t numOfBlocks, void* memory, size_t memoryByteSize, const Config& config);
+
+	//! \brief Places an allocator with the default settings in a caller provided buffer.
+	//! \sa createInPool(size_t, size_t, void*, size_t, const Config&)
+	static BlockAllocator* createInPool(size_t blockByteSize, size_t numOfBlocks, void* memory, size_t memoryByteSize);
+
+	//! \brief Destroys an allocator created by createInPool(), the buffer may be reused afterwards.
+	//! \param[in] allocator The allocator returned by createInPool().
+	static void destroyInPool(BlockAllocator* allocator) noexcept;
+
+	//! \brief Returns the buffer size createInPool() needs, usable in constant expressions.
+	//! \param[in] blockByteSize The block size in bytes.
+	//! \param[in] numOfBlocks The number of blocks.
+	//! \param[in] alignment The guaranteed alignment of the buffer start, a power of two. A less aligned buffer needs padding in front of the allocator.
+	//! \return Returns the buffer size in bytes.
+	static constexpr size_t getRequiredPoolSize(size_t blockByteSize, size_t numOfBlocks, size_t alignment = alignof(std::max_align_t)) noexcept
+	{
+		return (alignment < alignof(std::max_align_t) ? alignof(std::max_align_t) - alignment : 0) + getControlBlockSize()
+				+ numOfBlocks * (blockByteSize + sizeof(Block*));
+	}
+
 	//! \brief Deleted copy constructor
 	BlockAllocator(const BlockAllocator&) = delete;
 
@@ -119,6 +347,107 @@ public:
 	//! ~~~~~~~~~~~~~~~~~~~~~~~
 	void* allocate();
 
+	//! \brief Returns first free block address and accounts the block to a tag.
+
+	//! Behaves as allocate() if Config::tagging isn't set.
+	//! \param[in] tag A tag registered by registerTag().
+	//! \return Returns a pointer to a new block.
+	//! \throw BlockAllocatorExceptions::InvalidTagException If tagging is enabled and the tag isn't registered.
+	//! \throw BlockAllocatorExceptions::OutOfAllocatableMemoryException If no more empty blocks are available.
+	void* allocate(Tag tag);
+
+	//! \brief Returns a free block without throwing.
+
+	//! Never allocates from the heap, unlike a thrown exception, so it suits pools which must not touch the heap at all.
+	//! \return Returns a pointer to a new block, or NULL if no block is free or the calling thread doesn't own a BiasedFreeList allocator.
+	void* tryAllocate() noexcept;
+
+	//! \brief Requests a block without throwing when the pool is exhausted.
+
+	//! If a free block is available the callback is invoked at once in the calling thread.
+	//! Otherwise the request is queued and the callback is invoked later from the thread which calls deallocate().
+	//! Queued requests are served in FIFO order, a deallocated block is handed to the oldest request directly, bypassing the free list.
+	//! The callback is always invoked without the allocator lock held, so it may call allocate() or deallocate() itself.
+	//! \param[in] callback A function which receives the allocated block.
+	//! \warning Requests still queued when the allocator is destroyed are dropped without being invoked.
+
+	//! ### Example
+	//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
+	//! ba.allocateAsync([](void* block)
+	//! {
+	//! 	...
+	//! });
+	//! ~~~~~~~~~~~~~~~~~~~~~~~
+	void allocateAsync(AllocationCallback callback);
+
+#if defined(__cpp_impl_coroutine)
+	//! \brief Awaitable returned by allocateAsync(), available when compiled as C++20.
+
+	//! The awaiting coroutine continues at once if a free block is available.
+	//! Otherwise it is suspended and resumed from the thread which deallocates the block it receives.
+	class AllocationAwaiter
+	{
+	public:
+		//! \brief Creates an awaiter bound to the allocator.
+		//! \param[in] owner The allocator to request a block from.
+		explicit AllocationAwaiter(BlockAllocator& owner) noexcept :
+			allocator(owner)
+		{}
+
+		//! \brief Always tries the allocator in await_suspend() so the check and the queueing happen under one lock.
+		bool await_ready() const noexcept
+		{
+			return false;
+		}
+
+		//! \brief Takes a free block or queues the coroutine.
+		//! \return Returns false if a block was taken and the coroutine must not be suspended.
+		bool await_suspend(std::coroutine_handle<> handle)
+		{
+			void* taken = allocator.allocateOrEnqueue([this, handle](void* readyBlock)
+			{
+				block = readyBlock;
+				handle.resume();
+			});
+
+			// Once queued, a deallocating thread may resume the coroutine and destroy the awaiter at any moment, no member is touched.
+			if (taken == NULL)
+				return true;
+
+			block = taken;
+			return false;
+		}
+
+		//! \brief Returns the allocated block.
+		void* await_resume() const noexcept
+		{
+			return block;
+		}
+
+	private:
+		//! \brief The allocator the block is requested from.
+		BlockAllocator& allocator;
+
+		//! \brief The block handed to the coroutine.
+		void* block = NULL;
+	};
+
+	//! \brief Requests a block from a coroutine.
+
+	//! ### Example
+	//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
+	//! void* block = co_await ba.allocateAsync();
+	//! ~~~~~~~~~~~~~~~~~~~~~~~
+	AllocationAwaiter allocateAsync() noexcept
+	{
+		return AllocationAwaiter(*this);
+	}
+#endif
+
+	//! \brief Returns the number of queued asynchronous allocation requests.
+	//! \return The number of requests waiting for a free block.
+	size_t getWaitersCount();
+
 	//! \brief Tries to deallocate a block with passed address.
 
 	//! \param[in] Block's address to deallocate.
@@ -140,6 +469,34 @@ public:
 	//! ~~~~~~~~~~~~~~~~~~~~~~~
 	void deallocate(void* block);
 
+	//! \brief Deallocates a batch of blocks, taking the lock once.
+
+	//! Blocks are returned in the passed order, queued asynchronous requests are served first.
+	//! The RingFreeList and BiasedFreeList deallocate the blocks one by one, they take no lock anyway.
+	//! \param[in] blocks The addresses of the blocks.
+	//! \param[in] numOfBlocks The number of addresses.
+	//! \throw BlockAllocatorExceptions::InvalidBlockAddressException Thrown at the first invalid address, the blocks before it are deallocated.
+	void deallocate(void* const* blocks, size_t numOfBlocks);
+
+	//! \brief Returns every block to the allocator at once.
+
+	//! Takes constant time for the HeaderLayout, the free list is emptied and all blocks are handed out in address order again as with Config::lazyFreeList.
+	//! Queued asynchronous requests are served from the freed blocks.
+	//! \warning Every previously allocated block becomes invalid, the caller must make sure no other thread uses the allocator meanwhile.
+	//! \throw BlockAllocatorExceptions::NotOwnerThreadException If the calling thread doesn't own a BiasedFreeList allocator.
+	void deallocateAll();
+
+	//! \brief Releases the physical pages held by free blocks back to the system.
+
+	//! Only whole pages lying inside the payload of a free block are released, block headers are kept, so the free list stays intact.
+	//! PageLayout blocks hold no link, they are released whole.
+	//! Released pages are refaulted as zero pages when their blocks are allocated again.
+	//! Blocks smaller than a page usually hold no whole page, so trimming is meaningful for page-sized and larger blocks.
+	//! External pools are never trimmed, their memory belongs to the caller.
+	//! Blocks never allocated since construction or deallocateAll() are released as one range.
+	//! \return Returns the number of bytes released.
+	size_t trim();
+
 	//! \brief Returns current block size.
 	//! \return Allocators block size in bytes.
 	size_t getBlockSize() const noexcept;
@@ -153,18 +510,355 @@ public:
 	//! \return Returns true if passed address is really this allocator's block address.
 	bool isBlockAddress(void* block) const noexcept;
 
+	//! \brief Returns the position of a block in the pool.
+
+	//! Blocks are numbered from 0 to (number of blocks - 1), an index can be kept instead of a pointer where 32 bits are enough.
+	//! \param[in] block The block address as returned by allocate().
+	//! \return Returns the block index.
+	//! \throw BlockAllocatorExceptions::InvalidBlockAddressException If the address isn't a block address of this allocator.
+	size_t getBlockIndex(void* block) const;
+
+	//! \brief Returns the address of a block by its index.
+	//! \param[in] index The block index as returned by getBlockIndex().
+	//! \return Returns the block address.
+	//! \throw BlockAllocatorExceptions::InvalidBlockAddressException If the index is out of the pool.
+	void* getBlockAddress(size_t index) const;
+
+	//! \brief Returns the number of blocks in the pool.
+	//! \return The number of blocks set in the constructor.
+	size_t getNumOfBlocks() const noexcept;
+
+	//! \brief Returns how the allocator memory is split between payload and overhead.
+	//! \return Returns the memory breakdown.
+	//! \sa MemoryOverhead
+	MemoryOverhead getMemoryOverhead() const noexcept;
+
+	//! \brief Names a tag, so blocks can be allocated with it.
+
+	//! Registering a tag again renames it, its counters are kept.
+	//! \param[in] tag The tag, less than maxTags.
+	//! \param[in] name The name shown by getTagUsage().
+	//! \throw BlockAllocatorExceptions::InvalidTagException If the tag is out of range or Config::tagging isn't set.
+	//! ### Example
+	//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
+	//! enum : BlockAllocator::Tag { SessionTag = 1, BufferTag };
+	//!
+	//! ba.registerTag(SessionTag, "session");
+	//! void* session = ba.allocate(SessionTag);
+	//! ~~~~~~~~~~~~~~~~~~~~~~~
+	void registerTag(Tag tag, const std::string& name);
+
+	//! \brief Returns the usage of every registered tag, ordered by tag.
+
+	//! Counters are kept in per-thread shards, which are summed here, so allocation never contends on a shared counter.
+	//! The peak is merged from the shards whenever one reaches a new high and on every call, so a short peak built by several threads at once may be missed.
+	//! \return Returns the usage, empty if Config::tagging isn't set.
+	std::vector<TagUsage> getTagUsage();
+
+	//! \brief Returns the remote free telemetry.
+
+	//! Only allocations sampled as set by Config::remoteFreeSampling are counted, blocks handed to asynchronous requests count as allocated by the serving thread.
+	//! Threads are told apart by their slot only. With more than maxTrackedThreads threads, threads whose slots are maxTrackedThreads apart alias,
+	//! e.g. the 1st and the 33rd thread, their frees of each other's blocks are counted as local. Aliased threads also share a sampling countdown.
+	//! \return Returns the counters, empty if the tracking isn't enabled.
+	RemoteFreeStats getRemoteFreeStats() const;
+
+	//! \brief Returns the thread slot of the calling thread used by the remote free telemetry.
+	//! Slots are given out in the order threads first allocate or deallocate with tracking enabled, modulo maxTrackedThreads.
+	static size_t getThreadSlot() noexcept;
+
+	//! \brief Returns the histogram of lifetimes of deallocated blocks, see numOfLifetimeBuckets.
+	//! \return Returns the bucket counts, empty if Config::lifetimeTracking isn't set.
+	std::vector<uint64_t> getLifetimeHistogram() const;
+
+	//! \brief Lists the blocks in use the longest.
+
+	//! The used blocks are found by the same linear scan of the pool as dumpState() uses, the free list isn't walked.
+	//! \param[in] count The maximum number of blocks listed.
+	//! \return Returns the oldest blocks, oldest first, empty if Config::lifetimeTracking isn't set.
+	std::vector<LiveBlock> getOldestBlocks(size_t count);
+
+	//! \brief Writes a JSON snapshot of the allocator state.
+
+	//! The snapshot holds the geometry, the counters, the used blocks as runs of [first index, length], the remote free counters, the lifetime histogram and the tag usage.
+	//! The lock is held only while the occupancy is copied, the JSON is written afterwards.
+	//! A snapshot of a BiasedFreeList allocator is exact only when taken by the owner thread.
+	//! Snapshots can be compared with the diffStates tool.
+	//! \param[out] out The stream the JSON is written to.
+	//! ### Example
+	//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
+	//! catch (const OutOfAllocatableMemoryException& e)
+	//! {
+	//! 	std::ofstream dump("pool.json");
+	//! 	ba.dumpState(dump);
+	//! }
+	//! ~~~~~~~~~~~~~~~~~~~~~~~
+	void dumpState(std::ostream& out);
+
 	//! \brief Gets current working pool type.
 	//! \return Returns current working pool type as type of MemoryPoolType
 	//! \sa MemoryPoolType
 	MemoryPoolType getPoolType() const noexcept;
 
+	//! \brief Gets the metadata layout.
+	//! \return Returns the layout selected at construction.
+	//! \sa LayoutType
+	LayoutType getLayout() const noexcept;
+
+	//! \brief Gets the free list engine.
+	//! \return Returns the engine selected at construction.
+	//! \sa FreeListType
+	FreeListType getFreeListType() const noexcept;
+
+	//! \brief Hands a BiasedFreeList allocator over to another thread.
+
+	//! Must be called by the owner. Passing a default constructed id leaves the allocator without an owner until a thread calls claimOwnership().
+	//! Does nothing for other free list engines.
+	//! \param[in] newOwner The id of the new owner thread.
+	//! \throw BlockAllocatorExceptions::NotOwnerThreadException If the calling thread doesn't own the allocator.
+	//! ### Example
+	//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
+	//! ba.transferOwnership(std::thread::id());
+	//!
+	//! std::thread worker([&ba]()
+	//! {
+	//! 	ba.claimOwnership();
+	//! 	...
+	//! });
+	//! ~~~~~~~~~~~~~~~~~~~~~~~
+	void transferOwnership(std::thread::id newOwner);
+
+	//! \brief Makes the calling thread the owner of a BiasedFreeList allocator which has no owner.
+	//! \return Returns true if the calling thread owns the allocator, always true for other free list engines.
+	bool claimOwnership() noexcept;
+
 private:
+	//! \brief Per tag counters and the tag of every block, defined in the source file.
+	struct TagAccounting;
+
+	//! \brief Set if Config::tagging is, NULL otherwise.
+	std::unique_ptr<TagAccounting> tags;
+
+	//! \brief The allocating thread of every block and the transfer matrix, defined in the source file.
+	struct RemoteFreeTracking;
+
+	//! \brief Set if Config::remoteFreeSampling isn't 0, NULL otherwise.
+	std::unique_ptr<RemoteFreeTracking> remoteFrees;
+
+	//! \brief Allocation times and the lifetime histogram, defined in the source file.
+	struct LifetimeTracking;
+
+	//! \brief Set if Config::lifetimeTracking is, NULL otherwise.
+	std::unique_ptr<LifetimeTracking> lifetimes;
+
+	//! \brief Checks if anything is recorded per allocation.
+	bool isRecording() const noexcept
+	{
+		return tags || remoteFrees || lifetimes;
+	}
+
+	//! \brief What was recorded about a block when it was allocated.
+	struct BlockOrigin
+	{
+		//! \brief The tag the block is accounted to.
+		Tag tag = 0;
+		//! \brief The allocating thread slot, or 0xff if the allocation wasn't sampled.
+		uint8_t thread = 0xff;
+		//! \brief The coarse allocation time in milliseconds.
+		uint64_t allocatedAt = 0;
+	};
+
+	//! \brief Records the tag, the sampled allocating thread and the allocation time of an allocated block.
+	void recordAllocation(void* block, Tag tag) noexcept;
+
+	//! \brief Returns what was recorded about an allocated block.
+	BlockOrigin getBlockOrigin(void* block) const noexcept;
+
+	//! \brief Removes a block from the counters of its tag, counts a sampled free and its lifetime.
+	void recordDeallocation(const BlockOrigin& origin) noexcept;
+
+	//! \brief Takes a free block, the engine part of allocate().
+	void* allocateBlock();
+
+	//! \brief Takes a free block without throwing, the engine part of tryAllocate().
+	void* tryAllocateBlock() noexcept;
+
+	//! \brief Returns a block, the engine part of deallocate().
+	void deallocateBlock(void* block);
+
+	//! \brief Copies the used block bits under the lock, the linear scan shared by dumpState() and getOldestBlocks().
+	//! \param[out] untouched The number of blocks never allocated.
+	//! \param[out] waitersCount The number of queued asynchronous requests.
+	//! \return Returns a bit per block, set if the block is in use.
+	std::vector<uint64_t> copyUsedBitmap(size_t& untouched, size_t& waitersCount);
+
+	//! \brief Returns the buffer bytes taken by an allocator placed by createInPool(), the blocks follow them.
+	static constexpr size_t getControlBlockSize() noexcept
+	{
+		return (sizeof(BlockAllocator) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+	}
+
 	//! \brief Mutex instance used to synchronize multithread operations.
 	std::mutex mutex;
 
 	//! \brief Builds linked list of free blocks.
 	void buildBlocksList();
 
+	//! \brief Blocks from this index on were never allocated and aren't linked to the free list, they are handed out in address order once the list runs empty.
+	//! Equals the number of blocks unless Config::lazyFreeList is set. Atomic as foreign BiasedFreeList threads read it when validating a block.
+	std::atomic<size_t> untouchedIndex;
+
+	//! \brief The metadata layout, set in the constructor.
+	LayoutType layout;
+
+	//! \brief The index of the first free block in the CompactLayout and the PageLayout.
+	uint32_t headIndex = 0;
+
+	//! \brief Used block bits of the CompactLayout and the PageLayout.
+	std::vector<uint64_t> inUseBitmap;
+
+	//! \brief The next free block index of every block, kept out of the blocks by the PageLayout and Config::forkSafe.
+	std::unique_ptr<uint32_t[]> nextFreeIndex;
+
+	//! \brief The index of the last free block in the PageLayout, blocks with released pages are appended there.
+	uint32_t tailIndex = 0;
+
+	//! \brief The number of free blocks at the head of the PageLayout free list still holding their pages.
+	size_t numOfRetainedFreeBlocks = 0;
+
+	//! \brief The number of free PageLayout blocks keeping their pages, set in the constructor.
+	size_t retainedFreeBlocksLimit = 0;
+
+	//! \brief Releases the pages of a free PageLayout block and appends it to the free list, the caller holds the lock.
+	void pushReleasedBlock(uint32_t index) noexcept;
+
+	//! \brief The free list engine, set in the constructor.
+	FreeListType freeListType;
+
+	//! \brief A RingFreeList slot, the sequence number tells producers and consumers whose turn it is.
+	struct RingCell
+	{
+		//! \brief The slot sequence number.
+		std::atomic<size_t> sequence;
+		//! \brief The free block index held in the slot.
+		uint32_t index;
+	};
+
+	//! \brief RingFreeList slots, the number of slots is a power of two not less than the number of blocks.
+	std::unique_ptr<RingCell[]> ring;
+
+	//! \brief The number of RingFreeList slots minus one.
+	size_t ringMask = 0;
+
+	//! \brief The next RingFreeList slot to push to.
+	std::atomic<size_t> ringPushPosition;
+
+	//! \brief Keeps the push and pop positions on different cache lines.
+	char ringPositionsPadding[64];
+
+	//! \brief The next RingFreeList slot to pop from.
+	std::atomic<size_t> ringPopPosition;
+
+	//! \brief Used block bits of the RingFreeList.
+	std::unique_ptr<std::atomic<uint64_t>[]> ringInUseBitmap;
+
+	//! \brief The number of asynchronous requests being queued with the RingFreeList or the BiasedFreeList, lets deallocate() skip the lock when it's zero.
+	//! Read without a fence, the push position and the foreign list head order it with the pushes, see takeOrEnqueue().
+	std::atomic<size_t> asyncWaitersCount;
+
+	//! \brief Allocates the RingFreeList and fills it with all blocks.
+	void buildRing();
+
+	//! \brief Refills the allocated RingFreeList with all blocks, reusing its arrays.
+	void resetRing() noexcept;
+
+	//! \brief Pushes a free block index to the RingFreeList.
+	//! The ring holds every block index at most once, so a push never fails.
+	void ringPush(uint32_t index) noexcept;
+
+	//! \brief Pops a free block index from the RingFreeList.
+	//! \return Returns false if the ring is empty and no push is in progress.
+	bool ringPop(uint32_t& index) noexcept;
+
+	//! \brief Marks a block popped from the RingFreeList as in use.
+	//! \return Returns the block address.
+	void* markRingBlockInUse(uint32_t index) noexcept;
+
+	//! \brief Returns a block to the RingFreeList and serves queued asynchronous requests.
+	void deallocateToRing(void* block);
+
+	//! \brief Hands free RingFreeList blocks to queued asynchronous requests.
+	void serveRingWaiters();
+
+	//! \brief The thread owning a BiasedFreeList allocator.
+	std::atomic<std::thread::id> owner;
+
+	//! \brief Blocks deallocated by threads other than the owner of a BiasedFreeList allocator.
+	std::atomic<Block*> foreignHead;
+
+	//! \brief Checks if the calling thread owns a BiasedFreeList allocator.
+	bool isOwnerThread() const noexcept;
+
+	//! \brief Moves blocks deallocated by other threads to the owner free list, called by the owner.
+	void drainForeignBlocks() noexcept;
+
+	//! \brief Allocates from a BiasedFreeList.
+	void* allocateBiased();
+
+	//! \brief Deallocates to a BiasedFreeList.
+	void deallocateBiased(void* block);
+
+	//! \brief Clears the in-use flag of a BiasedFreeList block with one atomic exchange.
+	//! \return Returns false if the block isn't in use, of two threads freeing the same block only one succeeds.
+	bool claimBiasedBlock(void* block) noexcept;
+
+	//! \brief Hands a claimed block directly to the oldest queued asynchronous request, marking it as in use again.
+	//! \return Returns false if there's no request.
+	bool handToWaiter(void* block);
+
+	//! \brief Hands blocks deallocated by other threads to queued asynchronous requests of a BiasedFreeList.
+	void serveForeignWaiters();
+
+	//! \brief Checks if the free list isn't empty, the caller holds the lock.
+	bool hasFreeBlock() const noexcept;
+
+	//! \brief Marks the first block never allocated as in use, the caller holds the lock and checks there is one.
+	//! \return Returns the block address.
+	void* popUntouchedBlock() noexcept;
+
+	//! \brief Unlinks the head of the free list and marks it as in use, the caller holds the lock and checks there is a free block.
+	//! Blocks never allocated are taken once the list is empty.
+	//! \return Returns the block address.
+	void* popFreeBlock() noexcept;
+
+	//! \brief Marks a used block as free and links it to the head of the free list, the caller holds the lock.
+	//! \param[in] block The block address as returned by allocate().
+	void pushFreeBlock(void* block) noexcept;
+
+	//! \brief Returns the start of the first free block or NULL, the caller holds the lock.
+	char* firstFreeBlock() const noexcept;
+
+	//! \brief Returns the start of the free block following the passed one or NULL, the caller holds the lock.
+	char* nextFreeBlock(char* freeBlock) const noexcept;
+
+	//! \brief Reads the next free block index kept in a free CompactLayout block or in the side array.
+	uint32_t getNextIndex(const char* freeBlock) const noexcept;
+
+	//! \brief Writes the next free block index into a free CompactLayout block or the side array.
+	void setNextIndex(char* freeBlock, uint32_t next) noexcept;
+
+	//! \brief Takes a free block or queues the callback if there is none.
+	//! \param[in] callback A function to call when a block is deallocated.
+	//! \return Returns a block, or NULL if the callback was queued.
+	void* allocateOrEnqueue(AllocationCallback callback);
+
+	//! \brief The engine part of allocateOrEnqueue().
+	void* takeOrEnqueue(AllocationCallback callback);
+
+	//! \brief FIFO queue of asynchronous allocation requests, served by deallocate().
+	//! A list allocates nothing until a request is queued, unlike a deque.
+	std::list<AllocationCallback> waiters;
+
 	//! \brief Holds current working memory pool, set in the constructor.
 	//! \sa MemoryPoolType
 	MemoryPoolType poolType;
@@ -175,6 +869,36 @@ private:
 
 	//! \brief Block with header size in bytes.
 	size_t blockWithHeaderSize = 0;
+
+	//! \brief Set if the allocator is registered with the fork handlers.
+	bool isForkSafe = false;
+
+	//! \brief The next allocator registered with the fork handlers.
+	BlockAllocator* nextForkSafe = NULL;
+
+	//! \brief The internal pool charged to the process MemoryBudget.
+	MemoryBudget::Charge budgetCharge;
+
+	//! \brief The MemoryBudget trim hook, trims the allocator.
+	static size_t trimForBudget(void* allocator);
+
+	//! \brief Builds the free list and the side tables of the pool, called by the constructor once the pool is there.
+	void initPool(const Config& config);
+
+	//! \brief Returns an internal pool to the system and its bytes to the budget.
+	void releasePool() noexcept;
+
+	//! \brief Registers the allocator with the fork handlers, installing them on first use.
+	void registerForFork();
+
+	//! \brief Removes the allocator from the fork handlers.
+	void unregisterForFork() noexcept;
+
+	//! \brief The pthread_atfork() prepare handler, locks every fork-safe allocator.
+	static void prepareFork();
+
+	//! \brief The pthread_atfork() parent and child handler, unlocks every fork-safe allocator.
+	static void finishFork();
 };
 
 //! @}
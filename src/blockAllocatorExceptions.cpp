@@ -33,3 +33,27 @@ OutOfAllocatableMemoryException::OutOfAllocatableMemoryException() :
 InvalidBlockAddressException::InvalidBlockAddressException() :
 		IException("Invalid block address exception!")
 {}
+
+PressureSourceUnavailableException::PressureSourceUnavailableException() :
+		IException("Memory pressure source is unavailable!")
+{}
+
+NotOwnerThreadException::NotOwnerThreadException() :
+		IException("Calling thread doesn't own the allocator!")
+{}
+
+TaskTooLargeException::TaskTooLargeException() :
+		IException("Task doesn't fit into a block!")
+{}
+
+InvalidTagException::InvalidTagException() :
+		IException("Invalid allocation tag!")
+{}
+
+PayloadTooLargeException::PayloadTooLargeException() :
+		IException("Payload doesn't fit into a block!")
+{}
+
+MemoryBudgetExceededException::MemoryBudgetExceededException() :
+		IException("Memory budget exceeded!")
+{}
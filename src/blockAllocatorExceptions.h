@@ -83,6 +83,78 @@ public:
 	~InvalidBlockAddressException() = default;
 };
 
+//! \brief The pressure source unavailable exception.
+
+//! Thrown when a memory pressure source can't subscribe to the system notifications, e.g. PSI isn't enabled in the kernel.
+class PressureSourceUnavailableException : public IException
+{
+public:
+	//! \brief The constructor.
+	PressureSourceUnavailableException();
+	//! \brief The default destructor.
+	~PressureSourceUnavailableException() = default;
+};
+
+//! \brief The not owner thread exception.
+
+//! Thrown when a thread other than the owner allocates from, or transfers, an allocator with the biased free list.
+class NotOwnerThreadException : public IException
+{
+public:
+	//! \brief The constructor.
+	NotOwnerThreadException();
+	//! \brief The default destructor.
+	~NotOwnerThreadException() = default;
+};
+
+//! \brief The task too large exception.
+
+//! Thrown when a callable doesn't fit into a task block of the executor.
+class TaskTooLargeException : public IException
+{
+public:
+	//! \brief The constructor.
+	TaskTooLargeException();
+	//! \brief The default destructor.
+	~TaskTooLargeException() = default;
+};
+
+//! \brief The invalid tag exception.
+
+//! Thrown when an allocation tag is out of range, isn't registered, or tagging isn't enabled.
+class InvalidTagException : public IException
+{
+public:
+	//! \brief The constructor.
+	InvalidTagException();
+	//! \brief The default destructor.
+	~InvalidTagException() = default;
+};
+
+//! \brief The payload too large exception.
+
+//! Thrown when a payload doesn't fit into a block of an intern pool.
+class PayloadTooLargeException : public IException
+{
+public:
+	//! \brief The constructor.
+	PayloadTooLargeException();
+	//! \brief The default destructor.
+	~PayloadTooLargeException() = default;
+};
+
+//! \brief The memory budget exceeded exception.
+
+//! Thrown when a pool would take more memory than the process MemoryBudget allows.
+class MemoryBudgetExceededException : public IException
+{
+public:
+	//! \brief The constructor.
+	MemoryBudgetExceededException();
+	//! \brief The default destructor.
+	~MemoryBudgetExceededException() = default;
+};
+
 }
 
 //! @}
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "blockChannel.h"
+
+using namespace BlockAllocatorExceptions;
+
+BlockChannel::BlockChannel(BlockAllocator& blockAllocator, size_t capacity, ProducerType producers) :
+		allocator(blockAllocator), producerType(producers), reservePosition(0), publishPosition(0), receivePosition(0)
+{
+	if (capacity == 0 || allocator.getNumOfBlocks() > std::numeric_limits<uint32_t>::max())
+		throw InvalidConstructorParametersException();
+
+	size_t slotCount = 1;
+	while (slotCount < capacity)
+	{
+		slotCount <<= 1;
+	}
+
+	slots.reset(new uint32_t[slotCount]);
+	mask = slotCount - 1;
+
+	firstBlock = (char*)allocator.getBlockAddress(0);
+	blockStride = allocator.getNumOfBlocks() > 1 ? (char*)allocator.getBlockAddress(1) - firstBlock : 0;
+}
+
+BlockChannel::~BlockChannel()
+{
+	std::vector<void*> left(size());
+
+	// Block by block, a batch stopped by a block freed behind the channel can't tell which blocks it returned.
+	left.resize(receive(left.data(), left.size()));
+	for (void* block : left)
+	{
+		try
+		{
+			allocator.deallocate(block);
+		}
+		catch (const IException&)
+		{
+		}
+	}
+}
+
+size_t BlockChannel::reserve(size_t numOfBlocks, size_t& start) noexcept
+{
+	start = reservePosition.load(std::memory_order_relaxed);
+
+	for (;;)
+	{
+		size_t free = mask + 1 - (start - receivePosition.load(std::memory_order_acquire));
+		size_t taken = std::min(numOfBlocks, free);
+
+		if (taken == 0)
+			return 0;
+
+		if (producerType == SingleProducer)
+		{
+			reservePosition.store(start + taken, std::memory_order_relaxed);
+			return taken;
+		}
+
+		if (reservePosition.compare_exchange_weak(start, start + taken, std::memory_order_relaxed))
+			return taken;
+	}
+}
+
+size_t BlockChannel::send(void* const* blocks, size_t numOfBlocks)
+{
+	for (size_t i = 0; i < numOfBlocks; i++)
+	{
+		if (!allocator.isBlockAddress(blocks[i]))
+			throw InvalidBlockAddressException();
+	}
+
+	size_t start;
+	size_t taken = reserve(numOfBlocks, start);
+	if (taken == 0)
+		return 0;
+
+	for (size_t i = 0; i < taken; i++)
+	{
+		slots[(start + i) & mask] = (uint32_t)allocator.getBlockIndex(blocks[i]);
+	}
+
+	// Ranges are published in order, a producer waits for the producers which took the preceding ranges.
+	while (publishPosition.load(std::memory_order_acquire) != start)
+	{
+		std::this_thread::yield();
+	}
+	publishPosition.store(start + taken, std::memory_order_release);
+
+	return taken;
+}
+
+bool BlockChannel::send(void* block)
+{
+	return send(&block, 1) == 1;
+}
+
+size_t BlockChannel::receive(void** blocks, size_t maxBlocks) noexcept
+{
+	size_t start = receivePosition.load(std::memory_order_relaxed);
+	size_t count = std::min(maxBlocks, publishPosition.load(std::memory_order_acquire) - start);
+
+	// The indices were taken from valid blocks by send(), they need no range check.
+	for (size_t i = 0; i < count; i++)
+	{
+		blocks[i] = firstBlock + (size_t)slots[(start + i) & mask] * blockStride;
+	}
+
+	// The release store hands the slots back to the producers only after they were read.
+	receivePosition.store(start + count, std::memory_order_release);
+	return count;
+}
+
+void* BlockChannel::receive() noexcept
+{
+	void* block;
+
+	return receive(&block, 1) == 1 ? block : NULL;
+}
+
+size_t BlockChannel::size() const noexcept
+{
+	return publishPosition.load(std::memory_order_acquire) - receivePosition.load(std::memory_order_acquire);
+}
+
+size_t BlockChannel::capacity() const noexcept
+{
+	return mask + 1;
+}
+
+BlockAllocator& BlockChannel::getAllocator() const noexcept
+{
+	return allocator;
+}
@@ -0,0 +1,139 @@
+#ifndef _BLOCK_CHANNEL_H
+#define _BLOCK_CHANNEL_H
+
+//! \addtogroup BlockAllocator
+//! @{
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+
+#include "blockAllocator.h"
+
+//! \brief Passes ownership of BlockAllocator blocks from producer threads to one consumer thread without copying.
+
+//! The channel is a bounded lock-free ring of 32-bit block indices, the block contents are never touched.
+//! A producer fills an allocated block and sends it, the consumer receives the same address and returns it to the allocator,
+//! preferably a batch at a time with BlockAllocator::deallocate(void* const*, size_t).
+//! Blocks still in the channel when it's destroyed are deallocated.
+//! \warning The allocator must outlive the channel.
+//! ### Example
+//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
+//! BlockChannel channel {ba, 1024};
+//!
+//! // producer
+//! void* block = ba.allocate();
+//! ...
+//! channel.send(block);
+//!
+//! // consumer
+//! void* received[64];
+//! size_t count = channel.receive(received, 64);
+//! ...
+//! ba.deallocate(received, count);
+//! ~~~~~~~~~~~~~~~~~~~~~~~
+class BlockChannel
+{
+public:
+	//! \brief Represents how many threads may send at once.
+	enum ProducerType
+	{
+		//! One sending thread, sending is wait-free.
+		SingleProducer,
+		//! Any number of sending threads. A batch takes a range of slots with one CAS, ranges are published in the order they were taken.
+		MultiProducer
+	};
+
+	//! \brief BlockChannel constructor.
+	//! \param[in] blockAllocator The allocator the passed blocks belong to, it must have less than 2^32 blocks.
+	//! \param[in] capacity The maximum number of blocks in flight, rounded up to a power of two, must be greater than 0.
+	//! \param[in] producers The number of sending threads allowed.
+	//! \throw BlockAllocatorExceptions::InvalidConstructorParametersException If invalid constructor parameters were passed.
+	BlockChannel(BlockAllocator& blockAllocator, size_t capacity, ProducerType producers = SingleProducer);
+
+	//! \brief Deallocates the blocks left in the channel.
+	//! Blocks deallocated behind the channel while they were in flight are skipped.
+	~BlockChannel();
+
+	//! \brief Deleted copy constructor.
+	BlockChannel(const BlockChannel&) = delete;
+
+	//! \brief Deleted assignment operator.
+	BlockChannel& operator=(const BlockChannel&) = delete;
+
+	//! \brief Sends a batch of blocks.
+
+	//! The addresses are checked before anything is sent, so an invalid address leaves the channel unchanged.
+	//! \param[in] blocks The addresses of allocated blocks, the sender gives up their ownership.
+	//! \param[in] numOfBlocks The number of addresses.
+	//! \return Returns the number of blocks sent, less than requested if the channel is full. The first blocks of the batch are sent.
+	//! \throw BlockAllocatorExceptions::InvalidBlockAddressException If an address isn't a block of the allocator.
+	size_t send(void* const* blocks, size_t numOfBlocks);
+
+	//! \brief Sends one block.
+	//! \param[in] block The address of an allocated block.
+	//! \return Returns false if the channel is full.
+	//! \throw BlockAllocatorExceptions::InvalidBlockAddressException If the address isn't a block of the allocator.
+	bool send(void* block);
+
+	//! \brief Receives a batch of blocks, must be called by one thread at a time.
+	//! \param[out] blocks Receives the block addresses, the caller takes their ownership.
+	//! \param[in] maxBlocks The capacity of the output array.
+	//! \return Returns the number of blocks received, 0 if the channel is empty.
+	size_t receive(void** blocks, size_t maxBlocks) noexcept;
+
+	//! \brief Receives one block, must be called by one thread at a time.
+	//! \return Returns the block address or NULL if the channel is empty.
+	void* receive() noexcept;
+
+	//! \brief Returns the number of blocks in the channel, the value may be stale when other threads use the channel.
+	size_t size() const noexcept;
+
+	//! \brief Returns the maximum number of blocks in the channel.
+	size_t capacity() const noexcept;
+
+	//! \brief Returns the allocator the blocks belong to.
+	BlockAllocator& getAllocator() const noexcept;
+
+private:
+	//! \brief The allocator the blocks belong to.
+	BlockAllocator& allocator;
+
+	//! \brief The number of producers allowed.
+	ProducerType producerType;
+
+	//! \brief Block indices.
+	std::unique_ptr<uint32_t[]> slots;
+
+	//! \brief The address of the first block of the allocator.
+	char* firstBlock;
+
+	//! \brief The distance between neighbouring blocks of the allocator.
+	size_t blockStride;
+
+	//! \brief The number of slots minus one.
+	size_t mask = 0;
+
+	//! \brief Keeps the producer positions away from the read-only fields.
+	char producerPadding[64];
+
+	//! \brief The end of the slots taken by producers, only differs from publishPosition while a MultiProducer batch is being written.
+	std::atomic<size_t> reservePosition;
+
+	//! \brief The end of the slots the consumer may read.
+	std::atomic<size_t> publishPosition;
+
+	//! \brief Keeps the producer and the consumer positions on different cache lines.
+	char consumerPadding[64];
+
+	//! \brief The next slot to read.
+	std::atomic<size_t> receivePosition;
+
+	//! \brief Takes a range of free slots.
+	//! \param[in] numOfBlocks The number of slots wanted.
+	//! \param[out] start The first slot taken.
+	//! \return Returns the number of slots taken.
+	size_t reserve(size_t numOfBlocks, size_t& start) noexcept;
+};
+
+//! @}
+#endif
@@ -0,0 +1,283 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "internPool.h"
+
+using namespace BlockAllocatorExceptions;
+
+// Ends a bucket chain.
+static const uint32_t noEntry = std::numeric_limits<uint32_t>::max();
+
+static const uint64_t prime1 = 0x9E3779B185EBCA87ull;
+static const uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t prime3 = 0x165667B19E3779F9ull;
+static const uint64_t prime4 = 0x85EBCA77C2B2AE63ull;
+static const uint64_t prime5 = 0x27D4EB2F165667C5ull;
+
+static size_t roundUpToPowerOfTwo(size_t value) noexcept
+{
+	size_t result = 1;
+	while (result < value)
+	{
+		result <<= 1;
+	}
+	return result;
+}
+
+static uint64_t rotateLeft(uint64_t value, int bits) noexcept
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+// Payloads aren't necessarily aligned, memcpy compiles to a single load.
+static uint64_t read64(const unsigned char* bytes) noexcept
+{
+	uint64_t value;
+	memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+static uint32_t read32(const unsigned char* bytes) noexcept
+{
+	uint32_t value;
+	memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+static uint64_t hashRound(uint64_t lane, uint64_t input) noexcept
+{
+	lane += input * prime2;
+	return rotateLeft(lane, 31) * prime1;
+}
+
+static uint64_t mergeLane(uint64_t hash, uint64_t lane) noexcept
+{
+	hash ^= hashRound(0, lane);
+	return hash * prime1 + prime4;
+}
+
+// Interned payloads are 8 byte aligned if the pool is, the compact layout stride is the block size.
+static size_t entryBlockSize(size_t entrySize, size_t maxPayloadSize)
+{
+	if (maxPayloadSize > std::numeric_limits<uint32_t>::max())
+		throw InvalidConstructorParametersException();
+
+	return (entrySize + maxPayloadSize + 7) / 8 * 8;
+}
+
+static BlockAllocator::Config entryConfig() noexcept
+{
+	BlockAllocator::Config config;
+	config.layout = BlockAllocator::CompactLayout;
+	return config;
+}
+
+InternPool::InternPool(size_t maxPayloadSize, size_t capacity, size_t numOfStripes) :
+		maxPayload(maxPayloadSize), entries(entryBlockSize(sizeof(Entry), maxPayloadSize), capacity, entryConfig()),
+		entryBase((char*)entries.getBlockAddress(0)), numOfEntries(0), numOfReferences(0), savedBytes(0)
+{
+	size_t bucketCount = roundUpToPowerOfTwo(capacity);
+	size_t stripeCount = std::min(roundUpToPowerOfTwo(numOfStripes), bucketCount);
+
+	buckets.reset(new uint32_t[bucketCount]);
+	std::fill(buckets.get(), buckets.get() + bucketCount, noEntry);
+	bucketMask = bucketCount - 1;
+
+	stripes.reset(new Stripe[stripeCount]);
+	stripeMask = stripeCount - 1;
+}
+
+const void* InternPool::intern(const void* bytes, size_t length)
+{
+	if (length > maxPayload)
+		throw PayloadTooLargeException();
+
+	uint64_t payloadHash = hash(bytes, length);
+	uint32_t* bucket = &buckets[payloadHash & bucketMask];
+	std::lock_guard<std::mutex> lock(stripeOf(payloadHash));
+
+	for (uint32_t index = *bucket; index != noEntry;)
+	{
+		Entry* entry = entryAt(index);
+		if (entry->hash == payloadHash && entry->length == length && (length == 0 || memcmp(entry + 1, bytes, length) == 0))
+		{
+			++entry->references;
+			numOfReferences.fetch_add(1, std::memory_order_relaxed);
+			savedBytes.fetch_add(length, std::memory_order_relaxed);
+			return entry + 1;
+		}
+		index = entry->next;
+	}
+
+	Entry* entry = (Entry*)entries.allocate();
+	entry->hash = payloadHash;
+	entry->next = *bucket;
+	entry->length = (uint32_t)length;
+	entry->references = 1;
+	if (length != 0)
+		memcpy(entry + 1, bytes, length);
+
+	*bucket = indexOf(entry);
+	numOfEntries.fetch_add(1, std::memory_order_relaxed);
+	numOfReferences.fetch_add(1, std::memory_order_relaxed);
+
+	return entry + 1;
+}
+
+void InternPool::retain(const void* payload)
+{
+	Entry* entry = entryOf(payload);
+	std::lock_guard<std::mutex> lock(stripeOf(entry->hash));
+
+	if (linkOf(entry) == NULL)
+		throw InvalidBlockAddressException();
+
+	++entry->references;
+	numOfReferences.fetch_add(1, std::memory_order_relaxed);
+	savedBytes.fetch_add(entry->length, std::memory_order_relaxed);
+}
+
+void InternPool::release(const void* payload)
+{
+	Entry* entry = entryOf(payload);
+	std::lock_guard<std::mutex> lock(stripeOf(entry->hash));
+
+	uint32_t* link = linkOf(entry);
+	if (link == NULL)
+		throw InvalidBlockAddressException();
+
+	numOfReferences.fetch_sub(1, std::memory_order_relaxed);
+	if (--entry->references != 0)
+	{
+		savedBytes.fetch_sub(entry->length, std::memory_order_relaxed);
+		return;
+	}
+
+	*link = entry->next;
+
+	numOfEntries.fetch_sub(1, std::memory_order_relaxed);
+	entries.deallocate(entry);
+}
+
+size_t InternPool::getLength(const void* payload) const noexcept
+{
+	return ((const Entry*)payload - 1)->length;
+}
+
+size_t InternPool::getNumOfEntries() const noexcept
+{
+	return numOfEntries.load(std::memory_order_relaxed);
+}
+
+size_t InternPool::getNumOfReferences() const noexcept
+{
+	return numOfReferences.load(std::memory_order_relaxed);
+}
+
+size_t InternPool::getSavedBytes() const noexcept
+{
+	return savedBytes.load(std::memory_order_relaxed);
+}
+
+size_t InternPool::getMaxPayloadSize() const noexcept
+{
+	return maxPayload;
+}
+
+const BlockAllocator& InternPool::getAllocator() const noexcept
+{
+	return entries;
+}
+
+uint64_t InternPool::hash(const void* bytes, size_t length) noexcept
+{
+	const unsigned char* position = (const unsigned char*)bytes;
+	const unsigned char* end = position + length;
+	uint64_t result;
+
+	if (length >= 32)
+	{
+		uint64_t lanes[4] = {prime1 + prime2, prime2, 0, 0 - prime1};
+		do
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				lanes[i] = hashRound(lanes[i], read64(position + i * 8));
+			}
+			position += 32;
+		}
+		while (end - position >= 32);
+
+		result = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+		for (uint64_t lane : lanes)
+		{
+			result = mergeLane(result, lane);
+		}
+	}
+	else
+		result = prime5;
+
+	result += length;
+
+	for (; end - position >= 8; position += 8)
+	{
+		result ^= hashRound(0, read64(position));
+		result = rotateLeft(result, 27) * prime1 + prime4;
+	}
+	if (end - position >= 4)
+	{
+		result ^= (uint64_t)read32(position) * prime1;
+		result = rotateLeft(result, 23) * prime2 + prime3;
+		position += 4;
+	}
+	for (; position < end; position++)
+	{
+		result ^= *position * prime5;
+		result = rotateLeft(result, 11) * prime1;
+	}
+
+	// The final avalanche spreads every input bit over the low bits taken as the bucket index.
+	result ^= result >> 33;
+	result *= prime2;
+	result ^= result >> 29;
+	result *= prime3;
+	result ^= result >> 32;
+	return result;
+}
+
+InternPool::Entry* InternPool::entryOf(const void* payload) const
+{
+	Entry* entry = (Entry*)payload - 1;
+
+	// getBlockIndex() rejects addresses outside the pool or not at a block start.
+	entries.getBlockIndex(entry);
+	return entry;
+}
+
+uint32_t* InternPool::linkOf(Entry* entry) const noexcept
+{
+	uint32_t index = indexOf(entry);
+
+	for (uint32_t* link = &buckets[entry->hash & bucketMask]; *link != noEntry; link = &entryAt(*link)->next)
+	{
+		if (*link == index)
+			return link;
+	}
+	return NULL;
+}
+
+uint32_t InternPool::indexOf(const Entry* entry) const noexcept
+{
+	return (uint32_t)(((const char*)entry - entryBase) / entries.getBlockSize());
+}
+
+InternPool::Entry* InternPool::entryAt(uint32_t index) const noexcept
+{
+	return (Entry*)(entryBase + (size_t)index * entries.getBlockSize());
+}
+
+std::mutex& InternPool::stripeOf(uint64_t hash) const noexcept
+{
+	return stripes[hash & bucketMask & stripeMask].mutex;
+}
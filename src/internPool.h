@@ -0,0 +1,158 @@
+#ifndef _INTERN_POOL_H
+#define _INTERN_POOL_H
+
+//! \addtogroup BlockAllocator
+//! @{
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "blockAllocator.h"
+
+//! \brief A thread-safe pool of deduplicated byte strings, identical payloads share one reference counted block.
+
+//! intern() hashes the payload and returns the block already holding the same bytes, or copies them into a new block.
+//! Each intern() and retain() adds a reference, the last release() returns the block to the pool.
+//! Blocks are indexed by a hash table with a fixed number of buckets, guarded by striped locks like PooledHashMap,
+//! so payloads hashed to different stripes are interned in parallel.
+//! Every block holds a small entry header followed by up to maxPayloadSize bytes, interned payloads are 8 byte aligned.
+//! ### Example
+//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
+//! InternPool keys {64, 100000};
+//!
+//! const char* key = (const char*)keys.intern(name.data(), name.size());
+//! ...
+//! keys.release(key);
+//! ~~~~~~~~~~~~~~~~~~~~~~~
+class InternPool
+{
+public:
+	//! \brief InternPool constructor.
+	//! \param[in] maxPayloadSize The largest payload in bytes.
+	//! \param[in] capacity The maximum number of distinct payloads, must be greater than 0 and less than 2^32 - 1.
+	//! \param[in] numOfStripes The number of bucket locks, rounded up to a power of two.
+	//! \throw BlockAllocatorExceptions::InvalidConstructorParametersException If invalid constructor parameters were passed.
+	//! \throw BlockAllocatorExceptions::OutOfSystemMemoryException If the pool can't be allocated.
+	InternPool(size_t maxPayloadSize, size_t capacity, size_t numOfStripes = 64);
+
+	//! \brief Deleted copy constructor.
+	InternPool(const InternPool&) = delete;
+
+	//! \brief Deleted assignment operator.
+	InternPool& operator=(const InternPool&) = delete;
+
+	//! \brief Returns the pooled copy of a payload, with one more reference.
+	//! \param[in] bytes The payload.
+	//! \param[in] length The payload length in bytes.
+	//! \return Returns the pooled payload, valid until its last reference is released.
+	//! \throw BlockAllocatorExceptions::PayloadTooLargeException If the length exceeds the maximum payload size.
+	//! \throw BlockAllocatorExceptions::OutOfAllocatableMemoryException If the payload isn't pooled yet and the pool is full.
+	const void* intern(const void* bytes, size_t length);
+
+	//! \brief Adds a reference to a pooled payload.
+	//! \param[in] payload A payload returned by intern().
+	//! \throw BlockAllocatorExceptions::InvalidBlockAddressException If the address isn't a pooled payload.
+	void retain(const void* payload);
+
+	//! \brief Drops a reference, the last one returns the payload block to the pool.
+	//! \param[in] payload A payload returned by intern().
+	//! \throw BlockAllocatorExceptions::InvalidBlockAddressException If the address isn't a pooled payload.
+	void release(const void* payload);
+
+	//! \brief Returns the length of a pooled payload.
+	//! \param[in] payload A payload returned by intern().
+	size_t getLength(const void* payload) const noexcept;
+
+	//! \brief Returns the number of distinct payloads pooled.
+	size_t getNumOfEntries() const noexcept;
+
+	//! \brief Returns the number of references held to pooled payloads.
+	size_t getNumOfReferences() const noexcept;
+
+	//! \brief Returns the payload bytes not stored thanks to deduplication, the length of every reference beyond the first of its payload.
+	size_t getSavedBytes() const noexcept;
+
+	//! \brief Returns the largest payload in bytes.
+	size_t getMaxPayloadSize() const noexcept;
+
+	//! \brief Returns the pool holding the payloads, e.g. to inspect its memory overhead.
+	const BlockAllocator& getAllocator() const noexcept;
+
+	//! \brief The payload hash, XXH64 with a zero seed.
+	//! Four independent 64-bit lanes consume 32 bytes per step, so the multiplications of a long payload overlap in the pipeline.
+	//! \param[in] bytes The payload.
+	//! \param[in] length The payload length in bytes.
+	//! \return Returns the hash.
+	static uint64_t hash(const void* bytes, size_t length) noexcept;
+
+private:
+	//! \brief Starts every block, followed by the payload.
+	struct Entry
+	{
+		//! \brief The payload hash.
+		uint64_t hash;
+		//! \brief The index of the next entry in the bucket chain.
+		uint32_t next;
+		//! \brief The payload length.
+		uint32_t length;
+		//! \brief The number of references.
+		size_t references;
+	};
+
+	//! \brief A bucket lock padded to keep neighbouring locks on different cache lines.
+	struct Stripe
+	{
+		std::mutex mutex;
+		char padding[64];
+	};
+
+	//! \brief Returns the entry of a payload, checking the address.
+	Entry* entryOf(const void* payload) const;
+
+	//! \brief Returns the bucket chain link pointing to an entry, or NULL if the entry isn't pooled, the caller holds the stripe lock.
+	//! Freed and never used blocks aren't linked, so they are rejected without trusting their contents.
+	uint32_t* linkOf(Entry* entry) const noexcept;
+
+	//! \brief Returns the block index of an entry.
+	uint32_t indexOf(const Entry* entry) const noexcept;
+
+	//! \brief Returns the entry at a block index.
+	Entry* entryAt(uint32_t index) const noexcept;
+
+	//! \brief Returns the lock of the bucket of a hash.
+	std::mutex& stripeOf(uint64_t hash) const noexcept;
+
+	//! \brief The largest payload.
+	size_t maxPayload;
+
+	//! \brief The payload pool.
+	BlockAllocator entries;
+
+	//! \brief The address of the first block.
+	char* entryBase;
+
+	//! \brief Bucket heads holding block indices.
+	std::unique_ptr<uint32_t[]> buckets;
+
+	//! \brief The number of buckets minus one.
+	size_t bucketMask = 0;
+
+	//! \brief Bucket locks.
+	std::unique_ptr<Stripe[]> stripes;
+
+	//! \brief The number of locks minus one.
+	size_t stripeMask = 0;
+
+	//! \brief The number of distinct payloads.
+	std::atomic<size_t> numOfEntries;
+
+	//! \brief The number of references.
+	std::atomic<size_t> numOfReferences;
+
+	//! \brief The bytes saved by deduplication.
+	std::atomic<size_t> savedBytes;
+};
+
+//! @}
+#endif
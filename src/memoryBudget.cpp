@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "blockAllocatorExceptions.h"
+#include "memoryBudget.h"
+
+using namespace BlockAllocatorExceptions;
+
+MemoryBudget MemoryBudget::processBudget;
+
+MemoryBudget::Charge::~Charge()
+{
+	releaseAll();
+}
+
+void MemoryBudget::Charge::reserve(size_t bytesToCharge)
+{
+	MemoryBudget& budget = MemoryBudget::process();
+
+	{
+		std::lock_guard<std::mutex> lock(budget.mutex);
+
+		if (budget.limit != 0 && (bytesToCharge > budget.limit || budget.charged > budget.limit - bytesToCharge))
+		{
+			++budget.refusedCount;
+			throw MemoryBudgetExceededException();
+		}
+
+		budget.charged += bytesToCharge;
+		bytes += bytesToCharge;
+		if (!isLinked)
+		{
+			prev = NULL;
+			next = budget.head;
+			if (next != NULL)
+				next->prev = this;
+			budget.head = this;
+			isLinked = true;
+		}
+
+		// Only the crossing trims, trimming doesn't lower the charged bytes, so every charge above the threshold would trim again.
+		if (budget.trimThreshold == 0 || budget.charged <= budget.trimThreshold || budget.isAboveThreshold)
+			return;
+
+		budget.isAboveThreshold = true;
+		++budget.trimCount;
+	}
+
+	budget.trimCharges();
+}
+
+void MemoryBudget::Charge::release(size_t bytesToRelease) noexcept
+{
+	MemoryBudget& budget = MemoryBudget::process();
+	std::lock_guard<std::mutex> lock(budget.mutex);
+
+	bytesToRelease = std::min(bytesToRelease, bytes);
+	bytes -= bytesToRelease;
+	budget.charged -= bytesToRelease;
+	if (budget.charged <= budget.trimThreshold)
+		budget.isAboveThreshold = false;
+}
+
+void MemoryBudget::Charge::releaseAll() noexcept
+{
+	if (!isLinked)
+		return;
+
+	MemoryBudget& budget = MemoryBudget::process();
+	std::unique_lock<std::mutex> lock(budget.mutex);
+
+	budget.charged -= bytes;
+	bytes = 0;
+	trimHook = NULL;
+	if (budget.charged <= budget.trimThreshold)
+		budget.isAboveThreshold = false;
+
+	if (prev != NULL)
+		prev->next = next;
+	else
+		budget.head = next;
+	if (next != NULL)
+		next->prev = prev;
+	isLinked = false;
+
+	// A trim may be running the hook of the owner being destroyed, the owner must outlive it.
+	while (runningTrims != 0)
+	{
+		lock.unlock();
+		std::this_thread::yield();
+		lock.lock();
+	}
+}
+
+void MemoryBudget::Charge::setTrimHook(TrimHook hook, void* context) noexcept
+{
+	std::lock_guard<std::mutex> lock(MemoryBudget::process().mutex);
+
+	trimHook = hook;
+	trimContext = context;
+}
+
+size_t MemoryBudget::Charge::getBytes() const noexcept
+{
+	return bytes;
+}
+
+MemoryBudget& MemoryBudget::process() noexcept
+{
+	return processBudget;
+}
+
+void MemoryBudget::setLimit(size_t limitBytes) noexcept
+{
+	setLimit(limitBytes, limitBytes / 10 * 9);
+}
+
+void MemoryBudget::setLimit(size_t limitBytes, size_t trimThresholdBytes) noexcept
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	limit = limitBytes;
+	trimThreshold = trimThresholdBytes;
+	// The next charge above the new threshold trims even if the old one was passed already.
+	isAboveThreshold = false;
+}
+
+size_t MemoryBudget::getLimit()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return limit;
+}
+
+size_t MemoryBudget::getTrimThreshold()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return trimThreshold;
+}
+
+size_t MemoryBudget::getChargedBytes()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return charged;
+}
+
+size_t MemoryBudget::getAvailableBytes()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (limit == 0)
+		return std::numeric_limits<size_t>::max();
+
+	return charged < limit ? limit - charged : 0;
+}
+
+size_t MemoryBudget::trim()
+{
+	return trimCharges();
+}
+
+size_t MemoryBudget::getTrimCount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return trimCount;
+}
+
+size_t MemoryBudget::getRefusedCount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return refusedCount;
+}
+
+// The hooks take allocator locks and make system calls, so they run without the budget lock.
+// Every charge of the snapshot counts a running trim, an allocator being destroyed waits in releaseAll() until it's over.
+// The snapshot is reserved before any trim is counted and the counts are taken back whatever the hooks throw, so no wait hangs.
+size_t MemoryBudget::trimCharges()
+{
+	std::vector<std::pair<Charge*, std::pair<TrimHook, void*>>> snapshot;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		size_t numOfHooks = 0;
+		for (Charge* charge = head; charge != NULL; charge = charge->next)
+		{
+			if (charge->trimHook != NULL)
+				++numOfHooks;
+		}
+		snapshot.reserve(numOfHooks);
+
+		for (Charge* charge = head; charge != NULL; charge = charge->next)
+		{
+			if (charge->trimHook == NULL)
+				continue;
+
+			++charge->runningTrims;
+			snapshot.emplace_back(charge, std::make_pair(charge->trimHook, charge->trimContext));
+		}
+	}
+
+	auto finishTrims = [this, &snapshot]() noexcept
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (std::pair<Charge*, std::pair<TrimHook, void*>>& entry : snapshot)
+		{
+			--entry.first->runningTrims;
+		}
+	};
+
+	size_t released = 0;
+	try
+	{
+		for (std::pair<Charge*, std::pair<TrimHook, void*>>& entry : snapshot)
+		{
+			released += entry.second.first(entry.second.second);
+		}
+	}
+	catch (...)
+	{
+		finishTrims();
+		throw;
+	}
+
+	finishTrims();
+	return released;
+}
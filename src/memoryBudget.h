@@ -0,0 +1,176 @@
+#ifndef _MEMORY_BUDGET_H
+#define _MEMORY_BUDGET_H
+
+//! \addtogroup BlockAllocator
+//! @{
+#include <stddef.h>
+#include <mutex>
+
+//! \brief The process-wide cap on pooled memory, charged by every allocator which takes memory from the system.
+
+//! BlockAllocator charges its internal pool in the constructor before the pool is allocated or mapped, AllocatorArena charges
+//! every pool it hands out. Pools placed in memory of the caller aren't charged, the caller owns that memory.
+//! The budget counts reserved bytes, what the pools take once every block is touched, so the limit holds in the worst case.
+//! A charge which would exceed the limit throws BlockAllocatorExceptions::MemoryBudgetExceededException and reserves nothing,
+//! a caller can shed load instead of the process being killed by the container.
+//! When a charge first takes the charged bytes past the trim threshold every charging allocator is asked to trim(), so the free pages
+//! of all pools go back to the system before the limit is reached. Charges staying above the threshold don't trim again,
+//! the budget has to drop to the threshold before the next crossing trims. Trimming lowers the resident memory, not the charged bytes.
+//! The trim hooks run without the budget lock, other threads keep charging and releasing meanwhile.
+//! The budget is unlimited until setLimit() is called.
+//! ### Example
+//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
+//! MemoryBudget::process().setLimit(512 * 1024 * 1024);
+//!
+//! try
+//! {
+//! 	connections.emplace_back(new BlockAllocator(16384, 1024));
+//! }
+//! catch (const BlockAllocatorExceptions::MemoryBudgetExceededException&)
+//! {
+//! 	rejectConnection();
+//! }
+//! ~~~~~~~~~~~~~~~~~~~~~~~
+class MemoryBudget
+{
+public:
+	//! \brief Releases free memory of an allocator, returns the number of bytes released.
+	//! An exception stops the trim, the hooks left are skipped and the exception is passed on to the caller of trim() or reserve().
+	typedef size_t (*TrimHook)(void* context);
+
+	//! \brief The bytes one allocator charged to the budget, released by the destructor at the latest.
+	class Charge
+	{
+	public:
+		//! \brief Creates an empty charge.
+		Charge() = default;
+
+		//! \brief Releases the charged bytes.
+		~Charge();
+
+		//! \brief Deleted copy constructor.
+		Charge(const Charge&) = delete;
+
+		//! \brief Deleted assignment operator.
+		Charge& operator=(const Charge&) = delete;
+
+		//! \brief Charges more bytes to the process budget.
+		//! \param[in] bytes The number of bytes.
+		//! \throw BlockAllocatorExceptions::MemoryBudgetExceededException If the bytes don't fit the limit, nothing is charged then.
+		//! \throw Anything a trim hook throws when the charge passes the trim threshold, the bytes stay charged then.
+		void reserve(size_t bytes);
+
+		//! \brief Gives charged bytes back to the process budget.
+		//! \param[in] bytes The number of bytes, not greater than the charged ones.
+		void release(size_t bytes) noexcept;
+
+		//! \brief Gives all charged bytes back and stops trimming the owner.
+		void releaseAll() noexcept;
+
+		//! \brief Sets the hook trimming the owner of the charge, call it once the owner can be trimmed.
+		//! \param[in] hook The hook, NULL keeps the owner from being trimmed.
+		//! \param[in] context The pointer passed to the hook.
+		void setTrimHook(TrimHook hook, void* context) noexcept;
+
+		//! \brief Returns the charged bytes.
+		size_t getBytes() const noexcept;
+
+	private:
+		friend class MemoryBudget;
+
+		//! \brief The charged bytes.
+		size_t bytes = 0;
+		//! \brief Trims the owner, may be NULL.
+		TrimHook trimHook = NULL;
+		//! \brief Passed to the trim hook.
+		void* trimContext = NULL;
+		//! \brief The previous charge of the budget list.
+		Charge* prev = NULL;
+		//! \brief The next charge of the budget list.
+		Charge* next = NULL;
+		//! \brief Set while the charge is linked to the budget list.
+		bool isLinked = false;
+		//! \brief The number of trims running the hook right now, releaseAll() waits for them.
+		size_t runningTrims = 0;
+	};
+
+	//! \brief Returns the budget of the process.
+	static MemoryBudget& process() noexcept;
+
+	//! \brief Deleted copy constructor.
+	MemoryBudget(const MemoryBudget&) = delete;
+
+	//! \brief Deleted assignment operator.
+	MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+	//! \brief Sets the limit, the trim threshold is set to 90% of it.
+	//! Bytes charged already are kept even if they exceed the new limit, only new charges are refused.
+	//! \param[in] limitBytes The maximum number of charged bytes, 0 removes the limit.
+	void setLimit(size_t limitBytes) noexcept;
+
+	//! \brief Sets the limit and the trim threshold.
+	//! \param[in] limitBytes The maximum number of charged bytes, 0 removes the limit.
+	//! \param[in] trimThresholdBytes Allocators are trimmed when a charge first takes the charged bytes past it, 0 disables trimming.
+	void setLimit(size_t limitBytes, size_t trimThresholdBytes) noexcept;
+
+	//! \brief Returns the limit, 0 if there's none.
+	size_t getLimit();
+
+	//! \brief Returns the trim threshold.
+	size_t getTrimThreshold();
+
+	//! \brief Returns the number of charged bytes.
+	size_t getChargedBytes();
+
+	//! \brief Returns the number of bytes still available, SIZE_MAX if there's no limit.
+	size_t getAvailableBytes();
+
+	//! \brief Asks every charging allocator with a trim hook to release its free memory.
+	//! \return Returns the number of bytes released.
+	//! \throw Anything a trim hook throws.
+	size_t trim();
+
+	//! \brief Returns how many times the allocators were trimmed because the threshold was passed.
+	size_t getTrimCount();
+
+	//! \brief Returns how many charges were refused.
+	size_t getRefusedCount();
+
+private:
+	//! \brief Constant initialized, so the budget is usable by allocators with static storage.
+	constexpr MemoryBudget() noexcept
+	{}
+
+	//! \brief Runs the trim hooks of a snapshot of the charges, takes the lock only to take and return the snapshot.
+	size_t trimCharges();
+
+	//! \brief The budget of the process.
+	static MemoryBudget processBudget;
+
+	//! \brief Guards the budget and the list of charges.
+	std::mutex mutex;
+
+	//! \brief The first charge of the list.
+	Charge* head = NULL;
+
+	//! \brief The limit, 0 if there's none.
+	size_t limit = 0;
+
+	//! \brief The trim threshold, 0 if trimming is disabled.
+	size_t trimThreshold = 0;
+
+	//! \brief The charged bytes.
+	size_t charged = 0;
+
+	//! \brief Set once a charge passed the trim threshold, cleared when the charged bytes drop to it again.
+	bool isAboveThreshold = false;
+
+	//! \brief The number of threshold trims.
+	size_t trimCount = 0;
+
+	//! \brief The number of refused charges.
+	size_t refusedCount = 0;
+};
+
+//! @}
+#endif
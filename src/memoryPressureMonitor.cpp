@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "memoryPressureMonitor.h"
+
+using namespace BlockAllocatorExceptions;
+
+// Wakes the monitor thread regularly to check if it was stopped.
+static const std::chrono::milliseconds pollInterval(100);
+
+MemoryPressureMonitor::PsiPressureSource::PsiPressureSource(std::chrono::microseconds stallThreshold,
+		std::chrono::microseconds window, const std::string& path)
+{
+	fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0)
+		throw PressureSourceUnavailableException();
+
+	char trigger[64];
+	int length = snprintf(trigger, sizeof(trigger), "some %lld %lld",
+			(long long)stallThreshold.count(), (long long)window.count());
+
+	// The trigger is registered by writing it including the terminating zero.
+	if (write(fd, trigger, length + 1) < 0)
+	{
+		close(fd);
+		throw PressureSourceUnavailableException();
+	}
+}
+
+MemoryPressureMonitor::PsiPressureSource::~PsiPressureSource()
+{
+	close(fd);
+}
+
+bool MemoryPressureMonitor::PsiPressureSource::waitForPressure(std::chrono::milliseconds timeout)
+{
+	pollfd event = {fd, POLLPRI, 0};
+
+	if (poll(&event, 1, (int)timeout.count()) <= 0)
+		return false;
+
+	return (event.revents & POLLPRI) != 0;
+}
+
+MemoryPressureMonitor::CgroupEventsPressureSource::CgroupEventsPressureSource(const std::string& path)
+{
+	fd = path.empty() ? -1 : open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		throw PressureSourceUnavailableException();
+
+	lastEvents = readEvents();
+}
+
+MemoryPressureMonitor::CgroupEventsPressureSource::~CgroupEventsPressureSource()
+{
+	close(fd);
+}
+
+std::string MemoryPressureMonitor::CgroupEventsPressureSource::ownEventsPath()
+{
+	std::ifstream cgroups("/proc/self/cgroup");
+	std::string line;
+
+	// The cgroup v2 entry has the form "0::/path".
+	while (std::getline(cgroups, line))
+	{
+		if (line.compare(0, 3, "0::") != 0)
+			continue;
+
+		std::string group = line.substr(3);
+		if (group.empty() || group[group.size() - 1] != '/')
+			group += '/';
+
+		return "/sys/fs/cgroup" + group + "memory.events";
+	}
+
+	return "";
+}
+
+uint64_t MemoryPressureMonitor::CgroupEventsPressureSource::readEvents()
+{
+	char buffer[512];
+	ssize_t length = pread(fd, buffer, sizeof(buffer) - 1, 0);
+
+	if (length <= 0)
+		return lastEvents;
+	buffer[length] = '\0';
+
+	uint64_t sum = 0;
+	char name[32];
+	unsigned long long value;
+	int consumed;
+
+	for (const char* line = buffer; sscanf(line, "%31s %llu%n", name, &value, &consumed) == 2; line += consumed)
+	{
+		if (strcmp(name, "high") == 0 || strcmp(name, "max") == 0 || strcmp(name, "oom") == 0)
+			sum += value;
+	}
+
+	return sum;
+}
+
+bool MemoryPressureMonitor::CgroupEventsPressureSource::waitForPressure(std::chrono::milliseconds timeout)
+{
+	// cgroup files report modifications with POLLPRI.
+	pollfd event = {fd, POLLPRI, 0};
+
+	if (poll(&event, 1, (int)timeout.count()) <= 0)
+		return false;
+
+	uint64_t events = readEvents();
+	bool grew = events > lastEvents;
+	lastEvents = events;
+
+	return grew;
+}
+
+void MemoryPressureMonitor::SimulatedPressureSource::signal()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending = true;
+	}
+	condition.notify_one();
+}
+
+bool MemoryPressureMonitor::SimulatedPressureSource::waitForPressure(std::chrono::milliseconds timeout)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	if (!condition.wait_for(lock, timeout, [this] { return pending; }))
+		return false;
+
+	pending = false;
+	return true;
+}
+
+MemoryPressureMonitor::MemoryPressureMonitor(std::unique_ptr<PressureSource> pressureSource,
+		std::chrono::milliseconds minTrimInterval) :
+		source(std::move(pressureSource)), minInterval(minTrimInterval), running(false)
+{}
+
+MemoryPressureMonitor::~MemoryPressureMonitor()
+{
+	stop();
+}
+
+void MemoryPressureMonitor::registerAllocator(BlockAllocator& allocator)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	allocators.push_back(&allocator);
+}
+
+void MemoryPressureMonitor::unregisterAllocator(BlockAllocator& allocator)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	allocators.erase(std::remove(allocators.begin(), allocators.end(), &allocator), allocators.end());
+}
+
+void MemoryPressureMonitor::start()
+{
+	if (running.exchange(true))
+		return;
+
+	thread = std::thread(&MemoryPressureMonitor::run, this);
+}
+
+void MemoryPressureMonitor::stop()
+{
+	if (!running.exchange(false))
+		return;
+
+	thread.join();
+}
+
+void MemoryPressureMonitor::run()
+{
+	while (running.load())
+	{
+		if (source->waitForPressure(pollInterval))
+			onPressure();
+	}
+}
+
+size_t MemoryPressureMonitor::onPressure()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (trimCount != 0 && now - lastTrim < minInterval)
+		return 0;
+
+	lastTrim = now;
+	++trimCount;
+
+	size_t released = 0;
+	for (BlockAllocator* allocator : allocators)
+	{
+		released += allocator->trim();
+	}
+
+	return released;
+}
+
+size_t MemoryPressureMonitor::getTrimCount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return trimCount;
+}
@@ -0,0 +1,186 @@
+#ifndef _MEMORY_PRESSURE_MONITOR_H
+#define _MEMORY_PRESSURE_MONITOR_H
+
+//! \addtogroup BlockAllocator
+//! @{
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "blockAllocator.h"
+
+//! \brief Trims registered allocators when the system reports memory pressure.
+
+//! The monitor waits on a PressureSource in a background thread and calls BlockAllocator::trim() on every registered allocator
+//! when pressure is reported. Trimming is rate limited, pressure reported again within the minimal trim interval is ignored.
+//! ### Example
+//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
+//! std::unique_ptr<MemoryPressureMonitor::PressureSource> source(new MemoryPressureMonitor::PsiPressureSource());
+//!
+//! MemoryPressureMonitor monitor {std::move(source), std::chrono::milliseconds(5000)};
+//!
+//! monitor.registerAllocator(ba);
+//! monitor.start();
+//! ~~~~~~~~~~~~~~~~~~~~~~~
+class MemoryPressureMonitor
+{
+public:
+	//! \brief The memory pressure notification interface.
+	class PressureSource
+	{
+	public:
+		//! \brief Virtual destructor for inheritance purposes.
+		virtual ~PressureSource() = default;
+
+		//! \brief Blocks until pressure is reported or the timeout expires.
+		//! \param[in] timeout The maximum time to wait.
+		//! \return Returns true if pressure was reported.
+		virtual bool waitForPressure(std::chrono::milliseconds timeout) = 0;
+	};
+
+	//! \brief Linux pressure stall information (PSI) trigger on /proc/pressure/memory.
+	class PsiPressureSource : public PressureSource
+	{
+	public:
+		//! \brief Registers a PSI trigger.
+		//! \param[in] stallThreshold Total stall time within the window which reports pressure.
+		//! \param[in] window The tracking window, the kernel requires 500ms..10s and unprivileged users need a multiple of 2s.
+		//! \param[in] path The PSI file, a cgroup v2 memory.pressure file can be used to watch a single cgroup.
+		//! \throw BlockAllocatorExceptions::PressureSourceUnavailableException If the trigger can't be registered.
+		PsiPressureSource(std::chrono::microseconds stallThreshold = std::chrono::microseconds(150000),
+				std::chrono::microseconds window = std::chrono::microseconds(2000000),
+				const std::string& path = "/proc/pressure/memory");
+
+		//! \brief Closes the trigger.
+		~PsiPressureSource();
+
+		bool waitForPressure(std::chrono::milliseconds timeout) override;
+
+	private:
+		//! \brief The trigger file descriptor.
+		int fd = -1;
+	};
+
+	//! \brief cgroup v2 memory.events watcher, reports pressure when the "high", "max" or "oom" counters grow.
+	class CgroupEventsPressureSource : public PressureSource
+	{
+	public:
+		//! \brief Opens the memory.events file.
+		//! \param[in] path The memory.events file, by default the file of the cgroup this process belongs to.
+		//! \throw BlockAllocatorExceptions::PressureSourceUnavailableException If the file can't be opened.
+		explicit CgroupEventsPressureSource(const std::string& path = ownEventsPath());
+
+		//! \brief Closes the file.
+		~CgroupEventsPressureSource();
+
+		bool waitForPressure(std::chrono::milliseconds timeout) override;
+
+		//! \brief Resolves the memory.events path of the cgroup this process belongs to.
+		//! \return Returns the path, or an empty string if the process isn't in a cgroup v2 hierarchy.
+		static std::string ownEventsPath();
+
+	private:
+		//! \brief The memory.events file descriptor.
+		int fd = -1;
+
+		//! \brief The sum of the pressure counters seen last time.
+		uint64_t lastEvents = 0;
+
+		//! \brief Reads and sums the pressure counters.
+		uint64_t readEvents();
+	};
+
+	//! \brief Pressure source driven by the program, used for testing.
+	class SimulatedPressureSource : public PressureSource
+	{
+	public:
+		//! \brief Reports pressure to the waiting monitor.
+		void signal();
+
+		bool waitForPressure(std::chrono::milliseconds timeout) override;
+
+	private:
+		//! \brief Guards the pending flag.
+		std::mutex mutex;
+
+		//! \brief Wakes the waiting monitor.
+		std::condition_variable condition;
+
+		//! \brief Set by signal(), cleared when the pressure is consumed.
+		bool pending = false;
+	};
+
+	//! \brief MemoryPressureMonitor constructor.
+	//! \param[in] pressureSource The source of pressure notifications.
+	//! \param[in] minTrimInterval The minimal time between two trims.
+	MemoryPressureMonitor(std::unique_ptr<PressureSource> pressureSource, std::chrono::milliseconds minTrimInterval);
+
+	//! \brief Stops the monitor thread.
+	~MemoryPressureMonitor();
+
+	//! \brief Deleted copy constructor.
+	MemoryPressureMonitor(const MemoryPressureMonitor&) = delete;
+
+	//! \brief Deleted assignment operator.
+	MemoryPressureMonitor& operator=(const MemoryPressureMonitor&) = delete;
+
+	//! \brief Adds an allocator to trim under pressure.
+	//! \param[in] allocator The allocator, it must be unregistered before it is destroyed.
+	void registerAllocator(BlockAllocator& allocator);
+
+	//! \brief Removes an allocator, waits for a trim in progress to finish.
+	//! \param[in] allocator The allocator.
+	void unregisterAllocator(BlockAllocator& allocator);
+
+	//! \brief Starts the monitor thread.
+	void start();
+
+	//! \brief Stops the monitor thread.
+	void stop();
+
+	//! \brief Trims all registered allocators unless the last trim was too recent.
+
+	//! Called by the monitor thread, can also be called directly.
+	//! \return Returns the number of bytes released.
+	size_t onPressure();
+
+	//! \brief Returns how many times the allocators were trimmed.
+	size_t getTrimCount();
+
+private:
+	//! \brief The source of pressure notifications.
+	std::unique_ptr<PressureSource> source;
+
+	//! \brief The minimal time between two trims.
+	std::chrono::milliseconds minInterval;
+
+	//! \brief Guards the registered allocators and the trim statistics.
+	std::mutex mutex;
+
+	//! \brief Allocators to trim.
+	std::vector<BlockAllocator*> allocators;
+
+	//! \brief The time of the last trim.
+	std::chrono::steady_clock::time_point lastTrim;
+
+	//! \brief The number of trims done.
+	size_t trimCount = 0;
+
+	//! \brief Keeps the monitor thread running.
+	std::atomic<bool> running;
+
+	//! \brief The monitor thread.
+	std::thread thread;
+
+	//! \brief The monitor thread loop.
+	void run();
+};
+
+//! @}
+#endif
@@ -0,0 +1,248 @@
+#ifndef _OBJECT_CACHE_H
+#define _OBJECT_CACHE_H
+
+//! \addtogroup BlockAllocator
+//! @{
+#include <stdint.h>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+
+#include "blockAllocator.h"
+
+//! \brief A thread-safe cache of constructed objects kept in a BlockAllocator, in the style of a slab allocator object cache.
+
+//! Released objects aren't destroyed, they are reset by an optional hook and kept constructed for the next acquire().
+//! Memory the object owns, e.g. the capacity of its vectors and strings, is kept along with it.
+//! An object is constructed only when no released object is waiting, and destroyed only by trim() or the cache destructor.
+//! The most recently released object is handed out first, as it's the most likely to be cached.
+//! \warning Objects still acquired when the cache is destroyed are neither destroyed nor valid anymore.
+//! \tparam T The object type, must be default constructible.
+//! ### Example
+//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
+//! ObjectCache<Request> requests {1024, [](Request& request)
+//! {
+//! 	request.headers.clear();
+//! 	request.body.clear();
+//! }};
+//!
+//! Request* request = requests.acquire();
+//! ...
+//! requests.release(request);
+//! ~~~~~~~~~~~~~~~~~~~~~~~
+template <typename T>
+class ObjectCache
+{
+public:
+	//! \brief The hook returning a released object to a reusable state.
+	typedef std::function<void(T&)> ResetHook;
+
+	//! \brief ObjectCache constructor.
+	//! \param[in] capacity The maximum number of objects, acquired and cached ones together, must be greater than 0 and less than 2^32 - 1.
+	//! \param[in] reset The hook called by release(), no hook is called if it's empty.
+	//! \throw BlockAllocatorExceptions::InvalidConstructorParametersException If the capacity is invalid.
+	//! \throw BlockAllocatorExceptions::OutOfSystemMemoryException If the object pool can't be allocated.
+	explicit ObjectCache(size_t capacity, ResetHook reset = ResetHook()) :
+		objects(objectBlockSize(), capacity, objectConfig()), objectBase((char*)objects.getBlockAddress(0)),
+		resetHook(std::move(reset)), cached(new uint32_t[capacity]), slotStates(new uint8_t[capacity]())
+	{}
+
+	//! \brief Destroys the cached objects.
+	//! Objects still acquired aren't destroyed, the memory they own leaks, release them before the cache is destroyed.
+	~ObjectCache()
+	{
+		for (size_t i = 0; i < numOfCached; i++)
+		{
+			objectAt(cached[i])->~T();
+		}
+	}
+
+	//! \brief Deleted copy constructor.
+	ObjectCache(const ObjectCache&) = delete;
+
+	//! \brief Deleted assignment operator.
+	ObjectCache& operator=(const ObjectCache&) = delete;
+
+	//! \brief Returns a cached object, or a newly constructed one if none is cached.
+	//! \return Returns the object.
+	//! \throw BlockAllocatorExceptions::OutOfAllocatableMemoryException If capacity objects are acquired.
+	T* acquire()
+	{
+		void* block;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (numOfCached != 0)
+			{
+				uint32_t index = cached[--numOfCached];
+				slotStates[index] = AcquiredSlot;
+				return objectAt(index);
+			}
+
+			block = objects.allocate();
+			slotStates[indexOf((T*)block)] = AcquiredSlot;
+		}
+
+		// The constructor runs without the lock, a T constructor may use the cache itself.
+		try
+		{
+			return new (block) T();
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			slotStates[indexOf((T*)block)] = FreeSlot;
+			objects.deallocate(block);
+			throw;
+		}
+	}
+
+	//! \brief Resets an acquired object and keeps it constructed for reuse.
+	//! \param[in] object An object returned by acquire().
+	//! \throw BlockAllocatorExceptions::InvalidBlockAddressException If the object doesn't belong to the cache or isn't acquired,
+	//! e.g. it was released already or destroyed by trim().
+	//! \throw Anything the reset hook throws, the object stays acquired then.
+	void release(T* object)
+	{
+		size_t index = indexOf(object);
+
+		// Marked before the hook runs, so a concurrent second release of the object is rejected too.
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (slotStates[index] != AcquiredSlot)
+				throw BlockAllocatorExceptions::InvalidBlockAddressException();
+			slotStates[index] = CachedSlot;
+		}
+
+		// The hook runs without the lock, resetting a heavy object mustn't stall other threads.
+		try
+		{
+			if (resetHook)
+				resetHook(*object);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			slotStates[index] = AcquiredSlot;
+			throw;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		cached[numOfCached++] = (uint32_t)index;
+	}
+
+	//! \brief Destroys cached objects and returns their blocks to the pool.
+	//! \param[in] keep The number of cached objects kept, the least recently released ones are destroyed first.
+	//! \return Returns the number of destroyed objects.
+	size_t trim(size_t keep = 0)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (numOfCached <= keep)
+			return 0;
+
+		size_t destroyed = numOfCached - keep;
+		for (size_t i = 0; i < destroyed; i++)
+		{
+			T* object = objectAt(cached[i]);
+			object->~T();
+			slotStates[cached[i]] = FreeSlot;
+			objects.deallocate(object);
+		}
+
+		for (size_t i = 0; i < keep; i++)
+		{
+			cached[i] = cached[destroyed + i];
+		}
+		numOfCached = keep;
+
+		return destroyed;
+	}
+
+	//! \brief Returns the number of constructed objects waiting in the cache.
+	size_t getCachedCount()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return numOfCached;
+	}
+
+	//! \brief Returns the maximum number of objects.
+	size_t capacity() const noexcept
+	{
+		return objects.getNumOfBlocks();
+	}
+
+	//! \brief Returns the allocator holding the objects.
+	const BlockAllocator& getAllocator() const noexcept
+	{
+		return objects;
+	}
+
+private:
+	static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned objects aren't supported");
+
+	//! \brief The state of an object slot.
+	enum SlotState : uint8_t
+	{
+		//! \brief No object is constructed, the block is free in the pool.
+		FreeSlot = 0,
+		//! \brief The object is handed out to the caller.
+		AcquiredSlot,
+		//! \brief The object is constructed and waits in the cache.
+		CachedSlot
+	};
+
+	// Objects are laid out back to back by the compact layout, a stride rounded up to the alignment keeps every object aligned.
+	// Compact blocks are at least the 4 byte index, a multiple of any smaller alignment.
+	static size_t objectBlockSize() noexcept
+	{
+		return std::max((sizeof(T) + alignof(T) - 1) / alignof(T) * alignof(T), sizeof(uint32_t));
+	}
+
+	static BlockAllocator::Config objectConfig() noexcept
+	{
+		BlockAllocator::Config config;
+		config.layout = BlockAllocator::CompactLayout;
+		return config;
+	}
+
+	T* objectAt(uint32_t index) const noexcept
+	{
+		return (T*)(objectBase + index * objects.getBlockSize());
+	}
+
+	size_t indexOf(T* object) const
+	{
+		size_t offset = (size_t)((char*)object - objectBase);
+
+		if ((char*)object < objectBase || offset % objects.getBlockSize() != 0 || offset / objects.getBlockSize() >= capacity())
+			throw BlockAllocatorExceptions::InvalidBlockAddressException();
+
+		return offset / objects.getBlockSize();
+	}
+
+	//! \brief The object pool.
+	BlockAllocator objects;
+
+	//! \brief The first object, objects are objects.getBlockSize() bytes apart.
+	char* objectBase;
+
+	//! \brief Called by release().
+	ResetHook resetHook;
+
+	//! \brief Stack of the indices of cached objects, the most recently released on top.
+	std::unique_ptr<uint32_t[]> cached;
+
+	//! \brief The SlotState of every slot, only acquired objects can be released.
+	std::unique_ptr<uint8_t[]> slotStates;
+
+	//! \brief The number of cached objects.
+	size_t numOfCached = 0;
+
+	//! \brief Guards the cache.
+	std::mutex mutex;
+};
+
+//! @}
+#endif
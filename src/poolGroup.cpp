@@ -0,0 +1,227 @@
+#include <algorithm>
+
+#include "poolGroup.h"
+
+using namespace BlockAllocatorExceptions;
+
+const size_t PoolGroup::maxMembers;
+
+const uint8_t PoolGroup::noMember;
+
+PoolGroup::Member::Member(size_t blockByteSize, size_t numOfBlocks) :
+		pool(blockByteSize, numOfBlocks), allocatedBy(new uint8_t[numOfBlocks]), takenBlocks(0), usedBlocks(0),
+		borrowedBlocks(0), lentBlocks(0), stashedBlocks(0), borrowedBatches(0)
+{}
+
+PoolGroup::PoolGroup(size_t blockByteSize, size_t blocksPerMember, size_t numOfMembers, size_t borrowBatchSize) :
+		borrowBatch(borrowBatchSize)
+{
+	if (numOfMembers == 0 || numOfMembers > maxMembers || borrowBatch == 0)
+		throw InvalidConstructorParametersException();
+
+	for (size_t i = 0; i < numOfMembers; i++)
+	{
+		members.emplace_back(new Member(blockByteSize, blocksPerMember));
+	}
+}
+
+PoolGroup::~PoolGroup()
+{
+	returnStashedBlocks();
+}
+
+void* PoolGroup::allocate(size_t member)
+{
+	Member& self = *members.at(member);
+
+	void* block = self.pool.tryAllocate();
+	if (block != NULL)
+	{
+		self.takenBlocks.fetch_add(1, std::memory_order_relaxed);
+		return handOut(block, member, member);
+	}
+
+	block = takeBorrowedBlock(member);
+	if (block != NULL)
+		return block;
+
+	// Free blocks may only be left in the stashes of other members, they are sent home and borrowing is retried once.
+	returnStashedBlocks();
+
+	block = self.pool.tryAllocate();
+	if (block != NULL)
+	{
+		self.takenBlocks.fetch_add(1, std::memory_order_relaxed);
+		return handOut(block, member, member);
+	}
+
+	block = takeBorrowedBlock(member);
+	if (block == NULL)
+		throw OutOfAllocatableMemoryException();
+
+	return block;
+}
+
+void PoolGroup::deallocate(void* block)
+{
+	size_t home = homeOf(block);
+	Member& owner = *members[home];
+	// Read before the block goes back, it may be allocated again at once.
+	uint8_t member = owner.allocatedBy[owner.pool.getBlockIndex(block)];
+
+	// Stashed blocks are in use for their pool, yet weren't allocated by any member.
+	if (member == noMember)
+		throw InvalidBlockAddressException();
+
+	owner.pool.deallocate(block);
+
+	Member& user = *members[member];
+	user.usedBlocks.fetch_sub(1, std::memory_order_relaxed);
+	owner.takenBlocks.fetch_sub(1, std::memory_order_relaxed);
+	if (member != home)
+	{
+		user.borrowedBlocks.fetch_sub(1, std::memory_order_relaxed);
+		owner.lentBlocks.fetch_sub(1, std::memory_order_relaxed);
+	}
+	else if (user.stashedBlocks.load(std::memory_order_relaxed) != 0)
+		returnStash(member);
+}
+
+void PoolGroup::returnStashedBlocks()
+{
+	for (size_t i = 0; i < members.size(); i++)
+	{
+		returnStash(i);
+	}
+}
+
+size_t PoolGroup::getNumOfMembers() const noexcept
+{
+	return members.size();
+}
+
+size_t PoolGroup::getBlockSize() const noexcept
+{
+	return members[0]->pool.getBlockSize();
+}
+
+size_t PoolGroup::getCapacity() const noexcept
+{
+	return members.size() * members[0]->pool.getNumOfBlocks();
+}
+
+size_t PoolGroup::getUsedBlocks() const noexcept
+{
+	size_t used = 0;
+	for (const std::unique_ptr<Member>& member : members)
+	{
+		used += member->usedBlocks.load(std::memory_order_relaxed);
+	}
+	return used;
+}
+
+PoolGroup::MemberStats PoolGroup::getMemberStats(size_t member) const
+{
+	const Member& self = *members.at(member);
+	MemberStats stats;
+
+	stats.usedBlocks = self.usedBlocks.load(std::memory_order_relaxed);
+	stats.borrowedBlocks = self.borrowedBlocks.load(std::memory_order_relaxed);
+	stats.lentBlocks = self.lentBlocks.load(std::memory_order_relaxed);
+	stats.stashedBlocks = self.stashedBlocks.load(std::memory_order_relaxed);
+	stats.borrowedBatches = self.borrowedBatches.load(std::memory_order_relaxed);
+	return stats;
+}
+
+const BlockAllocator& PoolGroup::getMemberPool(size_t member) const
+{
+	return members.at(member)->pool;
+}
+
+void* PoolGroup::takeBorrowedBlock(size_t member)
+{
+	Member& self = *members[member];
+	std::lock_guard<std::mutex> lock(self.stashMutex);
+
+	if (self.stash.empty())
+	{
+		// The sibling with the most free blocks lends, so one batch doesn't exhaust a nearly full sibling while an idle one is left alone.
+		size_t lender = member;
+		size_t mostFree = 0;
+		for (size_t i = 0; i < members.size(); i++)
+		{
+			size_t taken = members[i]->takenBlocks.load(std::memory_order_relaxed);
+			size_t capacity = members[i]->pool.getNumOfBlocks();
+			if (i != member && taken < capacity && capacity - taken > mostFree)
+			{
+				lender = i;
+				mostFree = capacity - taken;
+			}
+		}
+		if (lender == member)
+			return NULL;
+
+		Member& sibling = *members[lender];
+		for (size_t i = 0; i < borrowBatch; i++)
+		{
+			void* block = sibling.pool.tryAllocate();
+			if (block == NULL)
+				break;
+
+			sibling.allocatedBy[sibling.pool.getBlockIndex(block)] = noMember;
+			self.stash.push_back(block);
+		}
+		if (self.stash.empty())
+			return NULL;
+
+		sibling.takenBlocks.fetch_add(self.stash.size(), std::memory_order_relaxed);
+		sibling.lentBlocks.fetch_add(self.stash.size(), std::memory_order_relaxed);
+		self.stashedBlocks.store(self.stash.size(), std::memory_order_relaxed);
+		self.borrowedBatches.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void* block = self.stash.back();
+	self.stash.pop_back();
+	self.stashedBlocks.store(self.stash.size(), std::memory_order_relaxed);
+
+	return handOut(block, homeOf(block), member);
+}
+
+void PoolGroup::returnStash(size_t member)
+{
+	Member& self = *members[member];
+	std::lock_guard<std::mutex> lock(self.stashMutex);
+
+	for (void* block : self.stash)
+	{
+		Member& owner = *members[homeOf(block)];
+
+		owner.pool.deallocate(block);
+		owner.takenBlocks.fetch_sub(1, std::memory_order_relaxed);
+		owner.lentBlocks.fetch_sub(1, std::memory_order_relaxed);
+	}
+	self.stash.clear();
+	self.stashedBlocks.store(0, std::memory_order_relaxed);
+}
+
+size_t PoolGroup::homeOf(void* block) const
+{
+	for (size_t i = 0; i < members.size(); i++)
+	{
+		if (members[i]->pool.isBlockAddress(block))
+			return i;
+	}
+	throw InvalidBlockAddressException();
+}
+
+void* PoolGroup::handOut(void* block, size_t home, size_t member) noexcept
+{
+	Member& user = *members[member];
+
+	members[home]->allocatedBy[members[home]->pool.getBlockIndex(block)] = (uint8_t)member;
+	user.usedBlocks.fetch_add(1, std::memory_order_relaxed);
+	if (home != member)
+		user.borrowedBlocks.fetch_add(1, std::memory_order_relaxed);
+
+	return block;
+}
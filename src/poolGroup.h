@@ -0,0 +1,160 @@
+#ifndef _POOL_GROUP_H
+#define _POOL_GROUP_H
+
+//! \addtogroup BlockAllocator
+//! @{
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "blockAllocator.h"
+
+//! \brief A group of sibling pools of one geometry, a member which runs out of blocks borrows free blocks of the others.
+
+//! Every member, e.g. one per subsystem, allocates from its own pool first. Once it's exhausted the member borrows a batch of blocks
+//! from the sibling with the most free blocks, keeps the batch in a stash and serves from it until the stash runs empty.
+//! A block is always deallocated to its home pool, found by range checks of the member pools, whichever member allocated it.
+//! A member returns its stash as soon as a block of its own pool is freed, borrowed capacity is held no longer than needed.
+//! All members are thread-safe, the group adds a lock per member taken only while borrowing.
+//! ### Example
+//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
+//! PoolGroup buffers {4096, 1024, 3};
+//!
+//! void* request = buffers.allocate(networkMember);
+//! void* page = buffers.allocate(storageMember);
+//! ...
+//! buffers.deallocate(request);
+//! ~~~~~~~~~~~~~~~~~~~~~~~
+class PoolGroup
+{
+public:
+	//! \brief The maximum number of members.
+	static const size_t maxMembers = 255;
+
+	//! \brief Block accounting of one member.
+	struct MemberStats
+	{
+		//! \brief Blocks allocated through the member and not yet deallocated.
+		size_t usedBlocks;
+		//! \brief Used blocks which belong to sibling pools.
+		size_t borrowedBlocks;
+		//! \brief Blocks of the member pool held by siblings, used or stashed.
+		size_t lentBlocks;
+		//! \brief Borrowed blocks waiting in the member stash.
+		size_t stashedBlocks;
+		//! \brief The number of batches borrowed.
+		size_t borrowedBatches;
+	};
+
+	//! \brief PoolGroup constructor, creates the member pools.
+	//! \param[in] blockByteSize The block size of every member.
+	//! \param[in] blocksPerMember The number of blocks of every member pool.
+	//! \param[in] numOfMembers The number of members, must be greater than 0 and not greater than maxMembers.
+	//! \param[in] borrowBatchSize The number of blocks borrowed at once, must be greater than 0.
+	//! \throw BlockAllocatorExceptions::InvalidConstructorParametersException If invalid constructor parameters were passed.
+	//! \throw BlockAllocatorExceptions::OutOfSystemMemoryException If a member pool can't be allocated.
+	PoolGroup(size_t blockByteSize, size_t blocksPerMember, size_t numOfMembers, size_t borrowBatchSize = 16);
+
+	//! \brief Returns the stashed blocks, blocks still allocated become invalid.
+	~PoolGroup();
+
+	//! \brief Deleted copy constructor.
+	PoolGroup(const PoolGroup&) = delete;
+
+	//! \brief Deleted assignment operator.
+	PoolGroup& operator=(const PoolGroup&) = delete;
+
+	//! \brief Allocates a block for a member, from its own pool, its stash or a batch borrowed from a sibling.
+	//! \param[in] member The member index, less than getNumOfMembers().
+	//! \return Returns the block address.
+	//! \throw BlockAllocatorExceptions::OutOfAllocatableMemoryException If no pool of the group has a free block.
+	//! \throw std::out_of_range If the member index is invalid.
+	void* allocate(size_t member);
+
+	//! \brief Deallocates a block to its home pool.
+	//! \param[in] block A block returned by allocate() of any member.
+	//! \throw BlockAllocatorExceptions::InvalidBlockAddressException If the address isn't an allocated block of the group.
+	void deallocate(void* block);
+
+	//! \brief Returns the blocks stashed by every member to their home pools.
+	void returnStashedBlocks();
+
+	//! \brief Returns the number of members.
+	size_t getNumOfMembers() const noexcept;
+
+	//! \brief Returns the block size.
+	size_t getBlockSize() const noexcept;
+
+	//! \brief Returns the number of blocks of all member pools.
+	size_t getCapacity() const noexcept;
+
+	//! \brief Returns the number of blocks allocated through all members.
+	size_t getUsedBlocks() const noexcept;
+
+	//! \brief Returns the block accounting of a member.
+	//! \param[in] member The member index, less than getNumOfMembers().
+	//! \throw std::out_of_range If the member index is invalid.
+	MemberStats getMemberStats(size_t member) const;
+
+	//! \brief Returns the pool of a member, e.g. to inspect its memory overhead.
+	//! \param[in] member The member index, less than getNumOfMembers().
+	//! \throw std::out_of_range If the member index is invalid.
+	const BlockAllocator& getMemberPool(size_t member) const;
+
+private:
+	//! \brief Marks a stashed block, which no member allocated yet.
+	static const uint8_t noMember = 0xff;
+
+	//! \brief A pool of the group and its accounting.
+	struct Member
+	{
+		//! \brief Creates the member pool, every counter starts at zero.
+		Member(size_t blockByteSize, size_t numOfBlocks);
+
+		//! \brief The member pool.
+		BlockAllocator pool;
+		//! \brief The member which allocated every block of the pool, noMember for stashed blocks.
+		std::unique_ptr<uint8_t[]> allocatedBy;
+		//! \brief Blocks of the pool taken out, used or stashed by any member, tells the siblings with free blocks apart.
+		std::atomic<size_t> takenBlocks;
+		//! \brief Blocks allocated through the member and not yet deallocated, MemberStats::usedBlocks.
+		std::atomic<size_t> usedBlocks;
+		//! \brief Used blocks which belong to sibling pools, MemberStats::borrowedBlocks.
+		std::atomic<size_t> borrowedBlocks;
+		//! \brief Blocks of the pool held by siblings, used or stashed, MemberStats::lentBlocks.
+		std::atomic<size_t> lentBlocks;
+		//! \brief Borrowed blocks waiting in the stash, MemberStats::stashedBlocks.
+		std::atomic<size_t> stashedBlocks;
+		//! \brief The number of batches borrowed, MemberStats::borrowedBatches.
+		std::atomic<size_t> borrowedBatches;
+		//! \brief Guards the stash.
+		std::mutex stashMutex;
+		//! \brief Borrowed blocks not allocated yet.
+		std::vector<void*> stash;
+	};
+
+	//! \brief Takes a stashed block, borrowing a new batch if the stash is empty.
+	//! \return Returns the block, or NULL if no sibling has a free block.
+	void* takeBorrowedBlock(size_t member);
+
+	//! \brief Returns the blocks stashed by a member to their home pools.
+	void returnStash(size_t member);
+
+	//! \brief Returns the index of the member whose pool holds a block.
+	//! \throw BlockAllocatorExceptions::InvalidBlockAddressException If no member pool holds the address.
+	size_t homeOf(void* block) const;
+
+	//! \brief Records the member allocating a block.
+	void* handOut(void* block, size_t home, size_t member) noexcept;
+
+	//! \brief The members.
+	std::vector<std::unique_ptr<Member>> members;
+
+	//! \brief The number of blocks borrowed at once.
+	size_t borrowBatch;
+};
+
+//! @}
+#endif
@@ -0,0 +1,377 @@
+#ifndef _POOLED_HASH_MAP_H
+#define _POOLED_HASH_MAP_H
+
+//! \addtogroup BlockAllocator
+//! @{
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "blockAllocator.h"
+
+//! \brief A fixed capacity thread-safe hash map keeping its nodes in a BlockAllocator.
+
+//! All nodes live in one pool owned by the map, so nodes of a small map sit close to each other instead of being spread over the heap.
+//! Buckets and chains link nodes by 32-bit block indices rather than pointers, a bucket takes 4 bytes.
+//! Buckets are guarded by striped locks, lookups and updates of keys hashed to different stripes run in parallel.
+//! The node pool uses the lock-free RingFreeList by default, so writers of different stripes don't meet on a pool lock either.
+//! The number of buckets is fixed at construction, the map never rehashes.
+//! clear() returns all nodes to the pool at once instead of freeing them one by one.
+//! \tparam Key The key type, must be copy constructible.
+//! \tparam Value The mapped type, must be copy constructible and copy assignable.
+//! \tparam Hash The key hash function.
+//! \tparam KeyEqual The key comparison function.
+//! ### Example
+//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
+//! PooledHashMap<uint64_t, Session> sessions {100000};
+//!
+//! sessions.insert(id, session);
+//!
+//! Session found;
+//! if (sessions.find(id, found))
+//! {
+//! 	...
+//! }
+//! ~~~~~~~~~~~~~~~~~~~~~~~
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class PooledHashMap
+{
+public:
+	//! \brief PooledHashMap constructor.
+	//! \param[in] capacity The maximum number of entries, must be greater than 0 and less than 2^32 - 1.
+	//! \param[in] numOfStripes The number of bucket locks, rounded up to a power of two.
+	//! \param[in] numOfBuckets The number of buckets, rounded up to a power of two. The capacity is used if 0 is passed.
+	//! \param[in] nodeFreeList The free list engine of the node pool. The MutexFreeList reuses the most recently freed node first,
+	//! which keeps a small single-writer map hotter in the cache, and resets in constant time, but serializes all writers on the pool lock.
+	//! The RingFreeList refills its slots on clear(), which takes time linear in the capacity.
+	//! \throw BlockAllocatorExceptions::InvalidConstructorParametersException If the capacity or the engine is invalid.
+	//! \throw BlockAllocatorExceptions::OutOfSystemMemoryException If the node pool can't be allocated.
+	explicit PooledHashMap(size_t capacity, size_t numOfStripes = 64, size_t numOfBuckets = 0,
+			BlockAllocator::FreeListType nodeFreeList = BlockAllocator::RingFreeList) :
+		nodes(sizeof(Node), capacity, nodeConfig(nodeFreeList)), nodeBase((char*)nodes.getBlockAddress(0)), count(0)
+	{
+		size_t bucketCount = roundUpToPowerOfTwo(numOfBuckets == 0 ? capacity : numOfBuckets);
+		size_t stripeCount = std::min(roundUpToPowerOfTwo(numOfStripes), bucketCount);
+
+		bucketShift = 64;
+		for (size_t i = bucketCount; i > 1; i >>= 1)
+		{
+			--bucketShift;
+		}
+
+		buckets.reset(new uint32_t[bucketCount]);
+		for (size_t i = 0; i < bucketCount; i++)
+		{
+			buckets[i] = noNode;
+		}
+		bucketMask = bucketCount - 1;
+
+		stripes.reset(new Stripe[stripeCount]);
+		stripeMask = stripeCount - 1;
+	}
+
+	//! \brief Destroys the stored entries.
+	~PooledHashMap()
+	{
+		destroyNodes();
+	}
+
+	//! \brief Deleted copy constructor.
+	PooledHashMap(const PooledHashMap&) = delete;
+
+	//! \brief Deleted assignment operator.
+	PooledHashMap& operator=(const PooledHashMap&) = delete;
+
+	//! \brief Inserts an entry if the key isn't present.
+	//! \param[in] key The key.
+	//! \param[in] value The value.
+	//! \return Returns true if the entry was inserted, false if the key is already present.
+	//! \throw BlockAllocatorExceptions::OutOfAllocatableMemoryException If the map is full.
+	bool insert(const Key& key, const Value& value)
+	{
+		size_t bucket = bucketOf(key);
+		std::lock_guard<std::mutex> lock(stripeOf(bucket));
+
+		if (findNode(bucket, key) != NULL)
+			return false;
+
+		linkNode(bucket, key, value);
+		return true;
+	}
+
+	//! \brief Inserts an entry or replaces the value of a present key.
+	//! \param[in] key The key.
+	//! \param[in] value The value.
+	//! \return Returns true if the entry was inserted, false if the value was replaced.
+	//! \throw BlockAllocatorExceptions::OutOfAllocatableMemoryException If the key isn't present and the map is full.
+	bool insertOrAssign(const Key& key, const Value& value)
+	{
+		size_t bucket = bucketOf(key);
+		std::lock_guard<std::mutex> lock(stripeOf(bucket));
+
+		Node* node = findNode(bucket, key);
+		if (node != NULL)
+		{
+			node->value = value;
+			return false;
+		}
+
+		linkNode(bucket, key, value);
+		return true;
+	}
+
+	//! \brief Looks a key up.
+	//! \param[in] key The key.
+	//! \param[out] value Receives a copy of the value if the key is present.
+	//! \return Returns true if the key is present.
+	bool find(const Key& key, Value& value) const
+	{
+		size_t bucket = bucketOf(key);
+		std::lock_guard<std::mutex> lock(stripeOf(bucket));
+
+		const Node* node = findNode(bucket, key);
+		if (node == NULL)
+			return false;
+
+		value = node->value;
+		return true;
+	}
+
+	//! \brief Checks if a key is present.
+	//! \param[in] key The key.
+	//! \return Returns true if the key is present.
+	bool contains(const Key& key) const
+	{
+		size_t bucket = bucketOf(key);
+		std::lock_guard<std::mutex> lock(stripeOf(bucket));
+
+		return findNode(bucket, key) != NULL;
+	}
+
+	//! \brief Removes an entry.
+	//! \param[in] key The key.
+	//! \return Returns true if the entry was removed, false if the key isn't present.
+	bool erase(const Key& key)
+	{
+		size_t bucket = bucketOf(key);
+		std::lock_guard<std::mutex> lock(stripeOf(bucket));
+
+		uint32_t* link = &buckets[bucket];
+		while (*link != noNode)
+		{
+			Node* node = nodeAt(*link);
+			if (equal(node->key, key))
+			{
+				*link = node->next;
+				node->~Node();
+				nodes.deallocate(node);
+				count.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+			link = &node->next;
+		}
+		return false;
+	}
+
+	//! \brief Removes all entries, the node pool is reset at once.
+	//! \warning Entries inserted concurrently with clear() may be lost.
+	void clear()
+	{
+		// Reserved before the first lock, the stripes are unlocked by the destructors whatever throws.
+		std::vector<std::unique_lock<std::mutex>> locks;
+		locks.reserve(stripeMask + 1);
+		for (size_t i = 0; i <= stripeMask; i++)
+		{
+			locks.emplace_back(stripes[i].mutex);
+		}
+
+		destroyNodes();
+		for (size_t i = 0; i <= bucketMask; i++)
+		{
+			buckets[i] = noNode;
+		}
+		nodes.deallocateAll();
+		count.store(0, std::memory_order_relaxed);
+	}
+
+	//! \brief Returns the number of entries.
+	size_t size() const noexcept
+	{
+		return count.load(std::memory_order_relaxed);
+	}
+
+	//! \brief Returns the maximum number of entries.
+	size_t capacity() const noexcept
+	{
+		return nodes.getNumOfBlocks();
+	}
+
+	//! \brief Returns the node pool, e.g. to inspect its memory overhead.
+	const BlockAllocator& getAllocator() const noexcept
+	{
+		return nodes;
+	}
+
+private:
+	//! \brief A map entry kept in a pool block.
+	struct Node
+	{
+		Node(const Key& nodeKey, const Value& nodeValue, uint32_t nextNode) :
+			key(nodeKey), value(nodeValue), next(nextNode)
+		{}
+
+		//! \brief The entry key.
+		Key key;
+		//! \brief The entry value.
+		Value value;
+		//! \brief The index of the next node in the bucket chain.
+		uint32_t next;
+	};
+
+	// The compact pool has no alignment padding, its stride is the node size, which keeps nodes aligned in a malloc'ed pool.
+	static_assert(alignof(Node) <= alignof(std::max_align_t), "Over-aligned entries aren't supported");
+
+	//! \brief A bucket lock padded to keep neighbouring locks on different cache lines.
+	struct Stripe
+	{
+		std::mutex mutex;
+		char padding[64];
+	};
+
+	//! \brief Ends a bucket chain.
+	static const uint32_t noNode = std::numeric_limits<uint32_t>::max();
+
+	//! \brief Nodes are linked by indices, so the pool needs no block headers.
+	static BlockAllocator::Config nodeConfig(BlockAllocator::FreeListType freeList)
+	{
+		BlockAllocator::Config config;
+		config.layout = BlockAllocator::CompactLayout;
+		config.freeList = freeList;
+		return config;
+	}
+
+	static size_t roundUpToPowerOfTwo(size_t value)
+	{
+		size_t result = 1;
+		while (result < value)
+		{
+			result <<= 1;
+		}
+		return result;
+	}
+
+	//! \brief Returns the bucket of a key.
+	//! The hash is multiplied by 2^64 / golden ratio and the top bits are taken, so identity hashes of sequential
+	//! or aligned integers are still spread over all buckets.
+	size_t bucketOf(const Key& key) const
+	{
+		uint64_t mixed = (uint64_t)hasher(key) * 0x9E3779B97F4A7C15ull;
+
+		return bucketShift == 64 ? 0 : (size_t)(mixed >> bucketShift);
+	}
+
+	std::mutex& stripeOf(size_t bucket) const
+	{
+		return stripes[bucket & stripeMask].mutex;
+	}
+
+	//! \brief Converts an index to a node, the compact pool stride is the node size, so no call into the allocator is needed.
+	Node* nodeAt(uint32_t index) const
+	{
+		return (Node*)(nodeBase + (size_t)index * sizeof(Node));
+	}
+
+	uint32_t indexOf(const void* node) const
+	{
+		return (uint32_t)(((const char*)node - nodeBase) / sizeof(Node));
+	}
+
+	Node* findNode(size_t bucket, const Key& key) const
+	{
+		for (uint32_t index = buckets[bucket]; index != noNode;)
+		{
+			Node* node = nodeAt(index);
+			if (equal(node->key, key))
+				return node;
+			index = node->next;
+		}
+		return NULL;
+	}
+
+	//! \brief Creates a node at the head of the bucket chain, the caller holds the stripe lock.
+	void linkNode(size_t bucket, const Key& key, const Value& value)
+	{
+		void* block = nodes.allocate();
+		try
+		{
+			new (block) Node(key, value, buckets[bucket]);
+		}
+		catch (...)
+		{
+			nodes.deallocate(block);
+			throw;
+		}
+
+		buckets[bucket] = indexOf(block);
+		count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	//! \brief Runs the destructors of all stored entries, the pool itself isn't touched.
+	void destroyNodes()
+	{
+		if (std::is_trivially_destructible<Node>::value)
+			return;
+
+		for (size_t i = 0; i <= bucketMask; i++)
+		{
+			for (uint32_t index = buckets[i]; index != noNode;)
+			{
+				Node* node = nodeAt(index);
+				index = node->next;
+				node->~Node();
+			}
+		}
+	}
+
+	//! \brief The node pool.
+	BlockAllocator nodes;
+
+	//! \brief The address of the first node.
+	char* nodeBase;
+
+	//! \brief Bucket heads holding node indices.
+	std::unique_ptr<uint32_t[]> buckets;
+
+	//! \brief The number of buckets minus one.
+	size_t bucketMask = 0;
+
+	//! \brief 64 minus the number of bucket index bits.
+	unsigned bucketShift = 64;
+
+	//! \brief Bucket locks.
+	std::unique_ptr<Stripe[]> stripes;
+
+	//! \brief The number of locks minus one.
+	size_t stripeMask = 0;
+
+	//! \brief The number of entries.
+	std::atomic<size_t> count;
+
+	Hash hasher;
+
+	KeyEqual equal;
+};
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+const uint32_t PooledHashMap<Key, Value, Hash, KeyEqual>::noNode;
+
+//! @}
+#endif
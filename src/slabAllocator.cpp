@@ -0,0 +1,243 @@
+#include "slabAllocator.h"
+
+using namespace BlockAllocatorExceptions;
+
+// Returns the position of the lowest set bit, the word must not be zero.
+static size_t lowestSetBit(uint64_t word) noexcept
+{
+#if defined(__GNUC__)
+	return (size_t)__builtin_ctzll(word);
+#else
+	size_t position = 0;
+	while ((word & 1) == 0)
+	{
+		word >>= 1;
+		++position;
+	}
+	return position;
+#endif
+}
+
+SlabAllocator::SlabAllocator(BlockAllocator& parentAllocator, size_t slotByteSize) :
+		parent(parentAllocator), slotSize(slotByteSize)
+{
+	const size_t blockSize = parent.getBlockSize();
+
+	if (slotSize == 0 || slotSize > blockSize || blockSize - slotSize < sizeof(Footer) + sizeof(uint64_t))
+		throw InvalidConstructorParametersException();
+
+	// The bitmap grows with the number of slots, so the largest number whose slots, bitmap and footer fit the block is searched downwards.
+	for (size_t slots = (blockSize - sizeof(Footer)) / slotSize; slots > 0; slots--)
+	{
+		size_t words = (slots + 63) / 64;
+		if (sizeof(Footer) + words * sizeof(uint64_t) > blockSize)
+			continue;
+
+		size_t offset = (blockSize - sizeof(Footer) - words * sizeof(uint64_t)) / sizeof(uint64_t) * sizeof(uint64_t);
+		if (slots * slotSize <= offset)
+		{
+			slotsPerBlock = slots;
+			bitmapWords = words;
+			footerOffset = offset;
+			break;
+		}
+	}
+
+	if (slotsPerBlock == 0)
+		throw InvalidConstructorParametersException();
+
+	parentBase = (char*)parent.getBlockAddress(0);
+	parentStride = parent.getNumOfBlocks() > 1 ? (size_t)((char*)parent.getBlockAddress(1) - parentBase) : blockSize;
+	heldBlocks.assign((parent.getNumOfBlocks() + 63) / 64, 0);
+}
+
+SlabAllocator::~SlabAllocator()
+{
+	releaseBlocks(partialBlocks);
+	releaseBlocks(fullBlocks);
+}
+
+void* SlabAllocator::allocate()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// The empty block is left alone while another block has free slots, it's kept for churn rather than filled.
+	Footer* footer = partialBlocks;
+	if (footer == NULL)
+		footer = takeBlock();
+	else if (footer == emptyBlock && footer->next != NULL)
+		footer = footer->next;
+
+	if (footer == emptyBlock)
+		emptyBlock = NULL;
+
+	uint64_t* bitmap = bitmapOf(footer);
+	size_t word = 0;
+	while (bitmap[word] == 0)
+	{
+		++word;
+	}
+
+	size_t bit = lowestSetBit(bitmap[word]);
+	bitmap[word] &= bitmap[word] - 1;
+
+	if (--footer->freeSlots == 0)
+	{
+		unlink(partialBlocks, footer);
+		link(fullBlocks, footer);
+	}
+	++numOfSlots;
+
+	return (char*)footer - footerOffset + (word * 64 + bit) * slotSize;
+}
+
+void SlabAllocator::deallocate(void* slot)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	Footer* footer = footerOf(slot);
+	if (footer == NULL)
+		throw InvalidBlockAddressException();
+
+	size_t offset = (size_t)((char*)slot - ((char*)footer - footerOffset));
+	size_t index = offset / slotSize;
+	if (offset % slotSize != 0 || index >= slotsPerBlock)
+		throw InvalidBlockAddressException();
+
+	uint64_t* bitmap = bitmapOf(footer);
+	uint64_t mask = (uint64_t)1 << (index % 64);
+	if ((bitmap[index / 64] & mask) != 0)
+		throw InvalidBlockAddressException();
+
+	bitmap[index / 64] |= mask;
+	--numOfSlots;
+
+	if (footer->freeSlots++ == 0)
+	{
+		unlink(fullBlocks, footer);
+		link(partialBlocks, footer);
+	}
+
+	if (footer->freeSlots == slotsPerBlock)
+	{
+		if (emptyBlock == NULL)
+		{
+			emptyBlock = footer;
+			return;
+		}
+
+		unlink(partialBlocks, footer);
+		releaseBlock(footer);
+	}
+}
+
+size_t SlabAllocator::getSlotSize() const noexcept
+{
+	return slotSize;
+}
+
+size_t SlabAllocator::getSlotsPerBlock() const noexcept
+{
+	return slotsPerBlock;
+}
+
+size_t SlabAllocator::getNumOfBlocks()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return numOfBlocks;
+}
+
+size_t SlabAllocator::getNumOfSlots()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return numOfSlots;
+}
+
+uint64_t* SlabAllocator::bitmapOf(Footer* footer) const noexcept
+{
+	return (uint64_t*)(footer + 1);
+}
+
+SlabAllocator::Footer* SlabAllocator::footerOf(void* slot) const noexcept
+{
+	char* address = (char*)slot;
+	if (address < parentBase)
+		return NULL;
+
+	size_t index = (size_t)(address - parentBase) / parentStride;
+	if (index >= parent.getNumOfBlocks() || (heldBlocks[index / 64] & ((uint64_t)1 << (index % 64))) == 0)
+		return NULL;
+
+	return (Footer*)(parentBase + index * parentStride + footerOffset);
+}
+
+void SlabAllocator::markHeld(Footer* footer, bool isHeld) noexcept
+{
+	size_t index = (size_t)((char*)footer - footerOffset - parentBase) / parentStride;
+	uint64_t mask = (uint64_t)1 << (index % 64);
+
+	if (isHeld)
+		heldBlocks[index / 64] |= mask;
+	else
+		heldBlocks[index / 64] &= ~mask;
+}
+
+void SlabAllocator::releaseBlock(Footer* footer) noexcept
+{
+	markHeld(footer, false);
+	parent.deallocate((char*)footer - footerOffset);
+	--numOfBlocks;
+}
+
+SlabAllocator::Footer* SlabAllocator::takeBlock()
+{
+	char* block = (char*)parent.allocate();
+	Footer* footer = (Footer*)(block + footerOffset);
+	uint64_t* bitmap = bitmapOf(footer);
+
+	for (size_t i = 0; i < bitmapWords; i++)
+	{
+		bitmap[i] = ~(uint64_t)0;
+	}
+	if (slotsPerBlock % 64 != 0)
+		bitmap[bitmapWords - 1] = ((uint64_t)1 << (slotsPerBlock % 64)) - 1;
+
+	markHeld(footer, true);
+	footer->freeSlots = slotsPerBlock;
+	footer->prev = NULL;
+	footer->next = NULL;
+	link(partialBlocks, footer);
+	++numOfBlocks;
+
+	return footer;
+}
+
+void SlabAllocator::unlink(Footer*& list, Footer* footer) noexcept
+{
+	if (footer->prev != NULL)
+		footer->prev->next = footer->next;
+	else
+		list = footer->next;
+
+	if (footer->next != NULL)
+		footer->next->prev = footer->prev;
+}
+
+void SlabAllocator::link(Footer*& list, Footer* footer) noexcept
+{
+	footer->prev = NULL;
+	footer->next = list;
+	if (list != NULL)
+		list->prev = footer;
+	list = footer;
+}
+
+void SlabAllocator::releaseBlocks(Footer* list) noexcept
+{
+	while (list != NULL)
+	{
+		Footer* next = list->next;
+		releaseBlock(list);
+		list = next;
+	}
+}
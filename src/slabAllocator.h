@@ -0,0 +1,151 @@
+#ifndef _SLAB_ALLOCATOR_H
+#define _SLAB_ALLOCATOR_H
+
+//! \addtogroup BlockAllocator
+//! @{
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+
+#include "blockAllocator.h"
+
+//! \brief Allocates tiny fixed size slots carved out of the blocks of a parent BlockAllocator.
+
+//! Each parent block, preferably page sized, is split into slots with no per slot header.
+//! The slots of a block are tracked by a bitmap kept in a footer at the end of the block, a free slot is found with a bit scan.
+//! Blocks with free slots are kept in a list, the most recently used first. One block whose slots are all free is kept,
+//! so a slot allocated and freed over and over doesn't take and return a parent block every time, further empty blocks go back to the parent at once.
+//! Parent blocks held are marked in a bitmap by their parent index, an address in a parent block handed out to someone else is rejected
+//! without looking into the block.
+//! Slots are aligned to 8 bytes if the slot size is a multiple of 8 and the parent blocks are 8 byte aligned.
+//! \warning The parent allocator must outlive the slab allocator.
+//! ### Example
+//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
+//! BlockAllocator pages {4096, 1024};
+//! SlabAllocator nodes {pages, 24};
+//!
+//! void* node = nodes.allocate();
+//! ...
+//! nodes.deallocate(node);
+//! ~~~~~~~~~~~~~~~~~~~~~~~
+class SlabAllocator
+{
+public:
+	//! \brief SlabAllocator constructor.
+	//! \param[in] parentAllocator The allocator the blocks are taken from.
+	//! \param[in] slotByteSize The slot size in bytes, must be greater than 0 and leave room for at least one slot and the footer in a parent block.
+	//! \throw BlockAllocatorExceptions::InvalidConstructorParametersException If invalid constructor parameters were passed.
+	SlabAllocator(BlockAllocator& parentAllocator, size_t slotByteSize);
+
+	//! \brief Returns the blocks held to the parent, slots still allocated become invalid.
+	~SlabAllocator();
+
+	//! \brief Deleted copy constructor.
+	SlabAllocator(const SlabAllocator&) = delete;
+
+	//! \brief Deleted assignment operator.
+	SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+	//! \brief Returns a free slot, a new parent block is taken if no held block has one.
+	//! \return Returns a pointer to the slot.
+	//! \throw BlockAllocatorExceptions::OutOfAllocatableMemoryException If the parent has no free block.
+	void* allocate();
+
+	//! \brief Frees a slot, its block goes back to the parent if all its slots are free and another empty block is kept already.
+	//! \param[in] slot The slot address as returned by allocate().
+	//! \throw BlockAllocatorExceptions::InvalidBlockAddressException If the address isn't an allocated slot of this allocator.
+	void deallocate(void* slot);
+
+	//! \brief Returns the slot size in bytes.
+	size_t getSlotSize() const noexcept;
+
+	//! \brief Returns the number of slots in one parent block.
+	size_t getSlotsPerBlock() const noexcept;
+
+	//! \brief Returns the number of parent blocks held.
+	size_t getNumOfBlocks();
+
+	//! \brief Returns the number of allocated slots.
+	size_t getNumOfSlots();
+
+private:
+	//! \brief Ends every held block, followed in memory by the slot bitmap.
+	struct Footer
+	{
+		//! \brief The previous block in the same list.
+		Footer* prev;
+		//! \brief The next block in the same list.
+		Footer* next;
+		//! \brief The number of free slots.
+		size_t freeSlots;
+	};
+
+	//! \brief The parent allocator.
+	BlockAllocator& parent;
+
+	//! \brief The slot size.
+	size_t slotSize;
+
+	//! \brief The number of slots in a block.
+	size_t slotsPerBlock = 0;
+
+	//! \brief The number of 64-bit bitmap words, a set bit marks a free slot.
+	size_t bitmapWords = 0;
+
+	//! \brief The footer offset from the block start.
+	size_t footerOffset = 0;
+
+	//! \brief The address of the first parent block.
+	char* parentBase;
+
+	//! \brief The distance between the addresses of neighbouring parent blocks.
+	size_t parentStride;
+
+	//! \brief Blocks with free slots.
+	Footer* partialBlocks = NULL;
+
+	//! \brief Blocks with no free slot.
+	Footer* fullBlocks = NULL;
+
+	//! \brief The empty block kept on the partial list, or NULL.
+	Footer* emptyBlock = NULL;
+
+	//! \brief Marks the parent blocks held, by parent block index.
+	std::vector<uint64_t> heldBlocks;
+
+	//! \brief The number of held blocks.
+	size_t numOfBlocks = 0;
+
+	//! \brief The number of allocated slots.
+	size_t numOfSlots = 0;
+
+	//! \brief Guards the lists and the footers.
+	std::mutex mutex;
+
+	//! \brief Returns the bitmap following a footer.
+	uint64_t* bitmapOf(Footer* footer) const noexcept;
+
+	//! \brief Returns the footer of the held block holding an address, or NULL if no held block holds it.
+	Footer* footerOf(void* slot) const noexcept;
+
+	//! \brief Marks a parent block as held or not.
+	void markHeld(Footer* footer, bool isHeld) noexcept;
+
+	//! \brief Returns a block to the parent.
+	void releaseBlock(Footer* footer) noexcept;
+
+	//! \brief Takes a parent block and puts a footer with all slots free at its end.
+	Footer* takeBlock();
+
+	//! \brief Unlinks a block from its list.
+	void unlink(Footer*& list, Footer* footer) noexcept;
+
+	//! \brief Links a block to the head of a list.
+	void link(Footer*& list, Footer* footer) noexcept;
+
+	//! \brief Returns the blocks of a list to the parent.
+	void releaseBlocks(Footer* list) noexcept;
+};
+
+//! @}
+#endif
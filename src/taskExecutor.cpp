@@ -0,0 +1,233 @@
+#include "taskExecutor.h"
+
+using namespace BlockAllocatorExceptions;
+
+thread_local TaskExecutor::Worker* TaskExecutor::currentWorker = NULL;
+
+const size_t TaskExecutor::taskOffset;
+const size_t TaskExecutor::cacheCapacity;
+
+// Task blocks are a multiple of the maximal alignment, so every block of the compact pool is aligned as malloc'ed memory is.
+static size_t taskBlockSize(size_t maxTaskSize, size_t taskOffset)
+{
+	const size_t alignment = alignof(std::max_align_t);
+
+	if (maxTaskSize == 0 || maxTaskSize > SIZE_MAX - taskOffset - alignment)
+		throw InvalidConstructorParametersException();
+
+	return (taskOffset + maxTaskSize + alignment - 1) / alignment * alignment;
+}
+
+static BlockAllocator::Config taskPoolConfig()
+{
+	BlockAllocator::Config config;
+	config.layout = BlockAllocator::CompactLayout;
+	return config;
+}
+
+TaskExecutor::TaskExecutor(size_t workersCount, size_t maxTaskSize, size_t maxTasks) :
+		pool(taskBlockSize(maxTaskSize, taskOffset),
+				// Worker caches may hold blocks too, so maxTasks tasks can always be submitted.
+				maxTasks == 0 || workersCount == 0 ? 0 : maxTasks + workersCount * cacheCapacity, taskPoolConfig()),
+		numOfWorkers(workersCount), nextWorker(0), queuedTasks(0), unfinishedTasks(0), idleWorkers(0)
+{
+	size_t dequeSize = 1;
+	while (dequeSize < pool.getNumOfBlocks())
+	{
+		dequeSize <<= 1;
+	}
+	dequeMask = dequeSize - 1;
+
+	workers.reset(new Worker[numOfWorkers]);
+	for (size_t i = 0; i < numOfWorkers; i++)
+	{
+		workers[i].executor = this;
+		workers[i].tasks.reset(new uint32_t[dequeSize]);
+		workers[i].cache.reserve(cacheCapacity);
+	}
+
+	for (size_t i = 0; i < numOfWorkers; i++)
+	{
+		Worker& worker = workers[i];
+		worker.thread = std::thread([this, &worker]()
+		{
+			runWorker(worker);
+		});
+	}
+}
+
+TaskExecutor::~TaskExecutor()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		isStopping = true;
+	}
+	taskQueued.notify_all();
+
+	for (size_t i = 0; i < numOfWorkers; i++)
+	{
+		workers[i].thread.join();
+	}
+}
+
+void* TaskExecutor::takeTaskBlock()
+{
+	Worker* worker = currentWorker;
+
+	if (worker != NULL && worker->executor == this && !worker->cache.empty())
+	{
+		void* block = worker->cache.back();
+		worker->cache.pop_back();
+		return block;
+	}
+
+	return pool.allocate();
+}
+
+void TaskExecutor::releaseTaskBlock(void* block)
+{
+	Worker* worker = currentWorker;
+
+	if (worker == NULL || worker->executor != this)
+	{
+		pool.deallocate(block);
+		return;
+	}
+
+	// Half of a full cache goes back at once, so a worker which only runs tasks takes the pool lock once per cacheCapacity / 2 tasks.
+	if (worker->cache.size() == cacheCapacity)
+	{
+		pool.deallocate(worker->cache.data() + cacheCapacity / 2, cacheCapacity / 2);
+		worker->cache.resize(cacheCapacity / 2);
+	}
+	worker->cache.push_back(block);
+}
+
+void TaskExecutor::enqueueTask(void* block)
+{
+	Worker* target = currentWorker;
+
+	if (target == NULL || target->executor != this)
+		target = &workers[nextWorker.fetch_add(1, std::memory_order_relaxed) % numOfWorkers];
+
+	uint32_t index = (uint32_t)pool.getBlockIndex(block);
+
+	// Counted before the task is visible, so it can't finish before it's counted.
+	unfinishedTasks.fetch_add(1);
+	queuedTasks.fetch_add(1);
+	{
+		std::lock_guard<std::mutex> lock(target->mutex);
+		target->tasks[target->back++ & dequeMask] = index;
+	}
+
+	// Pairs with runWorker(), which announces itself idle before it checks queuedTasks.
+	// A worker being woken isn't idle anymore, so tasks submitted until it runs don't wake it again.
+	if (idleWorkers.load() != 0)
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		if (idleWorkers.load() != 0)
+		{
+			idleWorkers.fetch_sub(1);
+			++pendingWakeups;
+			taskQueued.notify_one();
+		}
+	}
+}
+
+void* TaskExecutor::takeTask(Worker& worker)
+{
+	{
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		if (worker.back != worker.front)
+		{
+			queuedTasks.fetch_sub(1);
+			return pool.getBlockAddress(worker.tasks[--worker.back & dequeMask]);
+		}
+	}
+
+	size_t self = &worker - workers.get();
+	for (size_t i = 1; i < numOfWorkers; i++)
+	{
+		Worker& victim = workers[(self + i) % numOfWorkers];
+
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (victim.back != victim.front)
+		{
+			queuedTasks.fetch_sub(1);
+			return pool.getBlockAddress(victim.tasks[victim.front++ & dequeMask]);
+		}
+	}
+	return NULL;
+}
+
+void TaskExecutor::runTask(void* block)
+{
+	TaskHeader* header = (TaskHeader*)block;
+
+	header->run((char*)block + taskOffset);
+	releaseTaskBlock(block);
+
+	if (unfinishedTasks.fetch_sub(1) == 1)
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		allFinished.notify_all();
+	}
+}
+
+void TaskExecutor::runWorker(Worker& worker)
+{
+	currentWorker = &worker;
+
+	for (;;)
+	{
+		void* task = takeTask(worker);
+		if (task != NULL)
+		{
+			runTask(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		idleWorkers.fetch_add(1);
+		taskQueued.wait(lock, [this]()
+		{
+			return isStopping || queuedTasks.load() != 0;
+		});
+		if (pendingWakeups != 0)
+			--pendingWakeups;
+		else
+			idleWorkers.fetch_sub(1);
+
+		// The tasks left are run before stopping, a running task may still queue more to its own worker.
+		if (isStopping && queuedTasks.load() == 0)
+			break;
+	}
+
+	pool.deallocate(worker.cache.data(), worker.cache.size());
+	worker.cache.clear();
+	currentWorker = NULL;
+}
+
+void TaskExecutor::waitForAll()
+{
+	std::unique_lock<std::mutex> lock(sleepMutex);
+	allFinished.wait(lock, [this]()
+	{
+		return unfinishedTasks.load() == 0;
+	});
+}
+
+size_t TaskExecutor::getMaxTaskSize() const noexcept
+{
+	return pool.getBlockSize() - taskOffset;
+}
+
+size_t TaskExecutor::getNumOfWorkers() const noexcept
+{
+	return numOfWorkers;
+}
+
+size_t TaskExecutor::getUnfinishedTasks() const noexcept
+{
+	return unfinishedTasks.load();
+}
@@ -0,0 +1,206 @@
+#ifndef _TASK_EXECUTOR_H
+#define _TASK_EXECUTOR_H
+
+//! \addtogroup BlockAllocator
+//! @{
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "blockAllocator.h"
+
+//! \brief A work-stealing thread pool running callables stored inline in BlockAllocator blocks.
+
+//! Every submitted callable is moved into a task block of a pool owned by the executor, nothing is allocated from the heap.
+//! Each worker has its own deque of task block indices, it runs its newest task first and idle workers steal the oldest tasks of the others.
+//! Tasks submitted from a worker go to its own deque, tasks submitted from other threads are spread over the workers.
+//! Blocks of finished tasks are kept in a small per-worker cache and reused by tasks the worker submits, overflowing caches are returned to the pool in bulk.
+//! \warning Tasks must not throw, an escaping exception terminates the program as with std::thread.
+//! ### Example
+//! ~~~~~~~~~~~~~~~~~~~~~~~.cpp
+//! TaskExecutor executor {4, 64, 4096};
+//!
+//! executor.submit([&request]()
+//! {
+//! 	...
+//! });
+//!
+//! executor.waitForAll();
+//! ~~~~~~~~~~~~~~~~~~~~~~~
+class TaskExecutor
+{
+public:
+	//! \brief TaskExecutor constructor, starts the workers.
+	//! \param[in] numOfWorkers The number of worker threads, must be greater than 0.
+	//! \param[in] maxTaskSize The maximum size of a callable in bytes, must be greater than 0.
+	//! \param[in] maxTasks The maximum number of tasks submitted and not finished yet, must be greater than 0.
+	//! \throw BlockAllocatorExceptions::InvalidConstructorParametersException If invalid constructor parameters were passed.
+	//! \throw BlockAllocatorExceptions::OutOfSystemMemoryException If the task pool can't be allocated.
+	TaskExecutor(size_t numOfWorkers, size_t maxTaskSize, size_t maxTasks);
+
+	//! \brief Runs the tasks left and stops the workers.
+	~TaskExecutor();
+
+	//! \brief Deleted copy constructor.
+	TaskExecutor(const TaskExecutor&) = delete;
+
+	//! \brief Deleted assignment operator.
+	TaskExecutor& operator=(const TaskExecutor&) = delete;
+
+	//! \brief Queues a callable to be run by a worker.
+	//! \param[in] callable A callable taking no arguments, it's moved or copied into a task block.
+	//! \throw BlockAllocatorExceptions::TaskTooLargeException If the callable is bigger than the maximum task size.
+	//! \throw BlockAllocatorExceptions::OutOfAllocatableMemoryException If the maximum number of tasks is reached.
+	template <typename Callable>
+	void submit(Callable&& callable)
+	{
+		typedef typename std::decay<Callable>::type Task;
+		static_assert(alignof(Task) <= alignof(std::max_align_t), "Over-aligned tasks aren't supported");
+
+		if (sizeof(Task) > getMaxTaskSize())
+			throw BlockAllocatorExceptions::TaskTooLargeException();
+
+		TaskHeader* header = (TaskHeader*)takeTaskBlock();
+		try
+		{
+			new ((char*)header + taskOffset) Task(std::forward<Callable>(callable));
+		}
+		catch (...)
+		{
+			releaseTaskBlock(header);
+			throw;
+		}
+		header->run = &runAndDestroy<Task>;
+
+		enqueueTask(header);
+	}
+
+	//! \brief Blocks until every submitted task, including the tasks they submit, has finished.
+	//! \warning Must not be called from a task.
+	void waitForAll();
+
+	//! \brief Returns the maximum size of a callable in bytes.
+	size_t getMaxTaskSize() const noexcept;
+
+	//! \brief Returns the number of worker threads.
+	size_t getNumOfWorkers() const noexcept;
+
+	//! \brief Returns the number of tasks submitted and not finished yet.
+	size_t getUnfinishedTasks() const noexcept;
+
+private:
+	//! \brief Precedes the callable in a task block.
+	struct TaskHeader
+	{
+		//! \brief Runs the callable and destroys it.
+		void (*run)(void* callable);
+	};
+
+	//! \brief A worker thread with its task deque and block cache.
+	struct Worker
+	{
+		//! \brief The executor the worker belongs to.
+		TaskExecutor* executor;
+		//! \brief Guards the deque, taken by the worker and by thieves.
+		std::mutex mutex;
+		//! \brief The deque ring of task block indices.
+		std::unique_ptr<uint32_t[]> tasks;
+		//! \brief The oldest task position, thieves take from here.
+		size_t front = 0;
+		//! \brief The position after the newest task, the worker takes from here.
+		size_t back = 0;
+		//! \brief Blocks of finished tasks, used by the worker thread only.
+		std::vector<void*> cache;
+		//! \brief The worker thread.
+		std::thread thread;
+		//! \brief Keeps the deques of neighbouring workers on different cache lines.
+		char padding[64];
+	};
+
+	//! \brief The callable starts at this offset of a task block, so it's aligned as any scalar type.
+	static const size_t taskOffset = alignof(std::max_align_t);
+
+	//! \brief The maximum number of cached blocks per worker.
+	static const size_t cacheCapacity = 64;
+
+	//! \brief The worker run by the calling thread, NULL in other threads.
+	static thread_local Worker* currentWorker;
+
+	template <typename Task>
+	static void runAndDestroy(void* callable)
+	{
+		Task* task = (Task*)callable;
+
+		(*task)();
+		task->~Task();
+	}
+
+	//! \brief The task block pool.
+	BlockAllocator pool;
+
+	//! \brief The number of workers.
+	size_t numOfWorkers;
+
+	//! \brief The workers.
+	std::unique_ptr<Worker[]> workers;
+
+	//! \brief The number of deque slots minus one.
+	size_t dequeMask = 0;
+
+	//! \brief Picks the worker for tasks submitted by other threads.
+	std::atomic<size_t> nextWorker;
+
+	//! \brief The number of tasks in all deques.
+	std::atomic<size_t> queuedTasks;
+
+	//! \brief The number of tasks submitted and not finished yet.
+	std::atomic<size_t> unfinishedTasks;
+
+	//! \brief The number of workers waiting for a task.
+	std::atomic<size_t> idleWorkers;
+
+	//! \brief The number of workers notified and not running yet, guarded by sleepMutex.
+	size_t pendingWakeups = 0;
+
+	//! \brief Set by the destructor.
+	bool isStopping = false;
+
+	//! \brief Guards the sleeping and waiting for completion.
+	std::mutex sleepMutex;
+
+	//! \brief Notified when a task is queued or the executor stops.
+	std::condition_variable taskQueued;
+
+	//! \brief Notified when the last unfinished task finishes.
+	std::condition_variable allFinished;
+
+	//! \brief Returns a free task block, from the worker cache if called by a worker.
+	void* takeTaskBlock();
+
+	//! \brief Returns a task block to the worker cache or to the pool.
+	void releaseTaskBlock(void* block);
+
+	//! \brief Pushes a task to a deque and wakes an idle worker.
+	void enqueueTask(void* block);
+
+	//! \brief Takes the newest task of the worker or steals the oldest task of another one.
+	//! \return Returns NULL if all deques are empty.
+	void* takeTask(Worker& worker);
+
+	//! \brief Runs a task and releases its block.
+	void runTask(void* block);
+
+	//! \brief The worker thread function.
+	void runWorker(Worker& worker);
+};
+
+//! @}
+#endif
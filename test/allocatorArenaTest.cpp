@@ -0,0 +1,146 @@
+#include "CppUTest/TestHarness.h"
+
+#include <thread>
+#include <unistd.h>
+
+#include "../src/allocatorArena.h"
+
+using namespace BlockAllocatorExceptions;
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(AllocatorArena)
+{
+	size_t blockSize = 32;
+	size_t numOfBlocks = 4;
+	size_t maxAllocators = 8;
+
+	AllocatorArena* arena;
+
+    void setup()
+    {
+    	arena = new AllocatorArena(blockSize, numOfBlocks, maxAllocators);
+    }
+    void teardown()
+    {
+    	delete arena;
+	}
+};
+
+TEST(AllocatorArena, createdAllocatorServesAllBlocks)
+{
+	BlockAllocator* ba = arena->createAllocator();
+
+	for (size_t i = 0; i < numOfBlocks; i++)
+	{
+		memset(ba->allocate(), 0xff, blockSize);
+	}
+
+	CHECK_THROWS(OutOfAllocatableMemoryException, ba->allocate());
+	LONGS_EQUAL(blockSize, ba->getBlockSize());
+	LONGS_EQUAL(BlockAllocator::External, ba->getPoolType());
+}
+
+TEST(AllocatorArena, allocatorsDontShareBlocks)
+{
+	BlockAllocator* first = arena->createAllocator();
+	BlockAllocator* second = arena->createAllocator();
+
+	void* block = first->allocate();
+
+	CHECK_TRUE(first->isBlockAddress(block));
+	CHECK_FALSE(second->isBlockAddress(block));
+	CHECK_THROWS(InvalidBlockAddressException, second->deallocate(block));
+}
+
+TEST(AllocatorArena, tooManyAllocatorsThrow)
+{
+	for (size_t i = 0; i < maxAllocators; i++)
+	{
+		arena->createAllocator();
+	}
+
+	CHECK_THROWS(OutOfAllocatableMemoryException, arena->createAllocator());
+	LONGS_EQUAL(maxAllocators, arena->getNumOfAllocators());
+}
+
+TEST(AllocatorArena, destroyedSlotIsReused)
+{
+	BlockAllocator* first = arena->createAllocator();
+	first->allocate();
+
+	arena->destroyAllocator(first);
+	BlockAllocator* second = arena->createAllocator();
+
+	POINTERS_EQUAL(first, second);
+	for (size_t i = 0; i < numOfBlocks; i++)
+	{
+		second->allocate();
+	}
+	LONGS_EQUAL(1, arena->getNumOfAllocators());
+}
+
+TEST(AllocatorArena, foreignOrDestroyedAllocatorIsRejected)
+{
+	BlockAllocator foreign {blockSize, numOfBlocks};
+	BlockAllocator* ba = arena->createAllocator();
+	arena->destroyAllocator(ba);
+
+	CHECK_THROWS(InvalidBlockAddressException, arena->destroyAllocator(&foreign));
+	CHECK_THROWS(InvalidBlockAddressException, arena->destroyAllocator(ba));
+}
+
+TEST(AllocatorArena, allocatorIsOwnedByCreatingThread)
+{
+	BlockAllocator* ba = arena->createAllocator();
+	bool thrown = false;
+
+	std::thread other([ba, &thrown]()
+	{
+		try
+		{
+			ba->allocate();
+		}
+		catch (const NotOwnerThreadException& e)
+		{
+			thrown = true;
+		}
+	});
+	other.join();
+
+	CHECK_TRUE(thrown);
+	CHECK_TRUE(ba->allocate() != NULL);
+}
+
+TEST(AllocatorArena, pagesOfDestroyedPoolsAreTrimmed)
+{
+	size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	AllocatorArena large {pageSize, 4, 2};
+
+	BlockAllocator* ba = large.createAllocator();
+	memset(ba->allocate(), 1, pageSize);
+	size_t freeSlotBytes = large.trim();
+
+	large.destroyAllocator(ba);
+	CHECK_TRUE(freeSlotBytes > 0);
+	CHECK_TRUE(large.trim() > freeSlotBytes);
+}
+
+TEST(AllocatorArena, adjacentFreePoolsAreTrimmedTogether)
+{
+	size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	AllocatorArena small {64, 16, 64};
+	CHECK_TRUE(small.getPoolSize() < pageSize);
+
+	// No single pool holds a whole page, the run of all of them does.
+	BlockAllocator* ba = small.createAllocator();
+	small.destroyAllocator(ba);
+	CHECK_TRUE(small.trim() >= 64 * small.getPoolSize() - 2 * pageSize);
+}
+
+TEST(AllocatorArena, invalidParametersAreRejected)
+{
+	CHECK_THROWS(InvalidConstructorParametersException, AllocatorArena(0, numOfBlocks, maxAllocators));
+	CHECK_THROWS(InvalidConstructorParametersException, AllocatorArena(blockSize, 0, maxAllocators));
+	CHECK_THROWS(InvalidConstructorParametersException, AllocatorArena(blockSize, numOfBlocks, 0));
+}
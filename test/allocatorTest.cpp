@@ -7,6 +7,11 @@
 #include <vector>
 #include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <unistd.h>
+#include <sys/wait.h>
 
 #include "../src/blockAllocator.h"
 
@@ -792,3 +797,1677 @@ TEST(MultithreadWork, canFillAllocatorCallAllocationExceptionReleaseAndAllocateA
 
 	delete ba;
 }
+
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(AsyncAllocation)
+{
+	size_t numOfBlocks = 2;
+	size_t blockSize = 16;
+
+	BlockAllocator* ba;
+	std::vector<void*> served;
+
+    void setup()
+    {
+    	ba = new BlockAllocator(blockSize, numOfBlocks);
+    	served.clear();
+    }
+    void teardown()
+    {
+    	delete ba;
+	}
+
+    BlockAllocator::AllocationCallback recordTo(std::vector<void*>& blocks)
+    {
+    	return [&blocks](void* block)
+    	{
+    		blocks.push_back(block);
+    	};
+    }
+};
+
+TEST(AsyncAllocation, callbackIsInvokedAtOnceIfBlockIsFree)
+{
+	ba->allocateAsync(recordTo(served));
+
+	LONGS_EQUAL(1, served.size());
+	CHECK_TRUE(ba->isBlockAddress(served.front()));
+	LONGS_EQUAL(0, ba->getWaitersCount());
+}
+
+TEST(AsyncAllocation, exhaustedAllocatorQueuesRequestInsteadOfThrowing)
+{
+	FillAllocator(*ba, numOfBlocks);
+
+	ba->allocateAsync(recordTo(served));
+
+	CHECK_TRUE(served.empty());
+	LONGS_EQUAL(1, ba->getWaitersCount());
+}
+
+TEST(AsyncAllocation, deallocatedBlockIsHandedToWaiter)
+{
+	void* first = ba->allocate();
+	ba->allocate();
+	ba->allocateAsync(recordTo(served));
+
+	ba->deallocate(first);
+
+	LONGS_EQUAL(1, served.size());
+	LONGS_EQUAL(first, served.front());
+	LONGS_EQUAL(0, ba->getWaitersCount());
+}
+
+TEST(AsyncAllocation, handedBlockBypassesFreeList)
+{
+	void* first = ba->allocate();
+	ba->allocate();
+	ba->allocateAsync(recordTo(served));
+
+	ba->deallocate(first);
+
+	CHECK_THROWS(OutOfAllocatableMemoryException, ba->allocate());
+}
+
+TEST(AsyncAllocation, waitersAreServedInFifoOrder)
+{
+	std::vector<void*> secondServed;
+
+	void* first = ba->allocate();
+	void* second = ba->allocate();
+	ba->allocateAsync(recordTo(served));
+	ba->allocateAsync(recordTo(secondServed));
+
+	ba->deallocate(second);
+	ba->deallocate(first);
+
+	LONGS_EQUAL(second, served.front());
+	LONGS_EQUAL(first, secondServed.front());
+}
+
+TEST(AsyncAllocation, handedBlockCanBeDeallocatedAgain)
+{
+	void* first = ba->allocate();
+	ba->allocate();
+	ba->allocateAsync(recordTo(served));
+	ba->deallocate(first);
+
+	ba->deallocate(served.front());
+
+	LONGS_EQUAL(first, ba->allocate());
+}
+
+#if defined(__cpp_impl_coroutine)
+struct DetachedTask
+{
+	struct promise_type
+	{
+		DetachedTask get_return_object() { return DetachedTask(); }
+		std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+		std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+		void return_void() {}
+		void unhandled_exception() {}
+	};
+};
+
+static DetachedTask awaitBlock(BlockAllocator& ba, void** block)
+{
+	*block = co_await ba.allocateAsync();
+}
+
+TEST(AsyncAllocation, coroutineIsResumedWithDeallocatedBlock)
+{
+	void* awaited = NULL;
+	void* first = ba->allocate();
+	ba->allocate();
+
+	awaitBlock(*ba, &awaited);
+	CHECK_TRUE(awaited == NULL);
+
+	ba->deallocate(first);
+
+	LONGS_EQUAL(first, awaited);
+}
+
+TEST(AsyncAllocation, coroutineIsNotSuspendedIfBlockIsFree)
+{
+	void* awaited = NULL;
+
+	awaitBlock(*ba, &awaited);
+
+	CHECK_TRUE(ba->isBlockAddress(awaited));
+}
+
+TEST(AsyncAllocation, coroutineRacingDeallocationGetsTheBlock)
+{
+	void* held = ba->allocate();
+	ba->allocate();
+
+	for (size_t i = 0; i < 1000; i++)
+	{
+		void* awaited = NULL;
+		std::thread deallocating([this, held]()
+		{
+			ba->deallocate(held);
+		});
+
+		awaitBlock(*ba, &awaited);
+		deallocating.join();
+
+		LONGS_EQUAL(held, awaited);
+	}
+}
+#endif
+
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(Trimming)
+{
+	size_t numOfBlocks = 4;
+	size_t pageSize = 0;
+
+    void setup()
+    {
+    	pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    }
+    void teardown()
+    {
+	}
+};
+
+TEST(Trimming, smallBlocksHaveNothingToTrim)
+{
+	BlockAllocator ba {64, numOfBlocks};
+
+	LONGS_EQUAL(0, ba.trim());
+}
+
+TEST(Trimming, freePagesOfLargeBlocksAreReleased)
+{
+	BlockAllocator ba {3 * pageSize, numOfBlocks};
+
+	CHECK_TRUE(ba.trim() >= 2 * pageSize * numOfBlocks);
+}
+
+TEST(Trimming, allocatedBlocksAreNotTrimmed)
+{
+	BlockAllocator ba {3 * pageSize, numOfBlocks};
+	FillAllocator(ba, numOfBlocks);
+
+	LONGS_EQUAL(0, ba.trim());
+}
+
+TEST(Trimming, allocatedBlockContentSurvivesTrim)
+{
+	BlockAllocator ba {3 * pageSize, numOfBlocks};
+	char* block = (char*)ba.allocate();
+	memset(block, 0x5a, 3 * pageSize);
+
+	ba.trim();
+
+	LONGS_EQUAL(0x5a, block[pageSize + 1]);
+	LONGS_EQUAL(0x5a, block[3 * pageSize - 1]);
+}
+
+TEST(Trimming, trimmedBlocksCanBeAllocated)
+{
+	BlockAllocator ba {3 * pageSize, numOfBlocks};
+	ba.trim();
+
+	for (size_t i = 0; i < numOfBlocks; i++)
+	{
+		char* block = (char*)ba.allocate();
+		block[pageSize + 1] = 1;
+	}
+
+	CHECK_THROWS(OutOfAllocatableMemoryException, ba.allocate());
+}
+
+TEST(Trimming, externalPoolIsNotTrimmed)
+{
+	std::vector<char> pool((3 * pageSize + BlockAllocator::getHeaderSize()) * numOfBlocks);
+	BlockAllocator ba {3 * pageSize, numOfBlocks, pool.data()};
+
+	LONGS_EQUAL(0, ba.trim());
+}
+
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(MemoryOverhead)
+{
+	size_t numOfBlocks = 16;
+	size_t blockSize = 24;
+
+    void setup()
+    {
+    }
+    void teardown()
+    {
+	}
+};
+
+TEST(MemoryOverhead, payloadIsBlockSizeTimesBlocks)
+{
+	BlockAllocator ba {blockSize, numOfBlocks};
+
+	LONGS_EQUAL(blockSize * numOfBlocks, ba.getMemoryOverhead().payloadBytes);
+}
+
+TEST(MemoryOverhead, everyBlockCarriesHeader)
+{
+	BlockAllocator ba {blockSize, numOfBlocks};
+
+	LONGS_EQUAL(BlockAllocator::getHeaderSize() * numOfBlocks, ba.getMemoryOverhead().headerBytes);
+}
+
+TEST(MemoryOverhead, totalCoversPoolAndAllocatorObject)
+{
+	BlockAllocator ba {blockSize, numOfBlocks};
+	BlockAllocator::MemoryOverhead overhead = ba.getMemoryOverhead();
+
+	CHECK_TRUE(overhead.totalBytes() >= (blockSize + BlockAllocator::getHeaderSize()) * numOfBlocks + sizeof(BlockAllocator));
+}
+
+TEST(MemoryOverhead, externalPoolHasNoSystemSlack)
+{
+	std::vector<char> pool((blockSize + BlockAllocator::getHeaderSize()) * numOfBlocks);
+	BlockAllocator ba {blockSize, numOfBlocks, pool.data()};
+
+	LONGS_EQUAL(0, ba.getMemoryOverhead().systemSlackBytes);
+}
+
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(CompactLayout)
+{
+	size_t numOfBlocks = 4;
+	size_t blockSize = 8;
+
+	BlockAllocator::Config config;
+
+    void setup()
+    {
+    	config.layout = BlockAllocator::CompactLayout;
+    }
+    void teardown()
+    {
+	}
+};
+
+TEST(CompactLayout, canGetLayout)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+
+	LONGS_EQUAL(BlockAllocator::CompactLayout, ba.getLayout());
+}
+
+TEST(CompactLayout, defaultLayoutHasHeaders)
+{
+	BlockAllocator ba {blockSize, numOfBlocks};
+
+	LONGS_EQUAL(BlockAllocator::HeaderLayout, ba.getLayout());
+}
+
+TEST(CompactLayout, blocksHaveNoHeader)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+
+	char* first = (char*)ba.allocate();
+	char* second = (char*)ba.allocate();
+
+	LONGS_EQUAL(blockSize, second - first);
+}
+
+TEST(CompactLayout, blocksSmallerThanPointerArePossible)
+{
+	BlockAllocator ba {sizeof(uint32_t), numOfBlocks, config};
+
+	char* first = (char*)ba.allocate();
+	char* second = (char*)ba.allocate();
+
+	LONGS_EQUAL(sizeof(uint32_t), second - first);
+}
+
+TEST(CompactLayout, tinyBlocksAreWidenedToIndexSize)
+{
+	BlockAllocator ba {1, numOfBlocks, config};
+
+	char* first = (char*)ba.allocate();
+	char* second = (char*)ba.allocate();
+
+	LONGS_EQUAL(sizeof(uint32_t), second - first);
+}
+
+TEST(CompactLayout, wholeBlockIsUsableWhileAllocated)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	char* first = (char*)ba.allocate();
+	char* second = (char*)ba.allocate();
+
+	memset(first, 0x7f, blockSize);
+	ba.allocate();
+
+	LONGS_EQUAL(0x7f, first[0]);
+	CHECK_TRUE(ba.isBlockAddress(second));
+}
+
+TEST(CompactLayout, fillAndExhaust)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+
+	FillAllocator(ba, numOfBlocks);
+
+	CHECK_THROWS(OutOfAllocatableMemoryException, ba.allocate());
+}
+
+TEST(CompactLayout, deallocatedBlockIsReusedFirst)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	void* first = ba.allocate();
+	ba.allocate();
+
+	ba.deallocate(first);
+
+	LONGS_EQUAL(first, ba.allocate());
+}
+
+TEST(CompactLayout, doubleDeallocationThrows)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	void* first = ba.allocate();
+
+	ba.deallocate(first);
+
+	CHECK_THROWS(InvalidBlockAddressException, ba.deallocate(first));
+}
+
+TEST(CompactLayout, unalignedAddressThrows)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	char* first = (char*)ba.allocate();
+
+	CHECK_THROWS(InvalidBlockAddressException, ba.deallocate(first + 1));
+}
+
+TEST(CompactLayout, overheadIsOnlyTheBitmap)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	BlockAllocator::MemoryOverhead overhead = ba.getMemoryOverhead();
+
+	LONGS_EQUAL(0, overhead.headerBytes);
+	LONGS_EQUAL(0, overhead.paddingBytes);
+	LONGS_EQUAL(sizeof(uint64_t), overhead.sideTableBytes);
+}
+
+TEST(CompactLayout, externalPoolNeedsNoHeaderSpace)
+{
+	std::vector<char> pool(blockSize * numOfBlocks);
+	BlockAllocator ba {blockSize, numOfBlocks, config, pool.data()};
+
+	FillAllocator(ba, numOfBlocks);
+
+	CHECK_THROWS(OutOfAllocatableMemoryException, ba.allocate());
+}
+
+TEST(CompactLayout, asyncRequestIsServedOnDeallocation)
+{
+	BlockAllocator ba {blockSize, 1, config};
+	void* first = ba.allocate();
+	void* served = NULL;
+
+	ba.allocateAsync([&served](void* block) { served = block; });
+	ba.deallocate(first);
+
+	LONGS_EQUAL(first, served);
+}
+
+TEST(CompactLayout, trimKeepsFreeList)
+{
+	size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	BlockAllocator ba {3 * pageSize, numOfBlocks, config};
+
+	CHECK_TRUE(ba.trim() > 0);
+	FillAllocator(ba, numOfBlocks);
+
+	CHECK_THROWS(OutOfAllocatableMemoryException, ba.allocate());
+}
+
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(PageLayout)
+{
+	size_t numOfBlocks = 4;
+	size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+
+	BlockAllocator::Config config;
+
+    void setup()
+    {
+    	config.layout = BlockAllocator::PageLayout;
+    }
+    void teardown()
+    {
+	}
+};
+
+TEST(PageLayout, blocksArePageAligned)
+{
+	BlockAllocator ba {pageSize + 1, numOfBlocks, config};
+	char* first = (char*)ba.allocate();
+	char* second = (char*)ba.allocate();
+
+	LONGS_EQUAL(BlockAllocator::PageLayout, ba.getLayout());
+	LONGS_EQUAL(0, (uintptr_t)first % pageSize);
+	LONGS_EQUAL(2 * pageSize, second - first);
+	memset(first, 0xab, pageSize + 1);
+}
+
+TEST(PageLayout, invalidSettingsThrow)
+{
+	std::vector<char> pool(pageSize * (numOfBlocks + 1));
+	char* aligned = (char*)(((uintptr_t)pool.data() + pageSize - 1) & ~(uintptr_t)(pageSize - 1));
+
+	CHECK_THROWS(InvalidConstructorParametersException, BlockAllocator(pageSize - 1, numOfBlocks, config));
+	CHECK_THROWS(InvalidConstructorParametersException, BlockAllocator(pageSize, numOfBlocks, config, aligned + 1));
+
+	config.freeList = BlockAllocator::RingFreeList;
+	CHECK_THROWS(InvalidConstructorParametersException, BlockAllocator(pageSize, numOfBlocks, config));
+}
+
+TEST(PageLayout, releasedBlocksAreReusedAfterRetainedOnes)
+{
+	config.retainedFreeBlocks = 1;
+	config.lazyFreeList = true;
+	BlockAllocator ba {pageSize, numOfBlocks, config};
+	void* first = ba.allocate();
+	void* second = ba.allocate();
+	void* third = ba.allocate();
+
+	ba.deallocate(first);
+	ba.deallocate(second);
+	ba.deallocate(third);
+
+	POINTERS_EQUAL(first, ba.allocate());
+	POINTERS_EQUAL(second, ba.allocate());
+	POINTERS_EQUAL(third, ba.allocate());
+}
+
+TEST(PageLayout, releasedBlockIsUsableAgain)
+{
+	BlockAllocator ba {pageSize, 1, config};
+	char* block = (char*)ba.allocate();
+
+	memset(block, 0xab, pageSize);
+	ba.deallocate(block);
+
+	POINTERS_EQUAL(block, ba.allocate());
+	memset(block, 0xcd, pageSize);
+	LONGS_EQUAL(0xcd, (unsigned char)block[pageSize - 1]);
+}
+
+TEST(PageLayout, doubleDeallocationThrows)
+{
+	BlockAllocator ba {pageSize, numOfBlocks, config};
+	void* block = ba.allocate();
+
+	ba.deallocate(block);
+
+	CHECK_THROWS(InvalidBlockAddressException, ba.deallocate(block));
+}
+
+TEST(PageLayout, externalPoolWorks)
+{
+	std::vector<char> pool(pageSize * (numOfBlocks + 1));
+	char* aligned = (char*)(((uintptr_t)pool.data() + pageSize - 1) & ~(uintptr_t)(pageSize - 1));
+	BlockAllocator ba {pageSize, numOfBlocks, config, aligned};
+
+	FillAllocator(ba, numOfBlocks);
+	CHECK_THROWS(OutOfAllocatableMemoryException, ba.allocate());
+
+	ba.deallocateAll();
+	FillAllocator(ba, numOfBlocks);
+}
+
+TEST(PageLayout, overheadCountsTheSideArrays)
+{
+	BlockAllocator ba {pageSize + 1, numOfBlocks, config};
+	BlockAllocator::MemoryOverhead overhead = ba.getMemoryOverhead();
+
+	LONGS_EQUAL(0, overhead.headerBytes);
+	LONGS_EQUAL((pageSize - 1) * numOfBlocks, overhead.paddingBytes);
+	LONGS_EQUAL(sizeof(uint64_t) + numOfBlocks * sizeof(uint32_t), overhead.sideTableBytes);
+	LONGS_EQUAL(0, overhead.systemSlackBytes);
+}
+
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(ForkSafe)
+{
+	size_t numOfBlocks = 4;
+	size_t blockSize = 16;
+
+	BlockAllocator::Config config;
+
+    void setup()
+    {
+    	config.layout = BlockAllocator::CompactLayout;
+    	config.forkSafe = true;
+    }
+    void teardown()
+    {
+	}
+};
+
+TEST(ForkSafe, freeBlocksAreNotWritten)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	char* first = (char*)ba.allocate();
+	char* second = (char*)ba.allocate();
+
+	memset(first, 0xab, blockSize);
+	memset(second, 0xab, blockSize);
+	ba.deallocate(first);
+	ba.deallocate(second);
+	ba.trim();
+
+	for (size_t i = 0; i < blockSize; i++)
+	{
+		LONGS_EQUAL(0xab, (unsigned char)first[i]);
+		LONGS_EQUAL(0xab, (unsigned char)second[i]);
+	}
+	POINTERS_EQUAL(second, ba.allocate());
+	POINTERS_EQUAL(first, ba.allocate());
+}
+
+TEST(ForkSafe, headerLayoutThrows)
+{
+	config.layout = BlockAllocator::HeaderLayout;
+
+	CHECK_THROWS(InvalidConstructorParametersException, BlockAllocator(blockSize, numOfBlocks, config));
+}
+
+TEST(ForkSafe, childAllocatesWhileParentThreadsRun)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	std::atomic<bool> isDone(false);
+
+	// The worker keeps the allocator lock busy, a child forked while it's held would deadlock without the fork handlers.
+	std::thread worker([&ba, &isDone]()
+	{
+		while (!isDone.load())
+		{
+			ba.deallocate(ba.allocate());
+		}
+	});
+
+	for (int i = 0; i < 20; i++)
+	{
+		pid_t child = fork();
+		if (child == 0)
+		{
+			void* block = ba.allocate();
+			ba.deallocate(block);
+			_exit(0);
+		}
+
+		int status = -1;
+		waitpid(child, &status, 0);
+		CHECK_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	}
+
+	isDone.store(true);
+	worker.join();
+}
+
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(RingFreeList)
+{
+	size_t numOfBlocks = 4;
+	size_t blockSize = 16;
+
+	BlockAllocator::Config config;
+
+    void setup()
+    {
+    	config.freeList = BlockAllocator::RingFreeList;
+    }
+    void teardown()
+    {
+	}
+};
+
+static void allocateAndReleaseManyTimes(BlockAllocator* ba, int iterations, std::atomic<int>* failures)
+{
+	for (int i = 0; i < iterations; i++)
+	{
+		try
+		{
+			char* block = (char*)ba->allocate();
+			*block = (char)i;
+			ba->deallocate(block);
+		}
+		catch (const OutOfAllocatableMemoryException& e)
+		{
+			// The pool is smaller than the number of threads.
+		}
+		catch (const InvalidBlockAddressException& e)
+		{
+			++*failures;
+		}
+	}
+}
+
+TEST(RingFreeList, canGetFreeListType)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+
+	LONGS_EQUAL(BlockAllocator::RingFreeList, ba.getFreeListType());
+}
+
+TEST(RingFreeList, blocksAreHandedOutInAddressOrder)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+
+	char* first = (char*)ba.allocate();
+	char* second = (char*)ba.allocate();
+
+	LONGS_EQUAL(blockSize + ba.getHeaderSize(), second - first);
+}
+
+TEST(RingFreeList, deallocatedBlocksAreReusedInFifoOrder)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	void* first = ba.allocate();
+	void* second = ba.allocate();
+	ba.allocate();
+	ba.allocate();
+
+	ba.deallocate(second);
+	ba.deallocate(first);
+
+	LONGS_EQUAL(second, ba.allocate());
+	LONGS_EQUAL(first, ba.allocate());
+}
+
+TEST(RingFreeList, fillAndExhaust)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+
+	FillAllocator(ba, numOfBlocks);
+
+	CHECK_THROWS(OutOfAllocatableMemoryException, ba.allocate());
+}
+
+TEST(RingFreeList, doubleDeallocationThrows)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	void* first = ba.allocate();
+
+	ba.deallocate(first);
+
+	CHECK_THROWS(InvalidBlockAddressException, ba.deallocate(first));
+}
+
+TEST(RingFreeList, invalidAddressThrows)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	char* first = (char*)ba.allocate();
+
+	CHECK_THROWS(InvalidBlockAddressException, ba.deallocate(first + 1));
+}
+
+TEST(RingFreeList, worksWithCompactLayout)
+{
+	config.layout = BlockAllocator::CompactLayout;
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+
+	char* first = (char*)ba.allocate();
+	char* second = (char*)ba.allocate();
+	ba.deallocate(first);
+
+	LONGS_EQUAL(blockSize, second - first);
+	CHECK_THROWS(InvalidBlockAddressException, ba.deallocate(first));
+}
+
+TEST(RingFreeList, asyncRequestIsServedOnDeallocation)
+{
+	BlockAllocator ba {blockSize, 1, config};
+	void* first = ba.allocate();
+	void* served = NULL;
+
+	ba.allocateAsync([&served](void* block) { served = block; });
+	LONGS_EQUAL(1, ba.getWaitersCount());
+
+	ba.deallocate(first);
+
+	LONGS_EQUAL(first, served);
+	LONGS_EQUAL(0, ba.getWaitersCount());
+}
+
+TEST(RingFreeList, trimDoesNothing)
+{
+	BlockAllocator ba {3 * (size_t)sysconf(_SC_PAGESIZE), numOfBlocks, config};
+
+	LONGS_EQUAL(0, ba.trim());
+}
+
+TEST(RingFreeList, concurrentUseNeverHandsOutBlockTwice)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	std::atomic<int> failures(0);
+
+	std::thread th1(allocateAndReleaseManyTimes, &ba, 20000, &failures);
+	std::thread th2(allocateAndReleaseManyTimes, &ba, 20000, &failures);
+	std::thread th3(allocateAndReleaseManyTimes, &ba, 20000, &failures);
+	std::thread th4(allocateAndReleaseManyTimes, &ba, 20000, &failures);
+	std::thread th5(allocateAndReleaseManyTimes, &ba, 20000, &failures);
+	th1.join();
+	th2.join();
+	th3.join();
+	th4.join();
+	th5.join();
+
+	LONGS_EQUAL(0, failures.load());
+	FillAllocator(ba, numOfBlocks);
+	CHECK_THROWS(OutOfAllocatableMemoryException, ba.allocate());
+}
+
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(BiasedFreeList)
+{
+	size_t numOfBlocks = 4;
+	size_t blockSize = 16;
+
+	BlockAllocator::Config config;
+	BlockAllocator* ba;
+
+    void setup()
+    {
+    	config.freeList = BlockAllocator::BiasedFreeList;
+    	ba = new BlockAllocator(blockSize, numOfBlocks, config);
+    }
+    void teardown()
+    {
+    	delete ba;
+	}
+};
+
+static void deallocateFromThread(BlockAllocator* ba, void* block, bool* thrown)
+{
+	try
+	{
+		ba->deallocate(block);
+	}
+	catch (const InvalidBlockAddressException& e)
+	{
+		*thrown = true;
+	}
+}
+
+static void allocateFromThread(BlockAllocator* ba, bool* thrown)
+{
+	try
+	{
+		ba->allocate();
+	}
+	catch (const NotOwnerThreadException& e)
+	{
+		*thrown = true;
+	}
+}
+
+static void deallocateAll(BlockAllocator* ba, std::vector<void*>* blocks)
+{
+	for (void* block : *blocks)
+	{
+		ba->deallocate(block);
+	}
+}
+
+TEST(BiasedFreeList, compactLayoutIsRejected)
+{
+	config.layout = BlockAllocator::CompactLayout;
+
+	CHECK_THROWS(InvalidConstructorParametersException, BlockAllocator(blockSize, numOfBlocks, config));
+}
+
+TEST(BiasedFreeList, ownerReusesBlocksInLifoOrder)
+{
+	void* first = ba->allocate();
+	ba->allocate();
+
+	ba->deallocate(first);
+
+	LONGS_EQUAL(first, ba->allocate());
+}
+
+TEST(BiasedFreeList, foreignAllocationThrows)
+{
+	bool thrown = false;
+
+	std::thread foreign(allocateFromThread, ba, &thrown);
+	foreign.join();
+
+	CHECK_TRUE(thrown);
+}
+
+TEST(BiasedFreeList, foreignDeallocationIsDrainedByOwner)
+{
+	bool thrown = false;
+	void* first = ba->allocate();
+	FillAllocator(*ba, numOfBlocks - 1);
+
+	std::thread foreign(deallocateFromThread, ba, first, &thrown);
+	foreign.join();
+
+	CHECK_FALSE(thrown);
+	LONGS_EQUAL(first, ba->allocate());
+}
+
+TEST(BiasedFreeList, foreignDoubleDeallocationThrows)
+{
+	bool thrown = false;
+	void* first = ba->allocate();
+	ba->deallocate(first);
+
+	std::thread foreign(deallocateFromThread, ba, first, &thrown);
+	foreign.join();
+
+	CHECK_TRUE(thrown);
+}
+
+TEST(BiasedFreeList, onlyOwnerCanTransferOwnership)
+{
+	ba->transferOwnership(std::thread::id());
+
+	CHECK_THROWS(NotOwnerThreadException, ba->transferOwnership(std::this_thread::get_id()));
+	CHECK_THROWS(NotOwnerThreadException, ba->allocate());
+}
+
+TEST(BiasedFreeList, releasedAllocatorCanBeClaimed)
+{
+	void* first = ba->allocate();
+	ba->transferOwnership(std::thread::id());
+	void* claimed = NULL;
+
+	std::thread worker([this, &claimed]()
+	{
+		ba->claimOwnership();
+		claimed = ba->allocate();
+		ba->transferOwnership(std::thread::id());
+	});
+	worker.join();
+
+	CHECK_TRUE(ba->claimOwnership());
+	CHECK_TRUE(ba->isBlockAddress(claimed));
+	CHECK_FALSE(claimed == first);
+}
+
+TEST(BiasedFreeList, claimingOwnedAllocatorFails)
+{
+	bool claimed = true;
+
+	std::thread other([this, &claimed]()
+	{
+		claimed = ba->claimOwnership();
+	});
+	other.join();
+
+	CHECK_FALSE(claimed);
+}
+
+TEST(BiasedFreeList, foreignDeallocationServesOwnerAsyncRequest)
+{
+	bool thrown = false;
+	void* served = NULL;
+	void* first = ba->allocate();
+	FillAllocator(*ba, numOfBlocks - 1);
+	ba->allocateAsync([&served](void* block) { served = block; });
+
+	std::thread foreign(deallocateFromThread, ba, first, &thrown);
+	foreign.join();
+
+	LONGS_EQUAL(first, served);
+	LONGS_EQUAL(0, ba->getWaitersCount());
+}
+
+TEST(BiasedFreeList, concurrentForeignDeallocationsAreAllDrained)
+{
+	std::vector<void*> blocks[2];
+	for (size_t i = 0; i < numOfBlocks; i++)
+	{
+		blocks[i % 2].push_back(ba->allocate());
+	}
+
+	std::thread th1(deallocateAll, ba, &blocks[0]);
+	std::thread th2(deallocateAll, ba, &blocks[1]);
+	th1.join();
+	th2.join();
+
+	std::vector<void*> reallocated;
+	for (size_t i = 0; i < numOfBlocks; i++)
+	{
+		reallocated.push_back(ba->allocate());
+	}
+	std::sort(reallocated.begin(), reallocated.end());
+
+	CHECK_TRUE(std::adjacent_find(reallocated.begin(), reallocated.end()) == reallocated.end());
+	CHECK_THROWS(OutOfAllocatableMemoryException, ba->allocate());
+}
+
+TEST(BiasedFreeList, concurrentForeignDoubleDeallocationIsRejectedOnce)
+{
+	FillAllocator(*ba, numOfBlocks - 1);
+
+	for (size_t i = 0; i < 1000; i++)
+	{
+		bool thrown[2] = {false, false};
+		void* block = ba->allocate();
+
+		std::thread th1(deallocateFromThread, ba, block, &thrown[0]);
+		std::thread th2(deallocateFromThread, ba, block, &thrown[1]);
+		th1.join();
+		th2.join();
+
+		CHECK_TRUE(thrown[0] != thrown[1]);
+		LONGS_EQUAL(block, ba->allocate());
+		CHECK_THROWS(OutOfAllocatableMemoryException, ba->allocate());
+		ba->deallocate(block);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(BlockIndex)
+{
+	size_t numOfBlocks = 4;
+	size_t blockSize = 16;
+};
+
+TEST(BlockIndex, indexAndAddressRoundTrip)
+{
+	BlockAllocator::Config config;
+	config.layout = BlockAllocator::CompactLayout;
+	BlockAllocator headers(blockSize, numOfBlocks);
+	BlockAllocator compact(blockSize, numOfBlocks, config);
+
+	for (size_t i = 0; i < numOfBlocks; i++)
+	{
+		void* block = headers.allocate();
+		POINTERS_EQUAL(block, headers.getBlockAddress(headers.getBlockIndex(block)));
+
+		block = compact.allocate();
+		POINTERS_EQUAL(block, compact.getBlockAddress(compact.getBlockIndex(block)));
+	}
+	LONGS_EQUAL(numOfBlocks, headers.getNumOfBlocks());
+}
+
+TEST(BlockIndex, invalidIndexOrAddressThrows)
+{
+	BlockAllocator ba {blockSize, numOfBlocks};
+	char* block = (char*)ba.allocate();
+
+	CHECK_THROWS(InvalidBlockAddressException, ba.getBlockAddress(numOfBlocks));
+	CHECK_THROWS(InvalidBlockAddressException, ba.getBlockIndex(block + 1));
+}
+
+TEST(BlockIndex, deallocateAllFreesEveryBlock)
+{
+	BlockAllocator::Config configs[3];
+	configs[1].layout = BlockAllocator::CompactLayout;
+	configs[2].freeList = BlockAllocator::RingFreeList;
+
+	for (const BlockAllocator::Config& config : configs)
+	{
+		BlockAllocator ba {blockSize, numOfBlocks, config};
+		void* block = ba.allocate();
+		FillAllocator(ba, numOfBlocks - 1);
+
+		ba.deallocateAll();
+
+		CHECK_THROWS(InvalidBlockAddressException, ba.deallocate(block));
+		FillAllocator(ba, numOfBlocks);
+		CHECK_THROWS(OutOfAllocatableMemoryException, ba.allocate());
+	}
+}
+
+TEST(BlockIndex, deallocateAllServesQueuedRequests)
+{
+	BlockAllocator ba {blockSize, numOfBlocks};
+	void* served = NULL;
+	FillAllocator(ba, numOfBlocks);
+
+	ba.allocateAsync([&served](void* block)
+	{
+		served = block;
+	});
+	ba.deallocateAll();
+
+	CHECK_TRUE(served != NULL);
+	LONGS_EQUAL(0, ba.getWaitersCount());
+	FillAllocator(ba, numOfBlocks - 1);
+	CHECK_THROWS(OutOfAllocatableMemoryException, ba.allocate());
+}
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(BulkDeallocation)
+{
+	size_t numOfBlocks = 4;
+	size_t blockSize = 16;
+};
+
+TEST(BulkDeallocation, batchIsReturnedToFreeList)
+{
+	BlockAllocator ba {blockSize, numOfBlocks};
+	void* blocks[4];
+	for (void*& block : blocks)
+	{
+		block = ba.allocate();
+	}
+
+	ba.deallocate(blocks, 4);
+
+	POINTERS_EQUAL(blocks[3], ba.allocate());
+	FillAllocator(ba, numOfBlocks - 1);
+	CHECK_THROWS(OutOfAllocatableMemoryException, ba.allocate());
+}
+
+TEST(BulkDeallocation, invalidAddressStopsBatch)
+{
+	BlockAllocator ba {blockSize, numOfBlocks};
+	void* blocks[3] = {ba.allocate(), NULL, ba.allocate()};
+
+	CHECK_THROWS(InvalidBlockAddressException, ba.deallocate(blocks, 3));
+
+	CHECK_THROWS(InvalidBlockAddressException, ba.deallocate(blocks[0]));
+	ba.deallocate(blocks[2]);
+}
+
+TEST(BulkDeallocation, batchServesQueuedRequests)
+{
+	BlockAllocator ba {blockSize, numOfBlocks};
+	void* blocks[2] = {ba.allocate(), ba.allocate()};
+	void* served = NULL;
+	FillAllocator(ba, numOfBlocks - 2);
+
+	ba.allocateAsync([&served](void* block)
+	{
+		served = block;
+	});
+	ba.deallocate(blocks, 2);
+
+	POINTERS_EQUAL(blocks[0], served);
+	POINTERS_EQUAL(blocks[1], ba.allocate());
+}
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(LazyFreeList)
+{
+	size_t numOfBlocks = 4;
+	size_t blockSize = 16;
+	BlockAllocator::Config config;
+
+	void setup()
+	{
+		config.lazyFreeList = true;
+	}
+};
+
+TEST(LazyFreeList, untouchedBlocksComeInAddressOrder)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+
+	char* first = (char*)ba.allocate();
+	char* second = (char*)ba.allocate();
+
+	POINTERS_EQUAL(first + blockSize + BlockAllocator::getHeaderSize(), second);
+}
+
+TEST(LazyFreeList, freedBlocksAreReusedFirst)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	void* first = ba.allocate();
+	ba.allocate();
+
+	ba.deallocate(first);
+
+	POINTERS_EQUAL(first, ba.allocate());
+	FillAllocator(ba, numOfBlocks - 2);
+	CHECK_THROWS(OutOfAllocatableMemoryException, ba.allocate());
+}
+
+TEST(LazyFreeList, neverAllocatedBlockIsRejected)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	char* first = (char*)ba.allocate();
+
+	CHECK_THROWS(InvalidBlockAddressException, ba.deallocate(first + blockSize + BlockAllocator::getHeaderSize()));
+}
+
+TEST(LazyFreeList, compactLayoutIsLazyToo)
+{
+	config.layout = BlockAllocator::CompactLayout;
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	void* blocks[4];
+	for (void*& block : blocks)
+	{
+		block = ba.allocate();
+	}
+
+	CHECK_THROWS(OutOfAllocatableMemoryException, ba.allocate());
+	LONGS_EQUAL(3, ba.getBlockIndex(blocks[3]));
+	ba.deallocate(blocks, 4);
+	FillAllocator(ba, numOfBlocks);
+}
+
+TEST(LazyFreeList, deallocateAllRestartsFromFirstBlock)
+{
+	BlockAllocator ba {blockSize, numOfBlocks};
+	void* first = ba.allocate();
+	ba.allocate();
+	ba.deallocate(first);
+
+	ba.deallocateAll();
+
+	POINTERS_EQUAL(first, ba.allocate());
+	FillAllocator(ba, numOfBlocks - 1);
+	CHECK_THROWS(OutOfAllocatableMemoryException, ba.allocate());
+}
+
+TEST(LazyFreeList, untouchedTailIsTrimmed)
+{
+	size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	BlockAllocator ba {pageSize, 4, config};
+
+	memset(ba.allocate(), 1, pageSize);
+
+	CHECK_TRUE(ba.trim() >= 2 * pageSize);
+}
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(SelfHostedPool)
+{
+	static const size_t numOfBlocks = 4;
+	static const size_t blockSize = 24;
+
+	alignas(std::max_align_t) char buffer[BlockAllocator::getRequiredPoolSize(blockSize, numOfBlocks)];
+};
+
+TEST(SelfHostedPool, allocatorAndBlocksLiveInBuffer)
+{
+	BlockAllocator* ba = BlockAllocator::createInPool(blockSize, numOfBlocks, buffer, sizeof(buffer));
+
+	POINTERS_EQUAL(buffer, ba);
+	for (size_t i = 0; i < numOfBlocks; i++)
+	{
+		char* block = (char*)ba->allocate();
+		CHECK_TRUE(block > (char*)ba + sizeof(BlockAllocator) && block + blockSize <= buffer + sizeof(buffer));
+	}
+	LONGS_EQUAL(BlockAllocator::External, ba->getPoolType());
+
+	BlockAllocator::destroyInPool(ba);
+}
+
+TEST(SelfHostedPool, requiredSizeIsExact)
+{
+	CHECK_THROWS(InvalidConstructorParametersException, BlockAllocator::createInPool(blockSize, numOfBlocks, buffer, sizeof(buffer) - 1));
+}
+
+TEST(SelfHostedPool, unalignedBufferNeedsPadding)
+{
+	alignas(std::max_align_t) char larger[BlockAllocator::getRequiredPoolSize(blockSize, numOfBlocks, 1) + 1];
+	char* unaligned = larger + 1;
+
+	BlockAllocator* ba = BlockAllocator::createInPool(blockSize, numOfBlocks, unaligned, BlockAllocator::getRequiredPoolSize(blockSize, numOfBlocks, 1));
+
+	LONGS_EQUAL(0, (uintptr_t)ba % alignof(std::max_align_t));
+	FillAllocator(*ba, numOfBlocks);
+	BlockAllocator::destroyInPool(ba);
+}
+
+TEST(SelfHostedPool, layoutsWithSideTablesAreRejected)
+{
+	BlockAllocator::Config config;
+	config.layout = BlockAllocator::CompactLayout;
+
+	CHECK_THROWS(InvalidConstructorParametersException, BlockAllocator::createInPool(blockSize, numOfBlocks, buffer, sizeof(buffer), config));
+	config.layout = BlockAllocator::HeaderLayout;
+	config.freeList = BlockAllocator::RingFreeList;
+	CHECK_THROWS(InvalidConstructorParametersException, BlockAllocator::createInPool(blockSize, numOfBlocks, buffer, sizeof(buffer), config));
+}
+
+TEST(SelfHostedPool, tryAllocateReturnsNullWhenExhausted)
+{
+	BlockAllocator* ba = BlockAllocator::createInPool(blockSize, numOfBlocks, buffer, sizeof(buffer));
+	void* first = ba->tryAllocate();
+	FillAllocator(*ba, numOfBlocks - 1);
+
+	POINTERS_EQUAL(NULL, ba->tryAllocate());
+	ba->deallocate(first);
+	POINTERS_EQUAL(first, ba->tryAllocate());
+
+	BlockAllocator::destroyInPool(ba);
+}
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(TagAccounting)
+{
+	size_t numOfBlocks = 8;
+	size_t blockSize = 16;
+	BlockAllocator::Config config;
+
+	const BlockAllocator::Tag sessionTag = 1;
+	const BlockAllocator::Tag bufferTag = 2;
+
+	void setup()
+	{
+		config.tagging = true;
+	}
+
+	static BlockAllocator::TagUsage usageOf(BlockAllocator& ba, BlockAllocator::Tag tag)
+	{
+		for (const BlockAllocator::TagUsage& usage : ba.getTagUsage())
+		{
+			if (usage.tag == tag)
+				return usage;
+		}
+		FAIL("The tag isn't reported");
+		return BlockAllocator::TagUsage();
+	}
+};
+
+TEST(TagAccounting, blocksAreCountedPerTag)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	ba.registerTag(sessionTag, "session");
+	ba.registerTag(bufferTag, "buffer");
+
+	void* session = ba.allocate(sessionTag);
+	ba.allocate(bufferTag);
+	ba.allocate(bufferTag);
+	ba.allocate();
+
+	std::vector<BlockAllocator::TagUsage> usage = ba.getTagUsage();
+	LONGS_EQUAL(3, usage.size());
+	STRCMP_EQUAL("untagged", usage[0].name.c_str());
+	LONGS_EQUAL(1, usage[0].liveBlocks);
+	STRCMP_EQUAL("session", usage[1].name.c_str());
+	LONGS_EQUAL(1, usage[1].liveBlocks);
+	LONGS_EQUAL(2, usage[2].liveBlocks);
+
+	ba.deallocate(session);
+	LONGS_EQUAL(0, usageOf(ba, sessionTag).liveBlocks);
+	LONGS_EQUAL(1, usageOf(ba, sessionTag).peakBlocks);
+}
+
+TEST(TagAccounting, peakIsKept)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	ba.registerTag(sessionTag, "session");
+	void* blocks[3];
+
+	for (void*& block : blocks)
+	{
+		block = ba.allocate(sessionTag);
+	}
+	ba.deallocate(blocks, 3);
+	ba.allocate(sessionTag);
+
+	LONGS_EQUAL(1, usageOf(ba, sessionTag).liveBlocks);
+	LONGS_EQUAL(3, usageOf(ba, sessionTag).peakBlocks);
+}
+
+TEST(TagAccounting, invalidTagsAreRejected)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	BlockAllocator untagged {blockSize, numOfBlocks};
+
+	CHECK_THROWS(InvalidTagException, ba.allocate(sessionTag));
+	CHECK_THROWS(InvalidTagException, ba.registerTag(BlockAllocator::maxTags, "out of range"));
+	CHECK_THROWS(InvalidTagException, untagged.registerTag(sessionTag, "session"));
+	CHECK_TRUE(untagged.allocate(sessionTag) != NULL);
+	CHECK_TRUE(untagged.getTagUsage().empty());
+}
+
+TEST(TagAccounting, blocksFreedByOtherThreadsAreCounted)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	ba.registerTag(sessionTag, "session");
+	void* blocks[4];
+
+	std::thread producer([&ba, &blocks, this]()
+	{
+		for (void*& block : blocks)
+		{
+			block = ba.allocate(sessionTag);
+		}
+	});
+	producer.join();
+	LONGS_EQUAL(4, usageOf(ba, sessionTag).liveBlocks);
+
+	for (void* block : blocks)
+	{
+		ba.deallocate(block);
+	}
+	LONGS_EQUAL(0, usageOf(ba, sessionTag).liveBlocks);
+	LONGS_EQUAL(4, usageOf(ba, sessionTag).peakBlocks);
+}
+
+TEST(TagAccounting, queuedRequestsAreCountedAsUntagged)
+{
+	BlockAllocator ba {blockSize, 1, config};
+	ba.registerTag(sessionTag, "session");
+	void* session = ba.allocate(sessionTag);
+	void* served = NULL;
+
+	ba.allocateAsync([&served](void* block)
+	{
+		served = block;
+	});
+	ba.deallocate(session);
+
+	POINTERS_EQUAL(session, served);
+	LONGS_EQUAL(0, usageOf(ba, sessionTag).liveBlocks);
+	LONGS_EQUAL(1, usageOf(ba, 0).liveBlocks);
+}
+
+TEST(TagAccounting, deallocateAllClearsLiveCounters)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	ba.registerTag(sessionTag, "session");
+	ba.allocate(sessionTag);
+	ba.allocate(sessionTag);
+
+	ba.deallocateAll();
+
+	LONGS_EQUAL(0, usageOf(ba, sessionTag).liveBlocks);
+	LONGS_EQUAL(2, usageOf(ba, sessionTag).peakBlocks);
+}
+
+TEST(TagAccounting, overheadCountsTheTagsAndTheShards)
+{
+	BlockAllocator tagged {blockSize, numOfBlocks, config};
+	BlockAllocator plain {blockSize, numOfBlocks};
+	size_t shardCounters = 16 * 2 * BlockAllocator::maxTags * sizeof(int64_t);
+
+	CHECK_TRUE(tagged.getMemoryOverhead().sideTableBytes >= plain.getMemoryOverhead().sideTableBytes + numOfBlocks + shardCounters);
+}
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(StateDump)
+{
+	size_t numOfBlocks = 8;
+	size_t blockSize = 16;
+};
+
+TEST(StateDump, geometryAndUsedRunsAreWritten)
+{
+	BlockAllocator ba {blockSize, numOfBlocks};
+	void* blocks[4];
+	for (void*& block : blocks)
+	{
+		block = ba.allocate();
+	}
+	ba.deallocate(blocks[2]);
+
+	std::ostringstream out;
+	ba.dumpState(out);
+	std::string json = out.str();
+
+	CHECK_TRUE(json.find("\"blockSize\": 16, \"maxBlocks\": 8, \"headerSize\": 8") != std::string::npos);
+	CHECK_TRUE(json.find("\"layout\": \"header\", \"freeList\": \"mutex\"") != std::string::npos);
+	CHECK_TRUE(json.find("\"usedRuns\": [[0, 2], [3, 1]]") != std::string::npos);
+	CHECK_TRUE(json.find("\"usedBlocks\": 3, \"freeBlocks\": 5") != std::string::npos);
+	CHECK_TRUE(json.find("\"tags\": []") != std::string::npos);
+}
+
+TEST(StateDump, everyEngineReportsOccupancy)
+{
+	BlockAllocator::Config config;
+	config.layout = BlockAllocator::CompactLayout;
+	BlockAllocator compact {blockSize, numOfBlocks, config};
+	config.layout = BlockAllocator::HeaderLayout;
+	config.freeList = BlockAllocator::RingFreeList;
+	BlockAllocator ring {blockSize, numOfBlocks, config};
+
+	compact.getBlockIndex(compact.allocate());
+	compact.allocate();
+	ring.allocate();
+
+	std::ostringstream compactOut;
+	std::ostringstream ringOut;
+	compact.dumpState(compactOut);
+	ring.dumpState(ringOut);
+
+	CHECK_TRUE(compactOut.str().find("\"usedRuns\": [[0, 2]]") != std::string::npos);
+	CHECK_TRUE(ringOut.str().find("\"usedRuns\": [[0, 1]]") != std::string::npos);
+}
+
+TEST(StateDump, tagNamesAreQuoted)
+{
+	BlockAllocator::Config config;
+	config.tagging = true;
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	ba.registerTag(1, "a \"quoted\" name");
+	ba.allocate(1);
+
+	std::ostringstream out;
+	ba.dumpState(out);
+
+	CHECK_TRUE(out.str().find("{\"tag\": 1, \"name\": \"a \\\"quoted\\\" name\", \"liveBlocks\": 1, \"peakBlocks\": 1}") != std::string::npos);
+}
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(RemoteFreeTelemetry)
+{
+	size_t numOfBlocks = 16;
+	size_t blockSize = 16;
+	BlockAllocator::Config config;
+
+	void setup()
+	{
+		config.remoteFreeSampling = 1;
+	}
+};
+
+TEST(RemoteFreeTelemetry, localFreesAreOnTheDiagonal)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	size_t self = BlockAllocator::getThreadSlot();
+
+	ba.deallocate(ba.allocate());
+	ba.deallocate(ba.allocate());
+
+	BlockAllocator::RemoteFreeStats stats = ba.getRemoteFreeStats();
+	LONGS_EQUAL(2, stats.sampledFrees);
+	LONGS_EQUAL(0, stats.remoteFrees);
+	LONGS_EQUAL(2, stats.transfers[self][self]);
+	DOUBLES_EQUAL(0, stats.remoteRatio(), 1e-9);
+}
+
+TEST(RemoteFreeTelemetry, blocksFreedByAnotherThreadAreRemote)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	size_t self = BlockAllocator::getThreadSlot();
+	size_t other = 0;
+	void* blocks[3];
+	for (void*& block : blocks)
+	{
+		block = ba.allocate();
+	}
+
+	std::thread consumer([&ba, &blocks, &other]()
+	{
+		other = BlockAllocator::getThreadSlot();
+		ba.deallocate(blocks[0]);
+		ba.deallocate(blocks[1]);
+	});
+	consumer.join();
+	ba.deallocate(blocks[2]);
+
+	BlockAllocator::RemoteFreeStats stats = ba.getRemoteFreeStats();
+	CHECK_TRUE(other != self);
+	LONGS_EQUAL(3, stats.sampledFrees);
+	LONGS_EQUAL(2, stats.remoteFrees);
+	LONGS_EQUAL(2, stats.transfers[self][other]);
+	DOUBLES_EQUAL(2.0 / 3, stats.remoteRatio(), 1e-9);
+}
+
+TEST(RemoteFreeTelemetry, onlySampledAllocationsAreCounted)
+{
+	config.remoteFreeSampling = 4;
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	void* blocks[8];
+	for (void*& block : blocks)
+	{
+		block = ba.allocate();
+	}
+
+	ba.deallocate(blocks, 8);
+
+	LONGS_EQUAL(2, ba.getRemoteFreeStats().sampledFrees);
+}
+
+TEST(RemoteFreeTelemetry, interleavedPoolsAreSampledIndependently)
+{
+	config.remoteFreeSampling = 2;
+	BlockAllocator first {blockSize, numOfBlocks, config};
+	BlockAllocator second {blockSize, numOfBlocks, config};
+
+	void* firstBlocks[4];
+	void* secondBlocks[4];
+
+	for (size_t i = 0; i < 4; i++)
+	{
+		firstBlocks[i] = first.allocate();
+		secondBlocks[i] = second.allocate();
+	}
+	first.deallocate(firstBlocks, 4);
+	second.deallocate(secondBlocks, 4);
+
+	LONGS_EQUAL(2, first.getRemoteFreeStats().sampledFrees);
+	LONGS_EQUAL(2, second.getRemoteFreeStats().sampledFrees);
+}
+
+TEST(RemoteFreeTelemetry, overheadCountsTheThreadsAndTheMatrix)
+{
+	BlockAllocator tracked {blockSize, numOfBlocks, config};
+	BlockAllocator plain {blockSize, numOfBlocks};
+	size_t matrix = BlockAllocator::maxTrackedThreads * BlockAllocator::maxTrackedThreads * sizeof(uint64_t);
+
+	CHECK_TRUE(tracked.getMemoryOverhead().sideTableBytes >= plain.getMemoryOverhead().sideTableBytes + numOfBlocks + matrix);
+}
+
+TEST(RemoteFreeTelemetry, disabledTrackingReportsNothing)
+{
+	BlockAllocator ba {blockSize, numOfBlocks};
+	ba.deallocate(ba.allocate());
+
+	BlockAllocator::RemoteFreeStats stats = ba.getRemoteFreeStats();
+	LONGS_EQUAL(0, stats.sampledFrees);
+	CHECK_TRUE(stats.transfers.empty());
+}
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(LifetimeTracking)
+{
+	size_t numOfBlocks = 8;
+	size_t blockSize = 16;
+	BlockAllocator::Config config;
+
+	void setup()
+	{
+		config.lifetimeTracking = true;
+	}
+};
+
+TEST(LifetimeTracking, oldestBlocksComeFirst)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	void* oldest = ba.allocate();
+	std::this_thread::sleep_for(std::chrono::milliseconds(30));
+	void* younger = ba.allocate();
+	ba.deallocate(ba.allocate());
+
+	std::vector<BlockAllocator::LiveBlock> blocks = ba.getOldestBlocks(5);
+
+	LONGS_EQUAL(2, blocks.size());
+	POINTERS_EQUAL(oldest, blocks[0].block);
+	LONGS_EQUAL(0, blocks[0].index);
+	CHECK_TRUE(blocks[0].ageMs >= 20);
+	POINTERS_EQUAL(younger, blocks[1].block);
+	CHECK_TRUE(blocks[1].ageMs < blocks[0].ageMs);
+	LONGS_EQUAL(1, ba.getOldestBlocks(1).size());
+}
+
+TEST(LifetimeTracking, lifetimesAreBucketedOnDeallocation)
+{
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	void* longLived = ba.allocate();
+	ba.deallocate(ba.allocate());
+	std::this_thread::sleep_for(std::chrono::milliseconds(40));
+	ba.deallocate(longLived);
+
+	std::vector<uint64_t> histogram = ba.getLifetimeHistogram();
+	uint64_t total = 0;
+	uint64_t atLeast16Ms = 0;
+	for (size_t i = 0; i < histogram.size(); i++)
+	{
+		total += histogram[i];
+		if (i >= 5)
+			atLeast16Ms += histogram[i];
+	}
+
+	LONGS_EQUAL(BlockAllocator::numOfLifetimeBuckets, histogram.size());
+	LONGS_EQUAL(2, total);
+	LONGS_EQUAL(1, atLeast16Ms);
+}
+
+TEST(LifetimeTracking, compactLayoutIsScannedToo)
+{
+	config.layout = BlockAllocator::CompactLayout;
+	BlockAllocator ba {blockSize, numOfBlocks, config};
+	ba.allocate();
+	void* second = ba.allocate();
+
+	std::vector<BlockAllocator::LiveBlock> blocks = ba.getOldestBlocks(numOfBlocks);
+
+	LONGS_EQUAL(2, blocks.size());
+	POINTERS_EQUAL(second, blocks[1].block);
+}
+
+TEST(LifetimeTracking, overheadCountsTheStampsAndTheHistogram)
+{
+	BlockAllocator tracked {blockSize, numOfBlocks, config};
+	BlockAllocator plain {blockSize, numOfBlocks};
+	size_t stampsAndHistogram = (numOfBlocks + BlockAllocator::numOfLifetimeBuckets) * sizeof(uint64_t);
+
+	CHECK_TRUE(tracked.getMemoryOverhead().sideTableBytes >= plain.getMemoryOverhead().sideTableBytes + stampsAndHistogram);
+}
+
+TEST(LifetimeTracking, disabledTrackingReportsNothing)
+{
+	BlockAllocator ba {blockSize, numOfBlocks};
+	ba.allocate();
+
+	CHECK_TRUE(ba.getOldestBlocks(1).empty());
+	CHECK_TRUE(ba.getLifetimeHistogram().empty());
+}
@@ -0,0 +1,197 @@
+#include "CppUTest/TestHarness.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "../src/blockChannel.h"
+
+using namespace BlockAllocatorExceptions;
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(BlockChannel)
+{
+	size_t numOfBlocks = 16;
+	size_t blockSize = 32;
+
+	BlockAllocator* ba;
+
+    void setup()
+    {
+    	ba = new BlockAllocator(blockSize, numOfBlocks);
+    }
+    void teardown()
+    {
+    	delete ba;
+	}
+};
+
+TEST(BlockChannel, receivedBlocksKeepOrderAndAddress)
+{
+	BlockChannel channel {*ba, 4};
+	void* first = ba->allocate();
+	void* second = ba->allocate();
+
+	CHECK_TRUE(channel.send(first));
+	CHECK_TRUE(channel.send(second));
+	LONGS_EQUAL(2, channel.size());
+
+	POINTERS_EQUAL(first, channel.receive());
+	POINTERS_EQUAL(second, channel.receive());
+	POINTERS_EQUAL(NULL, channel.receive());
+}
+
+TEST(BlockChannel, capacityIsRoundedUpToPowerOfTwo)
+{
+	BlockChannel channel {*ba, 3};
+
+	LONGS_EQUAL(4, channel.capacity());
+}
+
+TEST(BlockChannel, fullChannelSendsPartOfBatch)
+{
+	BlockChannel channel {*ba, 4};
+	void* blocks[6];
+	for (void*& block : blocks)
+	{
+		block = ba->allocate();
+	}
+
+	LONGS_EQUAL(4, channel.send(blocks, 6));
+	CHECK_FALSE(channel.send(blocks[4]));
+
+	void* received[6];
+	LONGS_EQUAL(4, channel.receive(received, 6));
+	POINTERS_EQUAL(blocks[3], received[3]);
+	LONGS_EQUAL(2, channel.send(blocks + 4, 2));
+}
+
+TEST(BlockChannel, invalidAddressLeavesChannelUnchanged)
+{
+	BlockChannel channel {*ba, 4};
+	void* blocks[2] = {ba->allocate(), (char*)ba->allocate() + 1};
+
+	CHECK_THROWS(InvalidBlockAddressException, channel.send(blocks, 2));
+	LONGS_EQUAL(0, channel.size());
+}
+
+TEST(BlockChannel, receivedBatchIsDeallocatedAtOnce)
+{
+	BlockChannel channel {*ba, numOfBlocks};
+	std::vector<void*> blocks(numOfBlocks);
+	for (void*& block : blocks)
+	{
+		block = ba->allocate();
+	}
+	channel.send(blocks.data(), blocks.size());
+
+	std::vector<void*> received(numOfBlocks);
+	LONGS_EQUAL(numOfBlocks, channel.receive(received.data(), received.size()));
+	ba->deallocate(received.data(), received.size());
+
+	for (size_t i = 0; i < numOfBlocks; i++)
+	{
+		ba->allocate();
+	}
+	CHECK_THROWS(OutOfAllocatableMemoryException, ba->allocate());
+}
+
+TEST(BlockChannel, blocksLeftInChannelAreDeallocated)
+{
+	{
+		BlockChannel channel {*ba, numOfBlocks};
+		for (size_t i = 0; i < numOfBlocks; i++)
+		{
+			channel.send(ba->allocate());
+		}
+	}
+
+	for (size_t i = 0; i < numOfBlocks; i++)
+	{
+		ba->allocate();
+	}
+}
+
+TEST(BlockChannel, blocksFreedBehindTheChannelAreSkipped)
+{
+	void* freed = ba->allocate();
+	void* kept = ba->allocate();
+	{
+		BlockChannel channel {*ba, numOfBlocks};
+		channel.send(freed);
+		channel.send(kept);
+		ba->deallocate(freed);
+	}
+
+	for (size_t i = 0; i < numOfBlocks; i++)
+	{
+		ba->allocate();
+	}
+	CHECK_THROWS(OutOfAllocatableMemoryException, ba->allocate());
+}
+
+TEST(BlockChannel, zeroCapacityIsRejected)
+{
+	CHECK_THROWS(InvalidConstructorParametersException, BlockChannel(*ba, 0));
+}
+
+TEST(BlockChannel, multipleProducersDeliverEveryBlockOnce)
+{
+	const size_t numOfProducers = 3;
+	const size_t blocksPerProducer = 1000;
+	BlockAllocator pool {blockSize, 64};
+	BlockChannel channel {pool, 16, BlockChannel::MultiProducer};
+	std::vector<std::thread> producers;
+
+	for (size_t p = 0; p < numOfProducers; p++)
+	{
+		producers.emplace_back([&pool, &channel, p, blocksPerProducer]()
+		{
+			for (size_t i = 0; i < blocksPerProducer; i++)
+			{
+				void* block;
+				for (;;)
+				{
+					try
+					{
+						block = pool.allocate();
+						break;
+					}
+					catch (const OutOfAllocatableMemoryException& e)
+					{
+						std::this_thread::yield();
+					}
+				}
+
+				*(size_t*)block = p * blocksPerProducer + i;
+				while (!channel.send(block))
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	std::vector<size_t> values;
+	void* received[8];
+	while (values.size() < numOfProducers * blocksPerProducer)
+	{
+		size_t count = channel.receive(received, 8);
+		for (size_t i = 0; i < count; i++)
+		{
+			values.push_back(*(size_t*)received[i]);
+		}
+		pool.deallocate(received, count);
+	}
+	for (std::thread& producer : producers)
+	{
+		producer.join();
+	}
+
+	std::sort(values.begin(), values.end());
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		LONGS_EQUAL(i, values[i]);
+	}
+}
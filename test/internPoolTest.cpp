@@ -0,0 +1,152 @@
+#include "CppUTest/TestHarness.h"
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/internPool.h"
+
+using namespace BlockAllocatorExceptions;
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(InternPool)
+{
+	size_t maxPayloadSize = 64;
+	size_t capacity = 8;
+
+	InternPool* pool;
+
+    void setup()
+    {
+    	pool = new InternPool(maxPayloadSize, capacity);
+    }
+    void teardown()
+    {
+    	delete pool;
+	}
+};
+
+TEST(InternPool, hashMatchesXxh64)
+{
+	const char* sentence = "Nobody inspects the spammish repetition";
+
+	CHECK_TRUE(InternPool::hash("", 0) == 0xEF46DB3751D8E999ull);
+	CHECK_TRUE(InternPool::hash("a", 1) == 0xD24EC4F1A98C6E5Bull);
+	CHECK_TRUE(InternPool::hash("abc", 3) == 0x44BC2CF5AD770999ull);
+	CHECK_TRUE(InternPool::hash(sentence, strlen(sentence)) == 0xFBCEA83C8A378BF1ull);
+}
+
+TEST(InternPool, identicalPayloadsShareABlock)
+{
+	std::string first = "Content-Type: text/plain";
+	std::string second = first;
+
+	const void* interned = pool->intern(first.data(), first.size());
+
+	POINTERS_EQUAL(interned, pool->intern(second.data(), second.size()));
+	CHECK_TRUE(interned != first.data());
+	MEMCMP_EQUAL(first.data(), interned, first.size());
+	LONGS_EQUAL(first.size(), pool->getLength(interned));
+	LONGS_EQUAL(1, pool->getNumOfEntries());
+	LONGS_EQUAL(2, pool->getNumOfReferences());
+	LONGS_EQUAL(first.size(), pool->getSavedBytes());
+}
+
+TEST(InternPool, differentPayloadsGetDifferentBlocks)
+{
+	const void* first = pool->intern("key", 3);
+	const void* prefix = pool->intern("key", 2);
+	const void* empty = pool->intern("", 0);
+
+	CHECK_TRUE(first != prefix);
+	CHECK_TRUE(first != empty && prefix != empty);
+	LONGS_EQUAL(0, pool->getLength(empty));
+	LONGS_EQUAL(3, pool->getNumOfEntries());
+	LONGS_EQUAL(0, pool->getSavedBytes());
+}
+
+TEST(InternPool, payloadsAreAligned)
+{
+	for (size_t length = 1; length < capacity; length++)
+	{
+		LONGS_EQUAL(0, (uintptr_t)pool->intern(std::string(length, 'x').data(), length) % 8);
+	}
+}
+
+TEST(InternPool, lastReleaseFreesTheBlock)
+{
+	const void* interned = pool->intern("value", 5);
+	pool->intern("value", 5);
+	pool->retain(interned);
+
+	pool->release(interned);
+	pool->release(interned);
+	LONGS_EQUAL(1, pool->getNumOfEntries());
+
+	pool->release(interned);
+	LONGS_EQUAL(0, pool->getNumOfEntries());
+	LONGS_EQUAL(0, pool->getNumOfReferences());
+	LONGS_EQUAL(0, pool->getSavedBytes());
+	CHECK_THROWS(InvalidBlockAddressException, pool->release(interned));
+}
+
+TEST(InternPool, invalidAddressThrows)
+{
+	const char* interned = (const char*)pool->intern("value", 5);
+	char outside[8];
+
+	CHECK_THROWS(InvalidBlockAddressException, pool->release(interned + 1));
+	CHECK_THROWS(InvalidBlockAddressException, pool->release(outside));
+	CHECK_THROWS(InvalidBlockAddressException, pool->retain(interned + pool->getAllocator().getBlockSize()));
+}
+
+TEST(InternPool, tooLargePayloadThrows)
+{
+	std::string payload(maxPayloadSize + 1, 'x');
+
+	CHECK_THROWS(PayloadTooLargeException, pool->intern(payload.data(), payload.size()));
+	pool->intern(payload.data(), maxPayloadSize);
+}
+
+TEST(InternPool, fullPoolStillFindsPooledPayloads)
+{
+	for (size_t i = 0; i < capacity; i++)
+	{
+		pool->intern(&i, sizeof(i));
+	}
+	size_t next = capacity;
+
+	CHECK_THROWS(OutOfAllocatableMemoryException, pool->intern(&next, sizeof(next)));
+	next = 0;
+	pool->intern(&next, sizeof(next));
+	LONGS_EQUAL(capacity, pool->getNumOfEntries());
+}
+
+TEST(InternPool, concurrentInternsDeduplicate)
+{
+	const size_t numOfThreads = 4;
+	const size_t numOfRounds = 1000;
+	std::vector<std::thread> threads;
+
+	for (size_t t = 0; t < numOfThreads; t++)
+	{
+		threads.emplace_back([this, numOfRounds]()
+		{
+			for (size_t i = 0; i < numOfRounds; i++)
+			{
+				size_t key = i % capacity;
+				pool->release(pool->intern(&key, sizeof(key)));
+				pool->intern(&key, sizeof(key));
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	LONGS_EQUAL(capacity, pool->getNumOfEntries());
+	LONGS_EQUAL(numOfThreads * numOfRounds, pool->getNumOfReferences());
+}
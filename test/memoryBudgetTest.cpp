@@ -0,0 +1,155 @@
+#include "CppUTest/TestHarness.h"
+
+#include <limits>
+#include <vector>
+
+#include "../src/allocatorArena.h"
+#include "../src/memoryBudget.h"
+
+using namespace BlockAllocatorExceptions;
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(MemoryBudget)
+{
+	size_t blockSize = 4096;
+	size_t numOfBlocks = 16;
+	size_t poolSize = 4096 * 16 + sizeof(void*) * 16;
+
+	MemoryBudget& budget = MemoryBudget::process();
+	// Other allocators of the process may be charged already, the tests look at differences only.
+	size_t chargedBefore;
+
+    void setup()
+    {
+    	chargedBefore = budget.getChargedBytes();
+    }
+    void teardown()
+    {
+    	budget.setLimit(0, 0);
+	}
+};
+
+TEST(MemoryBudget, internalPoolIsChargedUntilDestroyed)
+{
+	BlockAllocator* allocator = new BlockAllocator(blockSize, numOfBlocks);
+	LONGS_EQUAL(poolSize, budget.getChargedBytes() - chargedBefore);
+
+	delete allocator;
+	LONGS_EQUAL(chargedBefore, budget.getChargedBytes());
+}
+
+TEST(MemoryBudget, externalPoolIsNotCharged)
+{
+	std::vector<char> pool(poolSize);
+	BlockAllocator allocator(blockSize, numOfBlocks, pool.data());
+
+	LONGS_EQUAL(chargedBefore, budget.getChargedBytes());
+}
+
+TEST(MemoryBudget, exceedingTheLimitThrowsAndChargesNothing)
+{
+	size_t refusedBefore = budget.getRefusedCount();
+	budget.setLimit(chargedBefore + poolSize, 0);
+
+	BlockAllocator allocator(blockSize, numOfBlocks);
+	LONGS_EQUAL(0, budget.getAvailableBytes());
+
+	CHECK_THROWS(MemoryBudgetExceededException, BlockAllocator(blockSize, numOfBlocks));
+	CHECK_THROWS(MemoryBudgetExceededException, BlockAllocator(1, 1));
+	LONGS_EQUAL(poolSize, budget.getChargedBytes() - chargedBefore);
+	LONGS_EQUAL(refusedBefore + 2, budget.getRefusedCount());
+}
+
+TEST(MemoryBudget, removedLimitAcceptsEveryCharge)
+{
+	budget.setLimit(chargedBefore + 1);
+	CHECK_THROWS(MemoryBudgetExceededException, BlockAllocator(blockSize, numOfBlocks));
+
+	budget.setLimit(0);
+	BlockAllocator allocator(blockSize, numOfBlocks);
+	LONGS_EQUAL(0, budget.getLimit());
+	CHECK_TRUE(budget.getAvailableBytes() == std::numeric_limits<size_t>::max());
+}
+
+// Counts its calls, so the test doesn't depend on how many pages the allocators give back.
+static size_t countingTrimHook(void* context)
+{
+	++*(size_t*)context;
+	return 4096;
+}
+
+TEST(MemoryBudget, passingTheThresholdTrimsTheAllocators)
+{
+	size_t trimsBefore = budget.getTrimCount();
+	size_t hookCalls = 0;
+	MemoryBudget::Charge charge;
+	charge.reserve(1);
+	charge.setTrimHook(countingTrimHook, &hookCalls);
+
+	budget.setLimit(chargedBefore + 2 * poolSize, chargedBefore + poolSize);
+	LONGS_EQUAL(trimsBefore, budget.getTrimCount());
+	LONGS_EQUAL(0, hookCalls);
+
+	BlockAllocator allocator(blockSize, numOfBlocks);
+	LONGS_EQUAL(trimsBefore + 1, budget.getTrimCount());
+	LONGS_EQUAL(1, hookCalls);
+
+	// Staying above the threshold doesn't trim again.
+	charge.reserve(64);
+	LONGS_EQUAL(trimsBefore + 1, budget.getTrimCount());
+	LONGS_EQUAL(1, hookCalls);
+
+	// Dropping to the threshold arms the next crossing.
+	charge.release(64);
+	charge.release(1);
+	charge.reserve(1);
+	LONGS_EQUAL(trimsBefore + 2, budget.getTrimCount());
+	LONGS_EQUAL(2, hookCalls);
+
+	CHECK_TRUE(budget.trim() >= 4096);
+	LONGS_EQUAL(3, hookCalls);
+}
+
+static size_t throwingTrimHook(void*)
+{
+	throw std::exception();
+}
+
+TEST(MemoryBudget, throwingTrimHookDoesNotBlockRelease)
+{
+	size_t hookCalls = 0;
+	MemoryBudget::Charge* throwing = new MemoryBudget::Charge();
+	MemoryBudget::Charge counting;
+	counting.reserve(1);
+	counting.setTrimHook(countingTrimHook, &hookCalls);
+	throwing->reserve(1);
+	throwing->setTrimHook(throwingTrimHook, NULL);
+
+	CHECK_THROWS(std::exception, budget.trim());
+	LONGS_EQUAL(0, hookCalls);
+
+	// Would wait forever for the trim if it were still counted.
+	delete throwing;
+	CHECK_TRUE(budget.trim() >= 4096);
+	LONGS_EQUAL(1, hookCalls);
+}
+
+TEST(MemoryBudget, arenaChargesExistingPools)
+{
+	AllocatorArena arena(64, 16, 4);
+
+	LONGS_EQUAL(chargedBefore, budget.getChargedBytes());
+	BlockAllocator* first = arena.createAllocator();
+	BlockAllocator* second = arena.createAllocator();
+	LONGS_EQUAL(2 * arena.getPoolSize(), budget.getChargedBytes() - chargedBefore);
+
+	budget.setLimit(budget.getChargedBytes(), 0);
+	CHECK_THROWS(MemoryBudgetExceededException, arena.createAllocator());
+	LONGS_EQUAL(2, arena.getNumOfAllocators());
+
+	arena.destroyAllocator(first);
+	arena.createAllocator();
+	arena.destroyAllocator(second);
+	LONGS_EQUAL(arena.getPoolSize(), budget.getChargedBytes() - chargedBefore);
+}
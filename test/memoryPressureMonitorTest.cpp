@@ -0,0 +1,94 @@
+#include "CppUTest/TestHarness.h"
+
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+
+#include "../src/memoryPressureMonitor.h"
+
+using namespace BlockAllocatorExceptions;
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(MemoryPressureMonitor)
+{
+	size_t numOfBlocks = 4;
+	size_t blockSize = 0;
+
+	BlockAllocator* ba;
+	MemoryPressureMonitor::SimulatedPressureSource* source;
+	MemoryPressureMonitor* monitor;
+
+    void setup()
+    {
+    	blockSize = 2 * (size_t)sysconf(_SC_PAGESIZE);
+    	ba = new BlockAllocator(blockSize, numOfBlocks);
+    }
+    void teardown()
+    {
+    	delete monitor;
+    	delete ba;
+	}
+
+    void createMonitor(std::chrono::milliseconds minTrimInterval)
+    {
+    	source = new MemoryPressureMonitor::SimulatedPressureSource();
+    	monitor = new MemoryPressureMonitor(std::unique_ptr<MemoryPressureMonitor::PressureSource>(source), minTrimInterval);
+    	monitor->registerAllocator(*ba);
+    }
+};
+
+TEST(MemoryPressureMonitor, pressureTrimsRegisteredAllocators)
+{
+	createMonitor(std::chrono::milliseconds(0));
+
+	CHECK_TRUE(monitor->onPressure() > 0);
+	LONGS_EQUAL(1, monitor->getTrimCount());
+}
+
+TEST(MemoryPressureMonitor, pressureWithinMinIntervalIsIgnored)
+{
+	createMonitor(std::chrono::milliseconds(60000));
+
+	monitor->onPressure();
+
+	LONGS_EQUAL(0, monitor->onPressure());
+	LONGS_EQUAL(1, monitor->getTrimCount());
+}
+
+TEST(MemoryPressureMonitor, unregisteredAllocatorIsNotTrimmed)
+{
+	createMonitor(std::chrono::milliseconds(0));
+	monitor->unregisterAllocator(*ba);
+
+	LONGS_EQUAL(0, monitor->onPressure());
+}
+
+TEST(MemoryPressureMonitor, monitorThreadTrimsOnSimulatedPressure)
+{
+	createMonitor(std::chrono::milliseconds(0));
+	monitor->start();
+
+	source->signal();
+
+	for (int i = 0; i < 1000 && monitor->getTrimCount() == 0; i++)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	monitor->stop();
+
+	LONGS_EQUAL(1, monitor->getTrimCount());
+}
+
+TEST(MemoryPressureMonitor, missingPsiFileThrowsPressureSourceUnavailable)
+{
+	monitor = NULL;
+	CHECK_THROWS(PressureSourceUnavailableException, MemoryPressureMonitor::PsiPressureSource(std::chrono::microseconds(150000),
+			std::chrono::microseconds(2000000), "/nonexistent/pressure"));
+}
+
+TEST(MemoryPressureMonitor, missingCgroupFileThrowsPressureSourceUnavailable)
+{
+	monitor = NULL;
+	CHECK_THROWS(PressureSourceUnavailableException, MemoryPressureMonitor::CgroupEventsPressureSource("/nonexistent/memory.events"));
+}
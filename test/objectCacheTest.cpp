@@ -0,0 +1,200 @@
+#include "CppUTest/TestHarness.h"
+
+#include <string>
+#include <vector>
+
+#include "../src/objectCache.h"
+
+using namespace BlockAllocatorExceptions;
+
+// Counts constructions and destructions, owns a buffer whose capacity the cache must keep.
+struct HeavyObject
+{
+	static int constructed;
+	static int destroyed;
+
+	std::vector<int> values;
+	std::string name;
+
+	HeavyObject()
+	{
+		++constructed;
+	}
+
+	~HeavyObject()
+	{
+		++destroyed;
+	}
+};
+
+int HeavyObject::constructed = 0;
+int HeavyObject::destroyed = 0;
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(ObjectCache)
+{
+	size_t capacity = 4;
+
+	ObjectCache<HeavyObject>* cache;
+
+    void setup()
+    {
+    	HeavyObject::constructed = 0;
+    	HeavyObject::destroyed = 0;
+    	cache = new ObjectCache<HeavyObject>(capacity, [](HeavyObject& object)
+    	{
+    		object.values.clear();
+    		object.name.clear();
+    	});
+    }
+    void teardown()
+    {
+    	delete cache;
+	}
+};
+
+TEST(ObjectCache, releasedObjectIsReusedWithoutConstruction)
+{
+	HeavyObject* object = cache->acquire();
+	cache->release(object);
+
+	POINTERS_EQUAL(object, cache->acquire());
+	LONGS_EQUAL(1, HeavyObject::constructed);
+	LONGS_EQUAL(0, HeavyObject::destroyed);
+}
+
+TEST(ObjectCache, resetKeepsBufferCapacity)
+{
+	HeavyObject* object = cache->acquire();
+	object->values.resize(1000);
+	size_t reserved = object->values.capacity();
+
+	cache->release(object);
+	object = cache->acquire();
+
+	LONGS_EQUAL(0, object->values.size());
+	LONGS_EQUAL(reserved, object->values.capacity());
+	cache->release(object);
+}
+
+TEST(ObjectCache, releasingTwiceThrows)
+{
+	HeavyObject* object = cache->acquire();
+	cache->release(object);
+
+	CHECK_THROWS(InvalidBlockAddressException, cache->release(object));
+	LONGS_EQUAL(1, cache->getCachedCount());
+}
+
+TEST(ObjectCache, releasingAfterTrimThrows)
+{
+	HeavyObject* object = cache->acquire();
+	cache->release(object);
+	cache->trim();
+
+	CHECK_THROWS(InvalidBlockAddressException, cache->release(object));
+	LONGS_EQUAL(0, cache->getCachedCount());
+
+	// The trimmed block is handed out once only.
+	for (size_t i = 0; i < capacity; i++)
+	{
+		cache->acquire();
+	}
+	CHECK_THROWS(OutOfAllocatableMemoryException, cache->acquire());
+	LONGS_EQUAL(capacity + 1, HeavyObject::constructed);
+}
+
+TEST(ObjectCache, releasingNeverAcquiredObjectThrows)
+{
+	HeavyObject* object = cache->acquire();
+	HeavyObject* neighbour = (HeavyObject*)((char*)object + cache->getAllocator().getBlockSize());
+
+	CHECK_THROWS(InvalidBlockAddressException, cache->release(neighbour));
+	LONGS_EQUAL(0, cache->getCachedCount());
+	cache->release(object);
+}
+
+TEST(ObjectCache, foreignObjectIsRejected)
+{
+	HeavyObject foreign;
+	HeavyObject* object = cache->acquire();
+
+	CHECK_THROWS(InvalidBlockAddressException, cache->release(&foreign));
+	CHECK_THROWS(InvalidBlockAddressException, cache->release((HeavyObject*)((char*)object + 1)));
+}
+
+TEST(ObjectCache, cachedObjectsCountTowardsCapacity)
+{
+	for (size_t i = 0; i < capacity; i++)
+	{
+		cache->release(cache->acquire());
+		cache->acquire();
+	}
+
+	CHECK_THROWS(OutOfAllocatableMemoryException, cache->acquire());
+}
+
+TEST(ObjectCache, trimDestroysLeastRecentlyReleased)
+{
+	HeavyObject* objects[3];
+	for (HeavyObject*& object : objects)
+	{
+		object = cache->acquire();
+	}
+	for (HeavyObject* object : objects)
+	{
+		cache->release(object);
+	}
+
+	LONGS_EQUAL(2, cache->trim(1));
+	LONGS_EQUAL(2, HeavyObject::destroyed);
+	POINTERS_EQUAL(objects[2], cache->acquire());
+	cache->acquire();
+	LONGS_EQUAL(4, HeavyObject::constructed);
+}
+
+TEST(ObjectCache, destructorDestroysCachedObjects)
+{
+	cache->release(cache->acquire());
+	cache->release(cache->acquire());
+
+	delete cache;
+	cache = NULL;
+
+	LONGS_EQUAL(1, HeavyObject::destroyed);
+}
+
+TEST(ObjectCache, throwingResetHookKeepsObjectAcquired)
+{
+	bool isThrowing = true;
+	ObjectCache<HeavyObject> throwing {1, [&isThrowing](HeavyObject&)
+	{
+		if (isThrowing)
+			throw std::exception();
+	}};
+	HeavyObject* object = throwing.acquire();
+
+	CHECK_THROWS(std::exception, throwing.release(object));
+	LONGS_EQUAL(0, throwing.getCachedCount());
+
+	isThrowing = false;
+	throwing.release(object);
+	POINTERS_EQUAL(object, throwing.acquire());
+	throwing.release(object);
+}
+
+TEST(ObjectCache, throwingConstructorReturnsBlock)
+{
+	struct Throwing
+	{
+		Throwing()
+		{
+			throw std::exception();
+		}
+	};
+	ObjectCache<Throwing> throwing {1};
+
+	CHECK_THROWS(std::exception, throwing.acquire());
+	CHECK_THROWS(std::exception, throwing.acquire());
+}
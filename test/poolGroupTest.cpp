@@ -0,0 +1,166 @@
+#include "CppUTest/TestHarness.h"
+
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include "../src/poolGroup.h"
+
+using namespace BlockAllocatorExceptions;
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(PoolGroup)
+{
+	size_t blockSize = 32;
+	size_t blocksPerMember = 8;
+	size_t numOfMembers = 3;
+	size_t batch = 4;
+
+	PoolGroup* group;
+
+    void setup()
+    {
+    	group = new PoolGroup(blockSize, blocksPerMember, numOfMembers, batch);
+    }
+    void teardown()
+    {
+    	delete group;
+	}
+};
+
+TEST(PoolGroup, membersAllocateFromTheirOwnPools)
+{
+	void* first = group->allocate(0);
+	void* second = group->allocate(1);
+
+	CHECK_TRUE(group->getMemberPool(0).isBlockAddress(first));
+	CHECK_TRUE(group->getMemberPool(1).isBlockAddress(second));
+	LONGS_EQUAL(numOfMembers * blocksPerMember, group->getCapacity());
+	LONGS_EQUAL(2, group->getUsedBlocks());
+	LONGS_EQUAL(0, group->getMemberStats(0).borrowedBlocks);
+}
+
+TEST(PoolGroup, exhaustedMemberBorrowsABatch)
+{
+	for (size_t i = 0; i < blocksPerMember; i++)
+	{
+		group->allocate(0);
+	}
+	group->allocate(1);
+
+	void* borrowed = group->allocate(0);
+	PoolGroup::MemberStats borrower = group->getMemberStats(0);
+
+	// The idle third member has the most free blocks.
+	CHECK_TRUE(group->getMemberPool(2).isBlockAddress(borrowed));
+	LONGS_EQUAL(blocksPerMember + 1, borrower.usedBlocks);
+	LONGS_EQUAL(1, borrower.borrowedBlocks);
+	LONGS_EQUAL(batch - 1, borrower.stashedBlocks);
+	LONGS_EQUAL(1, borrower.borrowedBatches);
+	LONGS_EQUAL(batch, group->getMemberStats(2).lentBlocks);
+}
+
+TEST(PoolGroup, borrowedBlockGoesHomeOnFree)
+{
+	std::vector<void*> own;
+	for (size_t i = 0; i < blocksPerMember; i++)
+	{
+		own.push_back(group->allocate(0));
+	}
+	group->allocate(1);
+	void* borrowed = group->allocate(0);
+
+	group->deallocate(borrowed);
+
+	LONGS_EQUAL(0, group->getMemberStats(0).borrowedBlocks);
+	LONGS_EQUAL(batch - 1, group->getMemberStats(2).lentBlocks);
+	LONGS_EQUAL(blocksPerMember + 1, group->getUsedBlocks());
+}
+
+TEST(PoolGroup, freeingAnOwnBlockReturnsTheStash)
+{
+	std::vector<void*> own;
+	for (size_t i = 0; i < blocksPerMember; i++)
+	{
+		own.push_back(group->allocate(0));
+	}
+	group->allocate(1);
+	group->allocate(0);
+
+	group->deallocate(own[0]);
+
+	LONGS_EQUAL(0, group->getMemberStats(0).stashedBlocks);
+	LONGS_EQUAL(1, group->getMemberStats(2).lentBlocks);
+}
+
+TEST(PoolGroup, wholeGroupCapacityIsUsable)
+{
+	std::set<void*> blocks;
+	for (size_t i = 0; i < numOfMembers * blocksPerMember; i++)
+	{
+		blocks.insert(group->allocate(0));
+	}
+
+	LONGS_EQUAL(numOfMembers * blocksPerMember, blocks.size());
+	CHECK_THROWS(OutOfAllocatableMemoryException, group->allocate(1));
+
+	for (void* block : blocks)
+	{
+		group->deallocate(block);
+	}
+	LONGS_EQUAL(0, group->getUsedBlocks());
+}
+
+TEST(PoolGroup, stashesOfOtherMembersAreReclaimed)
+{
+	std::vector<void*> blocks;
+	for (size_t i = 0; i <= blocksPerMember; i++)
+	{
+		blocks.push_back(group->allocate(0));
+	}
+	for (size_t i = 0; i < 2 * blocksPerMember - batch; i++)
+	{
+		group->allocate(1);
+	}
+
+	// Only the blocks stashed by the first member are left.
+	for (size_t i = 0; i < batch - 1; i++)
+	{
+		group->allocate(1);
+	}
+	LONGS_EQUAL(0, group->getMemberStats(0).stashedBlocks);
+	CHECK_THROWS(OutOfAllocatableMemoryException, group->allocate(2));
+}
+
+TEST(PoolGroup, invalidAddressThrows)
+{
+	char* block = (char*)group->allocate(0);
+	char outside[8];
+
+	CHECK_THROWS(InvalidBlockAddressException, group->deallocate(block + 1));
+	CHECK_THROWS(InvalidBlockAddressException, group->deallocate(outside));
+
+	group->deallocate(block);
+	CHECK_THROWS(InvalidBlockAddressException, group->deallocate(block));
+}
+
+TEST(PoolGroup, stashedBlockCantBeDeallocated)
+{
+	for (size_t i = 0; i < blocksPerMember; i++)
+	{
+		group->allocate(0);
+	}
+	char* borrowed = (char*)group->allocate(0);
+	size_t stride = (char*)group->getMemberPool(2).getBlockAddress(1) - (char*)group->getMemberPool(2).getBlockAddress(0);
+
+	CHECK_THROWS(InvalidBlockAddressException, group->deallocate(borrowed - stride));
+}
+
+TEST(PoolGroup, invalidSettingsThrow)
+{
+	CHECK_THROWS(InvalidConstructorParametersException, PoolGroup(blockSize, blocksPerMember, 0));
+	CHECK_THROWS(InvalidConstructorParametersException, PoolGroup(blockSize, blocksPerMember, PoolGroup::maxMembers + 1));
+	CHECK_THROWS(InvalidConstructorParametersException, PoolGroup(blockSize, blocksPerMember, numOfMembers, 0));
+	CHECK_THROWS(std::out_of_range, group->allocate(numOfMembers));
+}
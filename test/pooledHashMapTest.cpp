@@ -0,0 +1,221 @@
+#include "CppUTest/TestHarness.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/pooledHashMap.h"
+
+using namespace BlockAllocatorExceptions;
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(PooledHashMap)
+{
+	size_t capacity = 64;
+
+	PooledHashMap<int, int>* map;
+
+    void setup()
+    {
+    	map = new PooledHashMap<int, int>(capacity, 4);
+    }
+    void teardown()
+    {
+    	delete map;
+	}
+};
+
+TEST(PooledHashMap, insertedEntryIsFound)
+{
+	int value = 0;
+
+	CHECK_TRUE(map->insert(7, 70));
+
+	CHECK_TRUE(map->find(7, value));
+	LONGS_EQUAL(70, value);
+	CHECK_FALSE(map->contains(8));
+	LONGS_EQUAL(1, map->size());
+}
+
+TEST(PooledHashMap, duplicateInsertKeepsValue)
+{
+	int value = 0;
+
+	map->insert(7, 70);
+
+	CHECK_FALSE(map->insert(7, 71));
+	map->find(7, value);
+	LONGS_EQUAL(70, value);
+	LONGS_EQUAL(1, map->size());
+}
+
+TEST(PooledHashMap, insertOrAssignReplacesValue)
+{
+	int value = 0;
+
+	CHECK_TRUE(map->insertOrAssign(7, 70));
+	CHECK_FALSE(map->insertOrAssign(7, 71));
+
+	map->find(7, value);
+	LONGS_EQUAL(71, value);
+}
+
+TEST(PooledHashMap, erasedEntryIsGone)
+{
+	for (int i = 0; i < 10; i++)
+	{
+		map->insert(i, i);
+	}
+
+	CHECK_TRUE(map->erase(5));
+	CHECK_FALSE(map->erase(5));
+
+	CHECK_FALSE(map->contains(5));
+	CHECK_TRUE(map->contains(4));
+	CHECK_TRUE(map->contains(6));
+	LONGS_EQUAL(9, map->size());
+}
+
+TEST(PooledHashMap, fullMapThrows)
+{
+	for (size_t i = 0; i < capacity; i++)
+	{
+		map->insert((int)i, 0);
+	}
+
+	CHECK_THROWS(OutOfAllocatableMemoryException, map->insert(-1, 0));
+
+	map->erase(0);
+	CHECK_TRUE(map->insert(-1, 0));
+}
+
+TEST(PooledHashMap, collidingKeysShareBucket)
+{
+	PooledHashMap<int, int> oneBucket(8, 1, 1);
+	int value = 0;
+
+	for (int i = 0; i < 8; i++)
+	{
+		oneBucket.insert(i, i * 10);
+	}
+	oneBucket.erase(3);
+
+	for (int i = 0; i < 8; i++)
+	{
+		CHECK_EQUAL(i != 3, oneBucket.find(i, value));
+	}
+	oneBucket.find(7, value);
+	LONGS_EQUAL(70, value);
+}
+
+TEST(PooledHashMap, clearReleasesAllNodes)
+{
+	for (size_t i = 0; i < capacity; i++)
+	{
+		map->insert((int)i, 0);
+	}
+
+	map->clear();
+
+	LONGS_EQUAL(0, map->size());
+	CHECK_FALSE(map->contains(0));
+	for (size_t i = 0; i < capacity; i++)
+	{
+		CHECK_TRUE(map->insert((int)i + 1000, 0));
+	}
+}
+
+TEST(PooledHashMap, clearAfterChurnResetsTheRing)
+{
+	for (int i = 0; i < 1000; i++)
+	{
+		map->insert(i, i);
+		map->erase(i);
+	}
+	map->insert(0, 0);
+
+	map->clear();
+	map->clear();
+
+	for (size_t i = 0; i < capacity; i++)
+	{
+		CHECK_TRUE(map->insert((int)i, 0));
+	}
+	CHECK_THROWS(OutOfAllocatableMemoryException, map->insert((int)capacity, 0));
+	LONGS_EQUAL(capacity, map->size());
+}
+
+TEST(PooledHashMap, entriesAreDestroyed)
+{
+	std::shared_ptr<int> tracked = std::make_shared<int>(0);
+	{
+		PooledHashMap<std::string, std::shared_ptr<int>> owners(8);
+
+		owners.insert("a", tracked);
+		owners.insert("b", tracked);
+		owners.insert("c", tracked);
+		owners.erase("a");
+		LONGS_EQUAL(3, tracked.use_count());
+
+		owners.clear();
+		LONGS_EQUAL(1, tracked.use_count());
+
+		owners.insert("d", tracked);
+	}
+	LONGS_EQUAL(1, tracked.use_count());
+}
+
+TEST(PooledHashMap, zeroCapacityIsRejected)
+{
+	CHECK_THROWS(InvalidConstructorParametersException, (PooledHashMap<int, int>(0)));
+}
+
+TEST(PooledHashMap, nodePoolEngineCanBeChosen)
+{
+	PooledHashMap<int, int> mutexNodes(8, 4, 0, BlockAllocator::MutexFreeList);
+
+	LONGS_EQUAL(BlockAllocator::RingFreeList, map->getAllocator().getFreeListType());
+	LONGS_EQUAL(BlockAllocator::MutexFreeList, mutexNodes.getAllocator().getFreeListType());
+	for (int i = 0; i < 8; i++)
+	{
+		CHECK_TRUE(mutexNodes.insert(i, i));
+	}
+	CHECK_THROWS(OutOfAllocatableMemoryException, mutexNodes.insert(8, 8));
+	CHECK_THROWS(InvalidConstructorParametersException, (PooledHashMap<int, int>(8, 4, 0, BlockAllocator::BiasedFreeList)));
+}
+
+TEST(PooledHashMap, concurrentInsertsAndErasesKeepCount)
+{
+	const int numOfThreads = 4;
+	const int keysPerThread = 256;
+	PooledHashMap<int, int> shared(numOfThreads * keysPerThread, 8);
+	std::vector<std::thread> threads;
+
+	for (int t = 0; t < numOfThreads; t++)
+	{
+		threads.emplace_back([&shared, t, keysPerThread]()
+		{
+			for (int round = 0; round < 10; round++)
+			{
+				for (int i = 0; i < keysPerThread; i++)
+				{
+					shared.insert(t * keysPerThread + i, round);
+				}
+				for (int i = 0; i < keysPerThread; i += 2)
+				{
+					shared.erase(t * keysPerThread + i);
+				}
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	LONGS_EQUAL(numOfThreads * keysPerThread / 2, shared.size());
+	CHECK_TRUE(shared.contains(1));
+	CHECK_FALSE(shared.contains(0));
+}
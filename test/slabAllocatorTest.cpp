@@ -0,0 +1,164 @@
+#include "CppUTest/TestHarness.h"
+
+#include <cstring>
+#include <set>
+#include <vector>
+
+#include "../src/slabAllocator.h"
+
+using namespace BlockAllocatorExceptions;
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(SlabAllocator)
+{
+	size_t numOfBlocks = 4;
+	size_t blockSize = 4096;
+	size_t slotSize = 24;
+
+	BlockAllocator* parent;
+	SlabAllocator* slab;
+
+    void setup()
+    {
+    	parent = new BlockAllocator(blockSize, numOfBlocks);
+    	slab = new SlabAllocator(*parent, slotSize);
+    }
+    void teardown()
+    {
+    	delete slab;
+    	delete parent;
+	}
+};
+
+TEST(SlabAllocator, slotsArePackedWithoutHeaders)
+{
+	char* first = (char*)slab->allocate();
+	char* second = (char*)slab->allocate();
+
+	POINTERS_EQUAL(first + slotSize, second);
+	CHECK_TRUE(slab->getSlotsPerBlock() * slotSize >= blockSize - 64);
+	LONGS_EQUAL(1, slab->getNumOfBlocks());
+}
+
+TEST(SlabAllocator, fullBlockTakesAnotherFromParent)
+{
+	std::set<void*> slots;
+	for (size_t i = 0; i <= slab->getSlotsPerBlock(); i++)
+	{
+		slots.insert(slab->allocate());
+	}
+
+	LONGS_EQUAL(slab->getSlotsPerBlock() + 1, slots.size());
+	LONGS_EQUAL(2, slab->getNumOfBlocks());
+	LONGS_EQUAL(slots.size(), slab->getNumOfSlots());
+}
+
+TEST(SlabAllocator, freedSlotIsReused)
+{
+	slab->allocate();
+	void* second = slab->allocate();
+	slab->allocate();
+
+	slab->deallocate(second);
+
+	POINTERS_EQUAL(second, slab->allocate());
+}
+
+TEST(SlabAllocator, emptyBlockGoesBackToParent)
+{
+	std::vector<void*> slots;
+	for (size_t i = 0; i < slab->getSlotsPerBlock() * numOfBlocks; i++)
+	{
+		slots.push_back(slab->allocate());
+	}
+	CHECK_THROWS(OutOfAllocatableMemoryException, slab->allocate());
+	CHECK_THROWS(OutOfAllocatableMemoryException, parent->allocate());
+
+	// The first empty block is kept, the second goes back.
+	for (size_t i = 0; i < slab->getSlotsPerBlock() * 2; i++)
+	{
+		slab->deallocate(slots[i]);
+	}
+
+	LONGS_EQUAL(numOfBlocks - 1, slab->getNumOfBlocks());
+	parent->deallocate(parent->allocate());
+}
+
+TEST(SlabAllocator, churnKeepsTheEmptyBlock)
+{
+	void* slot = slab->allocate();
+	slab->deallocate(slot);
+
+	for (size_t i = 0; i < 100; i++)
+	{
+		POINTERS_EQUAL(slot, slab->allocate());
+		slab->deallocate(slot);
+	}
+	LONGS_EQUAL(1, slab->getNumOfBlocks());
+	for (size_t i = 0; i < numOfBlocks - 1; i++)
+	{
+		parent->allocate();
+	}
+	CHECK_THROWS(OutOfAllocatableMemoryException, parent->allocate());
+}
+
+TEST(SlabAllocator, invalidSlotsAreRejected)
+{
+	char* slot = (char*)slab->allocate();
+	void* block = parent->allocate();
+	int local;
+
+	CHECK_THROWS(InvalidBlockAddressException, slab->deallocate(slot + 1));
+	CHECK_THROWS(InvalidBlockAddressException, slab->deallocate(slot + slotSize));
+	CHECK_THROWS(InvalidBlockAddressException, slab->deallocate(block));
+	CHECK_THROWS(InvalidBlockAddressException, slab->deallocate(&local));
+
+	// A foreign parent block is rejected whatever it holds, even a copy of a slab block.
+	memcpy(block, slot, blockSize);
+	CHECK_THROWS(InvalidBlockAddressException, slab->deallocate((char*)block + slotSize));
+
+	slab->deallocate(slot);
+	CHECK_THROWS(InvalidBlockAddressException, slab->deallocate(slot));
+}
+
+TEST(SlabAllocator, destructorReturnsBlocks)
+{
+	slab->allocate();
+	delete slab;
+	slab = NULL;
+
+	for (size_t i = 0; i < numOfBlocks; i++)
+	{
+		parent->allocate();
+	}
+}
+
+TEST(SlabAllocator, compactParentIsSupported)
+{
+	BlockAllocator::Config config;
+	config.layout = BlockAllocator::CompactLayout;
+	BlockAllocator compact {256, 2, config};
+	SlabAllocator tiny {compact, 16};
+
+	std::vector<void*> slots;
+	for (size_t i = 0; i < tiny.getSlotsPerBlock() * 2; i++)
+	{
+		slots.push_back(tiny.allocate());
+	}
+	for (void* slot : slots)
+	{
+		tiny.deallocate(slot);
+	}
+
+	LONGS_EQUAL(1, tiny.getNumOfBlocks());
+}
+
+TEST(SlabAllocator, invalidParametersAreRejected)
+{
+	BlockAllocator small {32, 2};
+
+	CHECK_THROWS(InvalidConstructorParametersException, SlabAllocator(*parent, 0));
+	CHECK_THROWS(InvalidConstructorParametersException, SlabAllocator(*parent, blockSize));
+	CHECK_THROWS(InvalidConstructorParametersException, SlabAllocator(small, 16));
+}
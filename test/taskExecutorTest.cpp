@@ -0,0 +1,141 @@
+#include "CppUTest/TestHarness.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+#include "../src/taskExecutor.h"
+
+using namespace BlockAllocatorExceptions;
+
+//---------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+TEST_GROUP(TaskExecutor)
+{
+	size_t numOfWorkers = 3;
+	size_t maxTaskSize = 48;
+	size_t maxTasks = 256;
+
+	TaskExecutor* executor;
+
+    void setup()
+    {
+    	executor = new TaskExecutor(numOfWorkers, maxTaskSize, maxTasks);
+    }
+    void teardown()
+    {
+    	delete executor;
+	}
+};
+
+TEST(TaskExecutor, submittedTasksAreRun)
+{
+	std::atomic<int> sum(0);
+
+	for (int i = 1; i <= 100; i++)
+	{
+		executor->submit([&sum, i]()
+		{
+			sum += i;
+		});
+	}
+	executor->waitForAll();
+
+	LONGS_EQUAL(5050, sum.load());
+	LONGS_EQUAL(0, executor->getUnfinishedTasks());
+}
+
+TEST(TaskExecutor, capturesAreStoredInline)
+{
+	std::array<int, 10> values;
+	std::atomic<int> sum(0);
+	values.fill(2);
+
+	executor->submit([&sum, values]()
+	{
+		for (int value : values)
+		{
+			sum += value;
+		}
+	});
+	executor->waitForAll();
+
+	LONGS_EQUAL(20, sum.load());
+}
+
+TEST(TaskExecutor, maxTaskSizeIsRoundedUp)
+{
+	CHECK_TRUE(executor->getMaxTaskSize() >= maxTaskSize);
+	LONGS_EQUAL(numOfWorkers, executor->getNumOfWorkers());
+}
+
+TEST(TaskExecutor, tooLargeTaskThrows)
+{
+	std::array<char, 256> large {};
+
+	CHECK_THROWS(TaskTooLargeException, executor->submit([large]() {}));
+}
+
+TEST(TaskExecutor, tasksSubmittedFromTasksAreRun)
+{
+	std::atomic<int> count(0);
+	TaskExecutor* pool = executor;
+
+	for (int i = 0; i < 10; i++)
+	{
+		executor->submit([pool, &count]()
+		{
+			for (int j = 0; j < 10; j++)
+			{
+				pool->submit([&count]()
+				{
+					++count;
+				});
+			}
+		});
+	}
+	executor->waitForAll();
+
+	LONGS_EQUAL(100, count.load());
+}
+
+TEST(TaskExecutor, callablesAreDestroyedAfterRun)
+{
+	std::shared_ptr<int> tracked = std::make_shared<int>(0);
+
+	for (int i = 0; i < 10; i++)
+	{
+		executor->submit([tracked]()
+		{
+			++*tracked;
+		});
+	}
+	executor->waitForAll();
+
+	LONGS_EQUAL(10, *tracked);
+	LONGS_EQUAL(1, tracked.use_count());
+}
+
+TEST(TaskExecutor, destructorRunsTasksLeft)
+{
+	std::atomic<int> count(0);
+	{
+		TaskExecutor local {1, maxTaskSize, maxTasks};
+		for (int i = 0; i < 50; i++)
+		{
+			local.submit([&count]()
+			{
+				++count;
+			});
+		}
+	}
+
+	LONGS_EQUAL(50, count.load());
+}
+
+TEST(TaskExecutor, invalidParametersAreRejected)
+{
+	CHECK_THROWS(InvalidConstructorParametersException, TaskExecutor(0, maxTaskSize, maxTasks));
+	CHECK_THROWS(InvalidConstructorParametersException, TaskExecutor(1, 0, maxTasks));
+	CHECK_THROWS(InvalidConstructorParametersException, TaskExecutor(1, maxTaskSize, 0));
+}
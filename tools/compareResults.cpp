@@ -0,0 +1,314 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "jsonReader.h"
+
+// Compares two benchmark result files written by "benchmarks --json".
+// Every metric of every case present in both files is compared with Welch's t-test over the repeats.
+// A change is a regression when the mean got worse by more than the threshold and the confidence interval
+// of the difference doesn't include zero. The exit code is 1 if any regression is found.
+
+struct Settings
+{
+	std::string baselinePath;
+	std::string candidatePath;
+	double threshold = 0.05;
+	double confidence = 0.95;
+	std::vector<std::string> metrics = {"opsPerSecond", "allocateP99Ns", "deallocateP99Ns"};
+};
+
+struct Samples
+{
+	size_t count = 0;
+	double mean = 0;
+	double variance = 0;
+};
+
+// Continued fraction of the regularized incomplete beta function, see Numerical Recipes 6.4.
+static double betaContinuedFraction(double a, double b, double x)
+{
+	const double tiny = 1e-300;
+	double qab = a + b;
+	double qap = a + 1;
+	double qam = a - 1;
+	double c = 1;
+	double d = 1 - qab * x / qap;
+
+	d = std::fabs(d) < tiny ? tiny : d;
+	d = 1 / d;
+	double h = d;
+
+	for (int m = 1; m <= 200; m++)
+	{
+		int m2 = 2 * m;
+		double aa = m * (b - m) * x / ((qam + m2) * (a + m2));
+		d = 1 + aa * d;
+		d = std::fabs(d) < tiny ? tiny : d;
+		c = 1 + aa / c;
+		c = std::fabs(c) < tiny ? tiny : c;
+		d = 1 / d;
+		h *= d * c;
+
+		aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2));
+		d = 1 + aa * d;
+		d = std::fabs(d) < tiny ? tiny : d;
+		c = 1 + aa / c;
+		c = std::fabs(c) < tiny ? tiny : c;
+		d = 1 / d;
+		double delta = d * c;
+		h *= delta;
+
+		if (std::fabs(delta - 1) < 1e-12)
+			break;
+	}
+	return h;
+}
+
+static double incompleteBeta(double a, double b, double x)
+{
+	if (x <= 0)
+		return 0;
+	if (x >= 1)
+		return 1;
+
+	double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log(1 - x));
+
+	if (x < (a + 1) / (a + b + 2))
+		return front * betaContinuedFraction(a, b, x) / a;
+	return 1 - front * betaContinuedFraction(b, a, 1 - x) / b;
+}
+
+// Student's t cumulative distribution for t >= 0.
+static double studentCdf(double t, double df)
+{
+	return 1 - 0.5 * incompleteBeta(df / 2, 0.5, df / (df + t * t));
+}
+
+// The two-sided critical value of Student's t distribution.
+static double studentCritical(double confidence, double df)
+{
+	double target = 1 - (1 - confidence) / 2;
+	double low = 0;
+	double high = 1000;
+
+	for (int i = 0; i < 200; i++)
+	{
+		double middle = (low + high) / 2;
+		if (studentCdf(middle, df) < target)
+			low = middle;
+		else
+			high = middle;
+	}
+	return (low + high) / 2;
+}
+
+static Samples summarize(const JsonValue* values)
+{
+	Samples samples;
+
+	if (values == NULL || values->type != JsonValue::Array)
+		return samples;
+
+	std::vector<double> numbers;
+	for (const JsonValue& value : values->array)
+	{
+		if (value.type == JsonValue::Number)
+			numbers.push_back(value.number);
+	}
+
+	samples.count = numbers.size();
+	for (double number : numbers)
+	{
+		samples.mean += number / numbers.size();
+	}
+	for (double number : numbers)
+	{
+		samples.variance += (number - samples.mean) * (number - samples.mean) / (numbers.size() > 1 ? numbers.size() - 1 : 1);
+	}
+	return samples;
+}
+
+static std::string caseKey(const JsonValue& result)
+{
+	return result.stringOr("subject") + " t" + std::to_string((long)result.numberOr("threads", 0)) + " " + result.stringOr("order");
+}
+
+static const JsonValue* findCase(const JsonValue& results, const std::string& key)
+{
+	for (const JsonValue& result : results.array)
+	{
+		if (caseKey(result) == key)
+			return &result;
+	}
+	return NULL;
+}
+
+static bool higherIsBetter(const std::string& metric)
+{
+	return metric == "opsPerSecond";
+}
+
+// Prints the comparison of one metric and returns true if it regressed.
+static bool compareMetric(const std::string& key, const std::string& metric, const Samples& baseline, const Samples& candidate,
+		const Settings& settings)
+{
+	if (baseline.count == 0 || candidate.count == 0 || baseline.mean == 0)
+		return false;
+
+	double difference = candidate.mean - baseline.mean;
+	double sign = higherIsBetter(metric) ? -1 : 1;
+	double change = difference / baseline.mean;
+	bool worse = sign * change > settings.threshold;
+	bool significant = true;
+	double low = change;
+	double high = change;
+
+	// Without repeats there's no variance estimate, only the threshold applies.
+	if (baseline.count > 1 && candidate.count > 1)
+	{
+		double baselineTerm = baseline.variance / baseline.count;
+		double candidateTerm = candidate.variance / candidate.count;
+		double error = std::sqrt(baselineTerm + candidateTerm);
+
+		if (error > 0)
+		{
+			double df = std::pow(baselineTerm + candidateTerm, 2) /
+					(baselineTerm * baselineTerm / (baseline.count - 1) + candidateTerm * candidateTerm / (candidate.count - 1));
+			double margin = studentCritical(settings.confidence, df) * error;
+
+			low = (difference - margin) / baseline.mean;
+			high = (difference + margin) / baseline.mean;
+			significant = low > 0 || high < 0;
+		}
+	}
+
+	const char* verdict = "";
+	if (worse && significant)
+		verdict = "REGRESSION";
+	else if (sign * change < -settings.threshold && significant)
+		verdict = "improved";
+	else if (!significant)
+		verdict = "noise";
+
+	printf("%-40s %-18s %14.4g %14.4g %+8.2f%% [%+8.2f%%, %+8.2f%%] %s\n", key.c_str(), metric.c_str(),
+			baseline.mean, candidate.mean, change * 100, low * 100, high * 100, verdict);
+
+	return worse && significant;
+}
+
+static std::vector<std::string> parseList(const std::string& text)
+{
+	std::vector<std::string> items;
+	size_t start = 0;
+
+	while (start <= text.size())
+	{
+		size_t end = text.find(',', start);
+		if (end == std::string::npos)
+			end = text.size();
+		if (end > start)
+			items.push_back(text.substr(start, end - start));
+		start = end + 1;
+	}
+	return items;
+}
+
+static bool parseSettings(int argc, char** argv, Settings& settings)
+{
+	std::vector<std::string> paths;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+
+		if (arg.compare(0, 2, "--") != 0)
+		{
+			paths.push_back(arg);
+			continue;
+		}
+		if (i + 1 >= argc)
+			return false;
+
+		if (arg == "--threshold")
+			settings.threshold = atof(argv[++i]) / 100;
+		else if (arg == "--confidence")
+			settings.confidence = atof(argv[++i]);
+		else if (arg == "--metrics")
+			settings.metrics = parseList(argv[++i]);
+		else
+			return false;
+	}
+
+	if (paths.size() != 2 || settings.confidence <= 0 || settings.confidence >= 1)
+		return false;
+
+	settings.baselinePath = paths[0];
+	settings.candidatePath = paths[1];
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	Settings settings;
+
+	if (!parseSettings(argc, argv, settings))
+	{
+		printf("Usage: %s BASELINE.json CANDIDATE.json [--threshold PERCENT] [--confidence 0.95] [--metrics NAME[,NAME...]]\n", argv[0]);
+		return 2;
+	}
+
+	JsonValue baseline;
+	JsonValue candidate;
+	try
+	{
+		baseline = JsonValue::parseFile(settings.baselinePath);
+		candidate = JsonValue::parseFile(settings.candidatePath);
+	}
+	catch (const std::runtime_error& e)
+	{
+		printf("%s\n", e.what());
+		return 2;
+	}
+
+	const JsonValue* baselineResults = baseline.find("results");
+	const JsonValue* candidateResults = candidate.find("results");
+	if (baselineResults == NULL || candidateResults == NULL)
+	{
+		printf("Not a benchmark result file\n");
+		return 2;
+	}
+
+	const JsonValue* baselineEnvironment = baseline.find("environment");
+	const JsonValue* candidateEnvironment = candidate.find("environment");
+	if (baselineEnvironment != NULL && candidateEnvironment != NULL &&
+			baselineEnvironment->stringOr("cpu") != candidateEnvironment->stringOr("cpu"))
+	{
+		printf("Warning: results come from different CPUs\n");
+	}
+
+	printf("threshold %.1f%%, confidence %.0f%%\n\n", settings.threshold * 100, settings.confidence * 100);
+	printf("%-40s %-18s %14s %14s %9s %24s\n", "case", "metric", "baseline", "candidate", "change", "confidence interval");
+
+	size_t regressions = 0;
+	for (const JsonValue& result : baselineResults->array)
+	{
+		std::string key = caseKey(result);
+		const JsonValue* other = findCase(*candidateResults, key);
+
+		if (other == NULL)
+			continue;
+
+		for (const std::string& metric : settings.metrics)
+		{
+			if (compareMetric(key, metric, summarize(result.find(metric)), summarize(other->find(metric)), settings))
+				++regressions;
+		}
+	}
+
+	printf("\n%zu regression(s)\n", regressions);
+	return regressions == 0 ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "jsonReader.h"
+
+// Compares two allocator snapshots written by BlockAllocator::dumpState().
+// The pool is split into equal regions of block indices, the used blocks of every region and the live blocks of every tag
+// are compared, so a leak shows up as the regions and tags which grew.
+
+struct Settings
+{
+	std::string beforePath;
+	std::string afterPath;
+	size_t regions = 16;
+};
+
+struct TagRow
+{
+	long tag;
+	std::string name;
+	double liveBefore = 0;
+	double liveAfter = 0;
+	double peakAfter = 0;
+};
+
+// Counts the used blocks of every region from the [first, length] runs.
+static std::vector<size_t> usedPerRegion(const JsonValue& state, size_t maxBlocks, size_t regions)
+{
+	std::vector<size_t> counts(regions, 0);
+	const JsonValue* runs = state.find("usedRuns");
+
+	if (runs == NULL || runs->type != JsonValue::Array || maxBlocks == 0)
+		return counts;
+
+	size_t regionSize = (maxBlocks + regions - 1) / regions;
+	for (const JsonValue& run : runs->array)
+	{
+		if (run.type != JsonValue::Array || run.array.size() != 2)
+			continue;
+
+		size_t first = (size_t)run.array[0].number;
+		size_t end = std::min(first + (size_t)run.array[1].number, maxBlocks);
+		while (first < end)
+		{
+			size_t region = first / regionSize;
+			size_t regionEnd = std::min((region + 1) * regionSize, end);
+
+			counts[region] += regionEnd - first;
+			first = regionEnd;
+		}
+	}
+	return counts;
+}
+
+static std::vector<TagRow> compareTags(const JsonValue& before, const JsonValue& after)
+{
+	std::vector<TagRow> rows;
+	const JsonValue* tags[2] = {before.find("tags"), after.find("tags")};
+
+	for (int side = 0; side < 2; side++)
+	{
+		if (tags[side] == NULL || tags[side]->type != JsonValue::Array)
+			continue;
+
+		for (const JsonValue& tag : tags[side]->array)
+		{
+			long id = (long)tag.numberOr("tag", -1);
+			auto row = std::find_if(rows.begin(), rows.end(), [id](const TagRow& r) { return r.tag == id; });
+			if (row == rows.end())
+			{
+				rows.push_back(TagRow());
+				row = rows.end() - 1;
+				row->tag = id;
+			}
+
+			row->name = tag.stringOr("name");
+			if (side == 0)
+				row->liveBefore = tag.numberOr("liveBlocks", 0);
+			else
+			{
+				row->liveAfter = tag.numberOr("liveBlocks", 0);
+				row->peakAfter = tag.numberOr("peakBlocks", 0);
+			}
+		}
+	}
+
+	std::stable_sort(rows.begin(), rows.end(), [](const TagRow& a, const TagRow& b)
+	{
+		return a.liveAfter - a.liveBefore > b.liveAfter - b.liveBefore;
+	});
+	return rows;
+}
+
+static bool parseSettings(int argc, char** argv, Settings& settings)
+{
+	std::vector<std::string> paths;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+
+		if (arg.compare(0, 2, "--") != 0)
+		{
+			paths.push_back(arg);
+			continue;
+		}
+		if (i + 1 >= argc)
+			return false;
+
+		if (arg == "--regions")
+			settings.regions = strtoul(argv[++i], NULL, 10);
+		else
+			return false;
+	}
+
+	if (paths.size() != 2 || settings.regions == 0)
+		return false;
+
+	settings.beforePath = paths[0];
+	settings.afterPath = paths[1];
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	Settings settings;
+
+	if (!parseSettings(argc, argv, settings))
+	{
+		printf("Usage: %s BEFORE.json AFTER.json [--regions N]\n", argv[0]);
+		return 2;
+	}
+
+	JsonValue before;
+	JsonValue after;
+	try
+	{
+		before = JsonValue::parseFile(settings.beforePath);
+		after = JsonValue::parseFile(settings.afterPath);
+	}
+	catch (const std::runtime_error& e)
+	{
+		printf("%s\n", e.what());
+		return 2;
+	}
+
+	const JsonValue* beforeGeometry = before.find("geometry");
+	const JsonValue* afterGeometry = after.find("geometry");
+	const JsonValue* beforeStats = before.find("stats");
+	const JsonValue* afterStats = after.find("stats");
+	if (beforeGeometry == NULL || afterGeometry == NULL || beforeStats == NULL || afterStats == NULL)
+	{
+		printf("Not an allocator state file\n");
+		return 2;
+	}
+
+	size_t maxBlocks = (size_t)afterGeometry->numberOr("maxBlocks", 0);
+	if (beforeGeometry->numberOr("blockSize", 0) != afterGeometry->numberOr("blockSize", 0) ||
+			beforeGeometry->numberOr("maxBlocks", 0) != maxBlocks)
+	{
+		printf("Warning: the snapshots come from pools of different geometry\n");
+	}
+
+	printf("block size %.0f, %zu blocks, %s layout, %s free list\n\n", afterGeometry->numberOr("blockSize", 0), maxBlocks,
+			afterGeometry->stringOr("layout").c_str(), afterGeometry->stringOr("freeList").c_str());
+
+	printf("%-16s %12s %12s %12s\n", "", "before", "after", "change");
+	const char* stats[] = {"usedBlocks", "untouchedBlocks", "waiters"};
+	for (const char* stat : stats)
+	{
+		double from = beforeStats->numberOr(stat, 0);
+		double to = afterStats->numberOr(stat, 0);
+		printf("%-16s %12.0f %12.0f %+12.0f\n", stat, from, to, to - from);
+	}
+
+	size_t regions = std::min(settings.regions, std::max(maxBlocks, (size_t)1));
+	size_t regionSize = (maxBlocks + regions - 1) / regions;
+	std::vector<size_t> usedBefore = usedPerRegion(before, maxBlocks, regions);
+	std::vector<size_t> usedAfter = usedPerRegion(after, maxBlocks, regions);
+
+	printf("\n%-24s %12s %12s %12s\n", "region (block indices)", "used before", "used after", "change");
+	for (size_t i = 0; i < regions; i++)
+	{
+		if (usedBefore[i] == usedAfter[i] || i * regionSize >= maxBlocks)
+			continue;
+
+		std::string range = std::to_string(i * regionSize) + "-" + std::to_string(std::min((i + 1) * regionSize, maxBlocks) - 1);
+		printf("%-24s %12zu %12zu %+12ld\n", range.c_str(), usedBefore[i], usedAfter[i], (long)usedAfter[i] - (long)usedBefore[i]);
+	}
+
+	std::vector<TagRow> tags = compareTags(before, after);
+	if (!tags.empty())
+	{
+		printf("\n%-4s %-20s %12s %12s %12s %12s\n", "tag", "name", "live before", "live after", "change", "peak after");
+		for (const TagRow& row : tags)
+		{
+			printf("%-4ld %-20s %12.0f %12.0f %+12.0f %12.0f\n", row.tag, row.name.c_str(), row.liveBefore, row.liveAfter,
+					row.liveAfter - row.liveBefore, row.peakAfter);
+		}
+	}
+
+	return 0;
+}
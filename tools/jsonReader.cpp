@@ -0,0 +1,252 @@
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "jsonReader.h"
+
+namespace
+{
+
+class Parser
+{
+public:
+	explicit Parser(const std::string& source) :
+		text(source)
+	{}
+
+	JsonValue parseDocument()
+	{
+		JsonValue value = parseValue();
+		skipSpace();
+		if (position != text.size())
+			fail("trailing characters");
+		return value;
+	}
+
+private:
+	const std::string& text;
+	size_t position = 0;
+
+	[[noreturn]] void fail(const char* what) const
+	{
+		throw std::runtime_error("JSON " + std::string(what) + " at offset " + std::to_string(position));
+	}
+
+	void skipSpace()
+	{
+		while (position < text.size() && (text[position] == ' ' || text[position] == '\n' || text[position] == '\r' || text[position] == '\t'))
+		{
+			++position;
+		}
+	}
+
+	void expect(char c)
+	{
+		skipSpace();
+		if (position >= text.size() || text[position] != c)
+			fail("unexpected character");
+		++position;
+	}
+
+	bool consume(const char* word)
+	{
+		size_t length = std::char_traits<char>::length(word);
+		if (text.compare(position, length, word) != 0)
+			return false;
+		position += length;
+		return true;
+	}
+
+	JsonValue parseValue()
+	{
+		skipSpace();
+		if (position >= text.size())
+			fail("unexpected end");
+
+		JsonValue value;
+		char c = text[position];
+
+		if (c == '{')
+			parseObject(value);
+		else if (c == '[')
+			parseArray(value);
+		else if (c == '"')
+		{
+			value.type = JsonValue::String;
+			value.string = parseString();
+		}
+		else if (consume("null"))
+			value.type = JsonValue::Null;
+		else if (consume("true"))
+		{
+			value.type = JsonValue::Bool;
+			value.boolean = true;
+		}
+		else if (consume("false"))
+			value.type = JsonValue::Bool;
+		else
+			parseNumber(value);
+
+		return value;
+	}
+
+	void parseObject(JsonValue& value)
+	{
+		value.type = JsonValue::Object;
+		expect('{');
+		skipSpace();
+		if (position < text.size() && text[position] == '}')
+		{
+			++position;
+			return;
+		}
+
+		do
+		{
+			skipSpace();
+			std::string key = parseString();
+			expect(':');
+			value.object.emplace_back(key, parseValue());
+			skipSpace();
+		}
+		while (position < text.size() && text[position++] == ',');
+
+		if (text[position - 1] != '}')
+			fail("unterminated object");
+	}
+
+	void parseArray(JsonValue& value)
+	{
+		value.type = JsonValue::Array;
+		expect('[');
+		skipSpace();
+		if (position < text.size() && text[position] == ']')
+		{
+			++position;
+			return;
+		}
+
+		do
+		{
+			value.array.push_back(parseValue());
+			skipSpace();
+		}
+		while (position < text.size() && text[position++] == ',');
+
+		if (text[position - 1] != ']')
+			fail("unterminated array");
+	}
+
+	std::string parseString()
+	{
+		if (position >= text.size() || text[position] != '"')
+			fail("expected string");
+		++position;
+
+		std::string result;
+		while (position < text.size() && text[position] != '"')
+		{
+			char c = text[position++];
+			if (c != '\\')
+			{
+				result += c;
+				continue;
+			}
+			if (position >= text.size())
+				break;
+
+			char escaped = text[position++];
+			switch (escaped)
+			{
+			case 'n':
+				result += '\n';
+				break;
+			case 't':
+				result += '\t';
+				break;
+			case 'r':
+				result += '\r';
+				break;
+			case 'b':
+				result += '\b';
+				break;
+			case 'f':
+				result += '\f';
+				break;
+			case 'u':
+				// Only ASCII is produced by this project, other code points are replaced.
+				if (position + 4 > text.size())
+					fail("invalid escape");
+				{
+					long code = strtol(text.substr(position, 4).c_str(), NULL, 16);
+					result += code < 0x80 ? (char)code : '?';
+				}
+				position += 4;
+				break;
+			default:
+				result += escaped;
+			}
+		}
+		if (position >= text.size())
+			fail("unterminated string");
+		++position;
+
+		return result;
+	}
+
+	void parseNumber(JsonValue& value)
+	{
+		const char* start = text.c_str() + position;
+		char* end;
+
+		value.type = JsonValue::Number;
+		value.number = strtod(start, &end);
+		if (end == start)
+			fail("unexpected character");
+		position += end - start;
+	}
+};
+
+}
+
+const JsonValue* JsonValue::find(const std::string& key) const
+{
+	for (const std::pair<std::string, JsonValue>& member : object)
+	{
+		if (member.first == key)
+			return &member.second;
+	}
+	return NULL;
+}
+
+double JsonValue::numberOr(const std::string& key, double fallback) const
+{
+	const JsonValue* member = find(key);
+
+	return member != NULL && member->type == Number ? member->number : fallback;
+}
+
+std::string JsonValue::stringOr(const std::string& key) const
+{
+	const JsonValue* member = find(key);
+
+	return member != NULL && member->type == String ? member->string : std::string();
+}
+
+JsonValue JsonValue::parse(const std::string& text)
+{
+	return Parser(text).parseDocument();
+}
+
+JsonValue JsonValue::parseFile(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file)
+		throw std::runtime_error("Can't read " + path);
+
+	std::stringstream content;
+	content << file.rdbuf();
+
+	return parse(content.str());
+}
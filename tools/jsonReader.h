@@ -0,0 +1,60 @@
+#ifndef _JSON_READER_H
+#define _JSON_READER_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+//! \brief A parsed JSON value, just enough to read the files produced by this project.
+class JsonValue
+{
+public:
+	//! \brief The value type.
+	enum Type
+	{
+		Null,
+		Bool,
+		Number,
+		String,
+		Array,
+		Object
+	};
+
+	//! \brief The value type.
+	Type type = Null;
+
+	//! \brief The value of a Bool.
+	bool boolean = false;
+
+	//! \brief The value of a Number.
+	double number = 0;
+
+	//! \brief The value of a String.
+	std::string string;
+
+	//! \brief The items of an Array.
+	std::vector<JsonValue> array;
+
+	//! \brief The members of an Object in file order.
+	std::vector<std::pair<std::string, JsonValue>> object;
+
+	//! \brief Finds an Object member.
+	//! \return Returns the member or NULL if there's no such member or this isn't an Object.
+	const JsonValue* find(const std::string& key) const;
+
+	//! \brief Returns a Number member, or the fallback if it's missing.
+	double numberOr(const std::string& key, double fallback) const;
+
+	//! \brief Returns a String member, or an empty string if it's missing.
+	std::string stringOr(const std::string& key) const;
+
+	//! \brief Parses a JSON text.
+	//! \throw std::runtime_error If the text isn't valid JSON.
+	static JsonValue parse(const std::string& text);
+
+	//! \brief Reads and parses a JSON file.
+	//! \throw std::runtime_error If the file can't be read or isn't valid JSON.
+	static JsonValue parseFile(const std::string& path);
+};
+
+#endif